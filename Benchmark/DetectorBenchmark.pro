@@ -0,0 +1,20 @@
+QT = core network sql
+
+TARGET = DetectorBenchmark
+TEMPLATE = app
+
+CONFIG += c++20 cmdline
+CONFIG += static
+
+VERSION = 0.2
+
+HEADERS += \
+    $$PWD/Src/detectorbenchmark.h
+
+SOURCES += \
+    $$PWD/Src/detectorbenchmark.cpp \
+    $$PWD/Src/main.cpp
+
+#inlude addition library
+include($$PWD/../../../Common/Common/Common.pri)
+include($$PWD/../../TradingCatCommon/TradingCatCommon.pri)
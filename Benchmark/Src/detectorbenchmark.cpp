@@ -0,0 +1,300 @@
+//STL
+#include <algorithm>
+
+//Qt
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+#include <QRandomGenerator>
+
+//My
+#include <TradingCatCommon/tradingdata.h>
+#include <TradingCatCommon/detector.h>
+
+#include "detectorbenchmark.h"
+
+using namespace TradingCatCommon;
+
+static const qint64 KLINE_INTERVAL = 60 * 1000;
+static const qint64 START_TIME = 1700000000000;
+
+DetectorBenchmark::DetectorBenchmark(const Config& config, QObject* parent /* = nullptr */)
+    : QObject{parent}
+    , _config(config)
+    , _stockExchangeId("BENCHMARK")
+    , _klinesIdList(std::make_shared<KLinesIDList>())
+{
+    qRegisterMetaType<TradingCatCommon::StockExchangeID>("TradingCatCommon::StockExchangeID");
+    qRegisterMetaType<TradingCatCommon::PKLinesList>("TradingCatCommon::PKLinesList");
+    qRegisterMetaType<TradingCatCommon::UserConfig>("TradingCatCommon::UserConfig");
+
+    if (_config.inputFileName.isEmpty())
+    {
+        makeSyntheticBatches();
+    }
+    else
+    {
+        loadBatches();
+    }
+}
+
+DetectorBenchmark::Result DetectorBenchmark::run()
+{
+    Result result;
+
+    if (isError())
+    {
+        return result;
+    }
+
+    StockExchangesIDList stockExchangesIdList;
+    stockExchangesIdList.emplace(_stockExchangeId);
+
+    TradingData tradingData(stockExchangesIdList);
+    Detector detector(tradingData);
+
+    QObject::connect(&detector, &Detector::klineDetect, this,
+        [this](qint64 sessionId, const TradingCatCommon::Detector::PKLineDetectData& detectData)
+        {
+            Q_UNUSED(sessionId);
+            Q_UNUSED(detectData);
+
+            ++_detects;
+        }, Qt::DirectConnection);
+
+    tradingData.start();
+    tradingData.getKLinesID(_stockExchangeId, _klinesIdList);
+    QCoreApplication::processEvents();
+
+    detector.start();
+
+    for (quint32 sessionId = 1; sessionId <= _config.sessions; ++sessionId)
+    {
+        const UserConfig userConfig(_config.filters.at((sessionId - 1) % _config.filters.size()));
+        if (userConfig.isError())
+        {
+            _errorString = QString("Incorrect user config: %1").arg(userConfig.errorString());
+
+            return result;
+        }
+
+        detector.userOnline(sessionId, userConfig);
+    }
+
+    std::vector<qint64> latencies;
+    latencies.reserve(_batches.size());
+
+    QElapsedTimer totalTimer;
+    QElapsedTimer batchTimer;
+    for (qsizetype batchIndex = 0; batchIndex < static_cast<qsizetype>(_batches.size()); ++batchIndex)
+    {
+        const auto& batch = _batches[batchIndex];
+        const bool isWarmup = batchIndex < _config.warmupBatches;
+
+        if (batchIndex == _config.warmupBatches)
+        {
+            _detects = 0;
+            totalTimer.start();
+        }
+
+        batchTimer.start();
+
+        tradingData.addKLines(_stockExchangeId, batch);
+        detector.addKLines(_stockExchangeId, batch);
+        QCoreApplication::processEvents();
+
+        const auto elapsed = batchTimer.nsecsElapsed();
+
+        if (!isWarmup)
+        {
+            latencies.push_back(elapsed);
+            result.klines += batch->size();
+        }
+    }
+
+    result.totalNsecs = totalTimer.isValid() ? totalTimer.nsecsElapsed() : 0;
+    result.batches = latencies.size();
+    result.detects = _detects;
+
+    for (quint32 sessionId = 1; sessionId <= _config.sessions; ++sessionId)
+    {
+        detector.userOffline(sessionId);
+    }
+
+    detector.stop();
+    tradingData.stop();
+
+    if (latencies.empty())
+    {
+        return result;
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+
+    result.p50Nsecs = latencies[latencies.size() / 2];
+    result.p99Nsecs = latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)];
+    result.maxNsecs = latencies.back();
+
+    return result;
+}
+
+void DetectorBenchmark::makeSyntheticBatches()
+{
+    Q_ASSERT(_config.symbols > 0);
+
+    auto random = QRandomGenerator(static_cast<quint32>(_config.symbols * 31 + _config.batches));
+
+    std::vector<double> prices(_config.symbols, 100.0);
+
+    for (quint32 symbolIndex = 0; symbolIndex < _config.symbols; ++symbolIndex)
+    {
+        _klinesIdList->emplace(QString("SYM%1USDT").arg(symbolIndex), KLineType::MIN1);
+    }
+
+    const auto batchesCount = _config.warmupBatches + _config.batches;
+    _batches.reserve(batchesCount);
+
+    for (quint32 batchIndex = 0; batchIndex < batchesCount; ++batchIndex)
+    {
+        auto batch = std::make_shared<KLinesList>();
+
+        const auto openTime = START_TIME + static_cast<qint64>(batchIndex) * KLINE_INTERVAL;
+
+        quint32 symbolIndex = 0;
+        for (const auto& klineId: *_klinesIdList)
+        {
+            auto& price = prices[symbolIndex++];
+
+            auto change = (random.generateDouble() - 0.5) * 0.002;
+            if (random.generateDouble() < _config.spikeProbability)
+            {
+                change *= 500.0;
+            }
+
+            auto kline = std::make_shared<KLine>();
+            kline->id = klineId;
+            kline->openTime = openTime;
+            kline->closeTime = openTime + KLINE_INTERVAL - 1;
+            kline->open = price;
+            kline->close = price * (1.0 + change);
+            kline->high = std::max(kline->open, kline->close) * (1.0 + random.generateDouble() * 0.0005);
+            kline->low = std::min(kline->open, kline->close) * (1.0 - random.generateDouble() * 0.0005);
+            kline->volume = 1000.0 + random.generateDouble() * 1000.0;
+            kline->quoteAssetVolume = kline->volume * kline->close;
+
+            price = kline->close;
+
+            batch->push_back(std::move(kline));
+        }
+
+        _batches.emplace_back(std::move(batch));
+    }
+}
+
+void DetectorBenchmark::loadBatches()
+{
+    // Формат строки: symbol,interval,openTime,open,high,low,close,volume,quoteAssetVolume
+    QFile file(_config.inputFileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        _errorString = QString("Cannot open input file %1: %2").arg(_config.inputFileName).arg(file.errorString());
+
+        return;
+    }
+
+    QTextStream stream(&file);
+
+    PKLinesList batch;
+    qint64 batchOpenTime = 0;
+    quint64 lineNumber = 0;
+
+    while (!stream.atEnd())
+    {
+        const auto line = stream.readLine().trimmed();
+        ++lineNumber;
+
+        if (line.isEmpty() || line.startsWith('#'))
+        {
+            continue;
+        }
+
+        const auto fields = line.split(',');
+        const auto klineTypes = fields.size() >= 9 ? stringToKLineTypes(fields[1]) : KLineTypes();
+        if (klineTypes.empty())
+        {
+            _errorString = QString("Incorrect line %1 in file %2").arg(lineNumber).arg(_config.inputFileName);
+
+            return;
+        }
+
+        auto kline = std::make_shared<KLine>();
+        kline->id = KLineID(fields[0], *klineTypes.begin());
+        kline->openTime = fields[2].toLongLong();
+        kline->open = fields[3].toDouble();
+        kline->high = fields[4].toDouble();
+        kline->low = fields[5].toDouble();
+        kline->close = fields[6].toDouble();
+        kline->volume = fields[7].toDouble();
+        kline->quoteAssetVolume = fields[8].toDouble();
+        kline->closeTime = kline->openTime + static_cast<qint64>(kline->id.type) - 1;
+
+        _klinesIdList->emplace(kline->id);
+
+        // свечи с одинаковым временем открытия составляют один пакет
+        if (!batch || batchOpenTime != kline->openTime)
+        {
+            if (batch)
+            {
+                _batches.emplace_back(std::move(batch));
+            }
+            batch = std::make_shared<KLinesList>();
+            batchOpenTime = kline->openTime;
+        }
+
+        batch->push_back(std::move(kline));
+    }
+
+    if (batch)
+    {
+        _batches.emplace_back(std::move(batch));
+    }
+
+    if (_batches.empty())
+    {
+        _errorString = QString("Input file %1 not contains klines").arg(_config.inputFileName);
+
+        return;
+    }
+
+    // прогрев не должен поглощать всю запись - иначе измерять нечего
+    if (_batches.size() <= _config.warmupBatches)
+    {
+        _errorString = QString("Input file %1 contains %2 batches, which is not more than the number of warm-up batches %3")
+                           .arg(_config.inputFileName)
+                           .arg(_batches.size())
+                           .arg(_config.warmupBatches);
+
+        return;
+    }
+
+    // измеряется не больше batches пакетов после прогрева
+    const auto batchesCount = static_cast<size_t>(_config.warmupBatches) + _config.batches;
+    if (_batches.size() > batchesCount)
+    {
+        _batches.resize(batchesCount);
+    }
+}
+
+QString DetectorBenchmark::errorString()
+{
+    auto res = _errorString;
+    _errorString.clear();
+
+    return res;
+}
+
+bool DetectorBenchmark::isError() const
+{
+    return !_errorString.isEmpty();
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+//STL
+#include <vector>
+
+//Qt
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+//My
+#include <TradingCatCommon/stockexchange.h>
+#include <TradingCatCommon/kline.h>
+#include <TradingCatCommon/userconfig.h>
+
+///////////////////////////////////////////////////////////////////////////////
+///     The DetectorBenchmark class - прогон записанных или синтетических пакетов
+///         свечей через TradingCatCommon::Detector с максимальной скоростью
+///
+class DetectorBenchmark final
+    : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Config
+    {
+        quint32 symbols = 1000;            ///< количество синтетических инструментов
+        quint32 sessions = 100;            ///< количество имитируемых пользователей
+        quint32 batches = 1000;            ///< количество измеряемых пакетов. Для CSV файла - не больше записанных после прогрева
+        quint32 warmupBatches = 60;        ///< количество пакетов для прогрева истории (не измеряются)
+        double spikeProbability = 0.001;   ///< вероятность резкого изменения цены на свече
+        QStringList filters;               ///< конфигурации пользователей (JSON UserConfig), назначаются по кругу
+        QString inputFileName;             ///< CSV файл с записанными свечами. Если пусто - синтетические данные
+    };
+
+    struct Result
+    {
+        quint64 klines = 0;
+        quint64 batches = 0;
+        quint64 detects = 0;
+        qint64 totalNsecs = 0;
+        qint64 p50Nsecs = 0;
+        qint64 p99Nsecs = 0;
+        qint64 maxNsecs = 0;
+    };
+
+public:
+    explicit DetectorBenchmark(const Config& config, QObject* parent = nullptr);
+    ~DetectorBenchmark() override = default;
+
+    /*!
+        Выполняет прогон
+        @return результат измерений
+    */
+    Result run();
+
+    [[nodiscard]] QString errorString();
+    bool isError() const;
+
+private:
+    DetectorBenchmark() = delete;
+    Q_DISABLE_COPY_MOVE(DetectorBenchmark);
+
+    void makeSyntheticBatches();
+    void loadBatches();
+
+private:
+    const Config _config;
+
+    QString _errorString;
+
+    const TradingCatCommon::StockExchangeID _stockExchangeId;
+
+    TradingCatCommon::PKLinesIDList _klinesIdList;
+    std::vector<TradingCatCommon::PKLinesList> _batches;
+
+    quint64 _detects = 0;
+};
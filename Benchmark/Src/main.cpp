@@ -0,0 +1,101 @@
+//Qt
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFileInfo>
+#include <QTextStream>
+
+//My
+#include <Common/common.h>
+
+#include "detectorbenchmark.h"
+
+using namespace Common;
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QFileInfo exeFileInfo(a.applicationFilePath());
+
+    QCoreApplication::setApplicationName(exeFileInfo.baseName());
+    QCoreApplication::setOrganizationName("Cat software development");
+    QCoreApplication::setApplicationVersion(QString("Version:0.2 Build: %1 %2").arg(__DATE__).arg(__TIME__));
+
+    //Создаем парсер параметров командной строки
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Replay klines through TradingCatCommon::Detector and measure throughput");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption symbols(QStringList() << "n" << "symbols", "Number of synthetic symbols", "N", "1000");
+    parser.addOption(symbols);
+
+    QCommandLineOption sessions(QStringList() << "s" << "sessions", "Number of simulated user sessions", "M", "100");
+    parser.addOption(sessions);
+
+    QCommandLineOption batches(QStringList() << "b" << "batches", "Number of measured batches. With --input, the maximum number of measured batches read from the file", "Count", "1000");
+    parser.addOption(batches);
+
+    QCommandLineOption warmup(QStringList() << "w" << "warmup", "Number of warm-up batches", "Count", "60");
+    parser.addOption(warmup);
+
+    QCommandLineOption spike(QStringList() << "p" << "spike", "Probability of price spike on synthetic kline", "Probability", "0.001");
+    parser.addOption(spike);
+
+    QCommandLineOption filter(QStringList() << "f" << "filter", "User config JSON. Can be repeated, configs are assigned to sessions round-robin", "JSON");
+    parser.addOption(filter);
+
+    QCommandLineOption input(QStringList() << "i" << "input", "CSV file with recorded klines: symbol,interval,openTime,open,high,low,close,volume,quoteAssetVolume", "FileName");
+    parser.addOption(input);
+
+    //Парсим опции командной строки
+    parser.process(a);
+
+    DetectorBenchmark::Config config;
+    config.symbols = parser.value(symbols).toUInt();
+    config.sessions = parser.value(sessions).toUInt();
+    config.batches = parser.value(batches).toUInt();
+    config.warmupBatches = parser.value(warmup).toUInt();
+    config.spikeProbability = parser.value(spike).toDouble();
+    config.filters = parser.values(filter);
+    config.inputFileName = parser.value(input);
+
+    if (config.filters.isEmpty())
+    {
+        config.filters.push_back(R"({"Filter":{"Filters":[{"Delta":500,"Volume":500}]}})");
+    }
+
+    if (config.symbols == 0 || config.sessions == 0 || config.batches == 0)
+    {
+        qCritical() << "Number of symbols, sessions and batches must be positive";
+
+        return EXIT_CODE::LOAD_CONFIG_ERR;
+    }
+
+    DetectorBenchmark benchmark(config);
+    const auto result = benchmark.run();
+    if (benchmark.isError())
+    {
+        qCritical() << benchmark.errorString();
+
+        return EXIT_CODE::SERVICE_INIT_ERR;
+    }
+
+    const double totalSecs = static_cast<double>(result.totalNsecs) / 1e9;
+
+    QTextStream out(stdout);
+    out << QString("Sessions: %1 Batches: %2 Klines: %3 Detects: %4 Time: %5 s\n")
+               .arg(config.sessions)
+               .arg(result.batches)
+               .arg(result.klines)
+               .arg(result.detects)
+               .arg(totalSecs, 0, 'f', 3);
+    out << QString("Klines/sec: %1\n").arg(totalSecs > 0.0 ? result.klines / totalSecs : 0.0, 0, 'f', 0);
+    out << QString("Detects/sec: %1\n").arg(totalSecs > 0.0 ? result.detects / totalSecs : 0.0, 0, 'f', 0);
+    out << QString("Batch latency us: p50: %1 p99: %2 max: %3\n")
+               .arg(result.p50Nsecs / 1000)
+               .arg(result.p99Nsecs / 1000)
+               .arg(result.maxNsecs / 1000);
+
+    return EXIT_CODE::OK;
+}
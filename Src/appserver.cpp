@@ -1,3 +1,6 @@
+//STL
+#include <algorithm>
+
 //Qt
 #include <QHttpServerResponse>
 #include <QFileInfo>
@@ -19,14 +22,26 @@
 using namespace TradingCatCommon;
 using namespace Common;
 
+static const qint64 STATUS_UPDATE_INTERVAL = 1000;
+
 AppServer::AppServer(const TradingCatCommon::HTTPServerConfig& serverConfig,
-                     const TradingCatCommon::TradingData& tradingData,
+                     const TradingDataSnapshot& tradingData,
+                     const KLinesStore* klinesStore,
                      UsersCore& usersCore,
+                     const LatencyTracer& latencyTracer,
+                     const StockExchangeMonitor& stockExchangeMonitor,
+                     const TradingCatCommon::StockExchangesIDList& stockExchangesIdList,
+                     const QString& adminToken,
                      QObject* parent /* = nullptr */)
     : QObject{parent}
     , _serverConfig(serverConfig)
     , _tradingData(tradingData)
+    , _klinesStore(klinesStore)
     , _usersCore(usersCore)
+    , _latencyTracer(latencyTracer)
+    , _stockExchangeMonitor(stockExchangeMonitor)
+    , _stockExchangesIdList(stockExchangesIdList)
+    , _adminToken(adminToken)
 {
 }
 
@@ -44,6 +59,14 @@ void AppServer::start()
         return;
     }
 
+    updateStatus();
+
+    _statusTimer = new QTimer(this);
+
+    connect(_statusTimer, SIGNAL(timeout()), SLOT(statusTimerTimeout()));
+
+    _statusTimer->start(STATUS_UPDATE_INTERVAL);
+
     _isStarted = true;
 }
 
@@ -55,6 +78,10 @@ void AppServer::stop()
 
         return;
     }
+
+    delete _statusTimer;
+    _statusTimer = nullptr;
+
     _httpServer->disconnect();
     _httpServer.reset();
 
@@ -158,7 +185,34 @@ QString AppServer::detectData(const QHttpServerRequest &request)
         return Package(StatusAnswer::ErrorCode::BAD_REQUEST, queryData.errorString()).toJson();
     }
 
-    return _usersCore.detect(queryData);
+    // lazy=1 - история свечей не передается, клиент запрашивает ее по Handle
+    const auto isLazyHistory = query.queryItemValue("lazy") == "1";
+
+    return _usersCore.detect(queryData, isLazyHistory);
+}
+
+QString AppServer::detectHistory(const QHttpServerRequest &request)
+{
+    const auto query = request.query();
+
+    DetectHistoryQuery queryData(query);
+
+    emit sendLogMsg(MSG_CODE::INFORMATION_CODE, QString("%1 GET Request DetectHistory from %2:%3")
+                                                              .arg(queryData.id())
+                                                              .arg(request.remoteAddress().toString())
+                                                              .arg(request.remotePort()));
+
+    if (queryData.isError())
+    {
+        emit sendLogMsg(MSG_CODE::WARNING_CODE, QString("%1 Bad request. Error: %2 Source: %3")
+                            .arg(queryData.id())
+                            .arg(queryData.errorString())
+                            .arg(request.url().toString()));
+
+        return Package(StatusAnswer::ErrorCode::BAD_REQUEST, queryData.errorString()).toJson();
+    }
+
+    return _usersCore.detectHistory(queryData);
 }
 
 QString AppServer::stockExchangesData(const QHttpServerRequest &request)
@@ -209,25 +263,216 @@ QString AppServer::klinesIdList(const QHttpServerRequest &request)
     return _usersCore.klinesIdList(queryData);
 }
 
-QString AppServer::serverStatus(const QHttpServerRequest &request)
+QString AppServer::klinesRange(const QHttpServerRequest &request)
 {
-    ServerStatusQuery queryData(request.query());
+    const auto query = request.query();
+
+    KLinesRangeQuery queryData(query);
+
+    emit sendLogMsg(MSG_CODE::INFORMATION_CODE, QString("%1 GET Request KLinesRange from %2:%3")
+                                                              .arg(queryData.id())
+                                                              .arg(request.remoteAddress().toString())
+                                                              .arg(request.remotePort()));
+
+    if (queryData.isError())
+    {
+        emit sendLogMsg(MSG_CODE::WARNING_CODE, QString("%1 Bad request. Error: %2 Source: %3")
+                            .arg(queryData.id())
+                            .arg(queryData.errorString())
+                            .arg(request.url().toString()));
+
+        return Package(StatusAnswer::ErrorCode::BAD_REQUEST, queryData.errorString()).toJson();
+    }
+
+    if (!_usersCore.isOnline(queryData.sessionId()))
+    {
+        emit sendLogMsg(MSG_CODE::WARNING_CODE, QString("%1 User not login. SessionID: %2. Skip").arg(queryData.id()).arg(queryData.sessionId()));
+
+        return Package(StatusAnswer::ErrorCode::UNAUTHORIZED).toJson();
+    }
+
+    const auto snapshot = _tradingData.snapshot();
+    const auto it_stockExchangeId = std::find_if(snapshot->stockExchangesIdList.begin(), snapshot->stockExchangesIdList.end(),
+        [&queryData](const StockExchangeID& stockExchangeId)
+        {
+            return stockExchangeId.name == queryData.stockExchange();
+        });
+
+    if (it_stockExchangeId == snapshot->stockExchangesIdList.end())
+    {
+        emit sendLogMsg(MSG_CODE::WARNING_CODE, QString("%1 Stock exchange not found: %2").arg(queryData.id()).arg(queryData.stockExchange()));
+
+        return Package(StatusAnswer::ErrorCode::NOT_FOUND, "Stock exchange not found").toJson();
+    }
+
+    if (_klinesStore == nullptr)
+    {
+        emit sendLogMsg(MSG_CODE::WARNING_CODE, QString("%1 KLines store is disabled. Skip").arg(queryData.id()));
+
+        return Package(StatusAnswer::ErrorCode::NOT_FOUND, "KLines store is disabled").toJson();
+    }
+
+    KLinesRangeAnswer::KLineViewsList klines;
+    if (!_klinesStore->readRange(*it_stockExchangeId, queryData.klineId(), queryData.from(), queryData.to(), queryData.limit(), klines))
+    {
+        emit sendLogMsg(MSG_CODE::WARNING_CODE, QString("%1 KLines not found: %2").arg(queryData.id()).arg(queryData.klineId().toString()));
+
+        return Package(StatusAnswer::ErrorCode::NOT_FOUND, "KLines not found").toJson();
+    }
+
+    emit sendLogMsg(MSG_CODE::INFORMATION_CODE, QString("%1 Successfully finished. Send %2 klines").arg(queryData.id()).arg(klines.size()));
+
+    return Package(KLinesRangeAnswer(*it_stockExchangeId, queryData, klines)).toJson();
+}
+
+QHttpServerResponse AppServer::serverStatus(const QHttpServerRequest &request)
+{
+    Q_UNUSED(request);
+
+    // запрос проверки доступности выполняется очень часто - отдаем готовый ответ без записи в лог
+    return QHttpServerResponse("application/json", _statusAnswer);
+}
+
+bool AppServer::checkAdminToken(const QHttpServerRequest &request, qint64 queryId, const QString &token)
+{
+    // сравнение за время, не зависящее от совпадающего префикса ключа
+    const auto adminToken = _adminToken.toUtf8();
+    const auto queryToken = token.toUtf8();
+
+    auto diff = static_cast<unsigned char>(adminToken.size() != queryToken.size());
+    for (qsizetype i = 0; i < adminToken.size(); ++i)
+    {
+        diff |= static_cast<unsigned char>(adminToken[i] ^ (i < queryToken.size() ? queryToken[i] : 0));
+    }
+
+    if (!_adminToken.isEmpty() && diff == 0)
+    {
+        return true;
+    }
+
+    emit sendLogMsg(MSG_CODE::WARNING_CODE, QString("%1 Incorrect admin token from %2").arg(queryId).arg(request.remoteAddress().toString()));
+
+    return false;
+}
+
+QString AppServer::usersOnline(const QHttpServerRequest &request)
+{
+    const auto query = request.query();
+
+    UsersOnlineQuery queryData(query);
+
+    emit sendLogMsg(MSG_CODE::INFORMATION_CODE, QString("%1 GET Request UsersOnline from %2:%3")
+                                                              .arg(queryData.id())
+                                                              .arg(request.remoteAddress().toString())
+                                                              .arg(request.remotePort()));
+
+    if (queryData.isError())
+    {
+        emit sendLogMsg(MSG_CODE::WARNING_CODE, QString("%1 Bad request. Error: %2 Source: %3")
+                            .arg(queryData.id())
+                            .arg(queryData.errorString())
+                            .arg(request.url().toString()));
+
+        return Package(StatusAnswer::ErrorCode::BAD_REQUEST, queryData.errorString()).toJson();
+    }
+
+    if (!checkAdminToken(request, queryData.id(), queryData.token()))
+    {
+        return Package(StatusAnswer::ErrorCode::UNAUTHORIZED).toJson();
+    }
+
+    qsizetype total = 0;
+    const auto users = _usersCore.usersOnline(queryData.offset(), queryData.limit(), total);
 
-    emit sendLogMsg(MSG_CODE::INFORMATION_CODE, QString("%1 GET Request ServerStatus from %2:%3")
-                        .arg(queryData.id())
-                        .arg(request.remoteAddress().toString())
-                        .arg(request.remotePort()));
+    emit sendLogMsg(MSG_CODE::INFORMATION_CODE, QString("%1 Successfully finished. Send %2 of %3 users").arg(queryData.id()).arg(users.size()).arg(total));
 
+    return Package(UsersOnlineAnswer(users, queryData.offset(), total)).toJson();
+}
+
+QString AppServer::latency(const QHttpServerRequest &request)
+{
+    const auto query = request.query();
+
+    LatencyQuery queryData(query);
+
+    emit sendLogMsg(MSG_CODE::INFORMATION_CODE, QString("%1 GET Request Latency from %2:%3")
+                                                              .arg(queryData.id())
+                                                              .arg(request.remoteAddress().toString())
+                                                              .arg(request.remotePort()));
+
+    if (queryData.isError())
+    {
+        emit sendLogMsg(MSG_CODE::WARNING_CODE, QString("%1 Bad request. Error: %2 Source: %3")
+                            .arg(queryData.id())
+                            .arg(queryData.errorString())
+                            .arg(request.url().toString()));
+
+        return Package(StatusAnswer::ErrorCode::BAD_REQUEST, queryData.errorString()).toJson();
+    }
+
+    if (!checkAdminToken(request, queryData.id(), queryData.token()))
+    {
+        return Package(StatusAnswer::ErrorCode::UNAUTHORIZED).toJson();
+    }
+
+    const auto statistic = _latencyTracer.statistic();
+
+    emit sendLogMsg(MSG_CODE::INFORMATION_CODE, QString("%1 Successfully finished. Send latency of %2 stock exchanges").arg(queryData.id()).arg(statistic.size()));
+
+    return Package(LatencyAnswer(statistic)).toJson();
+}
+
+QString AppServer::monitor(const QHttpServerRequest &request)
+{
+    const auto query = request.query();
+
+    MonitorQuery queryData(query);
+
+    emit sendLogMsg(MSG_CODE::INFORMATION_CODE, QString("%1 GET Request Monitor from %2:%3")
+                                                              .arg(queryData.id())
+                                                              .arg(request.remoteAddress().toString())
+                                                              .arg(request.remotePort()));
+
+    if (queryData.isError())
+    {
+        emit sendLogMsg(MSG_CODE::WARNING_CODE, QString("%1 Bad request. Error: %2 Source: %3")
+                            .arg(queryData.id())
+                            .arg(queryData.errorString())
+                            .arg(request.url().toString()));
+
+        return Package(StatusAnswer::ErrorCode::BAD_REQUEST, queryData.errorString()).toJson();
+    }
+
+    if (!checkAdminToken(request, queryData.id(), queryData.token()))
+    {
+        return Package(StatusAnswer::ErrorCode::UNAUTHORIZED).toJson();
+    }
+
+    const auto countersList = _stockExchangeMonitor.counters();
+
+    emit sendLogMsg(MSG_CODE::INFORMATION_CODE, QString("%1 Successfully finished. Send counters of %2 stock exchanges").arg(queryData.id()).arg(countersList.size()));
+
+    return Package(MonitorAnswer(countersList)).toJson();
+}
+
+void AppServer::statusTimerTimeout()
+{
+    updateStatus();
+}
+
+void AppServer::updateStatus()
+{
     const auto currDateTime = QDateTime::currentDateTime();
+    const auto snapshot = _tradingData.snapshot();
     const auto appName = QString("%1 (Total money: %2)")
                              .arg(_serverConfig.name.isEmpty() ? QCoreApplication::applicationName() : _serverConfig.name)
-                             .arg(_tradingData.moneyCount());
-
-    ServerStatusAnswer statusJson(appName, QCoreApplication::applicationVersion(), currDateTime, _startDateTime.secsTo(currDateTime), _usersCore.usersOnline());
+                             .arg(snapshot->moneyCount);
 
-    emit sendLogMsg(MSG_CODE::INFORMATION_CODE, QString("%1 Successfully finished. Send answer").arg(queryData.id()));
+    // в /status только количество пользователей онлайн, список доступен через UsersOnlineQuery
+    ServerStatusAnswer statusJson(appName, QCoreApplication::applicationVersion(), currDateTime, _startDateTime.secsTo(currDateTime), QStringList());
 
-    return Package(statusJson).toJson();
+    // сервер запускается до получения списков ID свечей всех бирж - клиенты видят, какие биржи уже готовы
+    _statusAnswer = Package(ReadinessStatusAnswer(statusJson, _usersCore.usersOnlineCount(), _stockExchangesIdList, snapshot->readyStockExchangesIdList)).toJson().toUtf8();
 }
 
 bool AppServer::makeServer()
@@ -284,6 +529,18 @@ bool AppServer::makeServer()
                                return QString();
                            });
 
+        _httpServer->route(DetectHistoryQuery::path(), QHttpServerRequest::Method::Get,
+                           [this](const QHttpServerRequest &request)
+                           {
+                               return detectHistory(request);
+                           });
+
+        _httpServer->route(DetectHistoryQuery::path(), QHttpServerRequest::Method::Options,
+                           []()
+                           {
+                               return QString();
+                           });
+
         _httpServer->route(StockExchangesQuery().path(), QHttpServerRequest::Method::Get,
                            [this](const QHttpServerRequest &request)
                            {   
@@ -308,6 +565,18 @@ bool AppServer::makeServer()
                                return QString();
                            });
 
+        _httpServer->route(KLinesRangeQuery::path(), QHttpServerRequest::Method::Get,
+                           [this](const QHttpServerRequest &request)
+                           {
+                               return klinesRange(request);
+                           });
+
+        _httpServer->route(KLinesRangeQuery::path(), QHttpServerRequest::Method::Options,
+                           []()
+                           {
+                               return QString();
+                           });
+
         _httpServer->route(ServerStatusQuery().path(), QHttpServerRequest::Method::Get,
                            [this](const QHttpServerRequest &request)
                            {
@@ -320,6 +589,42 @@ bool AppServer::makeServer()
                                return QString();
                            });
 
+        _httpServer->route(UsersOnlineQuery::path(), QHttpServerRequest::Method::Get,
+                           [this](const QHttpServerRequest &request)
+                           {
+                               return usersOnline(request);
+                           });
+
+        _httpServer->route(UsersOnlineQuery::path(), QHttpServerRequest::Method::Options,
+                           []()
+                           {
+                               return QString();
+                           });
+
+        _httpServer->route(LatencyQuery::path(), QHttpServerRequest::Method::Get,
+                           [this](const QHttpServerRequest &request)
+                           {
+                               return latency(request);
+                           });
+
+        _httpServer->route(LatencyQuery::path(), QHttpServerRequest::Method::Options,
+                           []()
+                           {
+                               return QString();
+                           });
+
+        _httpServer->route(MonitorQuery::path(), QHttpServerRequest::Method::Get,
+                           [this](const QHttpServerRequest &request)
+                           {
+                               return monitor(request);
+                           });
+
+        _httpServer->route(MonitorQuery::path(), QHttpServerRequest::Method::Options,
+                           []()
+                           {
+                               return QString();
+                           });
+
         _httpServer->setMissingHandler(_httpServer.get(),
             [this](const QHttpServerRequest& req, QHttpServerResponder& resp)
             {
@@ -343,7 +648,7 @@ bool AppServer::makeServer()
 
                 auto h = resp.headers();
                 h.append(QHttpHeaders::WellKnownHeader::Server, _serverConfig.name);
-                h.append(QHttpHeaders::WellKnownHeader::ContentType, "application/json");
+                h.replaceOrAppend(QHttpHeaders::WellKnownHeader::ContentType, "application/json");
 #ifdef QT_DEBUG
                 h.append(QHttpHeaders::WellKnownHeader::ContentLength, QString::number(resp.data().size()));
                 h.append(QHttpHeaders::WellKnownHeader::AccessControlAllowOrigin, "*");
@@ -6,6 +6,7 @@
 //QT
 #include <QObject>
 #include <QHttpServer>
+#include <QHttpServerResponse>
 #include <QSqlDatabase>
 #include <QJsonArray>
 #include <QHash>
@@ -23,7 +24,11 @@
 #include <TradingCatCommon/kline.h>
 #include <TradingCatCommon/tradingdata.h>
 
+#include "tradingdatasnapshot.h"
+#include "klinesstore.h"
 #include "userscore.h"
+#include "latencytracer.h"
+#include "stockexchangemonitor.h"
 
 class AppServer
     : public QObject
@@ -32,8 +37,13 @@ class AppServer
 
 public:
     explicit AppServer(const TradingCatCommon::HTTPServerConfig& serverConfig,
-                       const TradingCatCommon::TradingData& tradingData,
+                       const TradingDataSnapshot& tradingData,
+                       const KLinesStore* klinesStore,
                        UsersCore& usersCore,
+                       const LatencyTracer& latencyTracer,
+                       const StockExchangeMonitor& stockExchangeMonitor,
+                       const TradingCatCommon::StockExchangesIDList& stockExchangesIdList,
+                       const QString& adminToken,
                        QObject* parent = nullptr);
 
     ~AppServer() override;
@@ -59,29 +69,52 @@ signals:
 
     void finished();
 
+private slots:
+    void statusTimerTimeout();
+
 private:
     AppServer() = delete;
     Q_DISABLE_COPY_MOVE(AppServer);
 
     bool makeServer();
+    void updateStatus();
+
+    /*!
+        Проверка ключа доступа к служебным запросам. Неверный ключ записывается в лог
+        @return true - ключ задан в конфигурации и совпадает
+    */
+    bool checkAdminToken(const QHttpServerRequest &request, qint64 queryId, const QString& token);
 
     //answers
     QString loginUser(const QHttpServerRequest &request);
     QString logoutUser(const QHttpServerRequest &request);
     QString configUser(const QHttpServerRequest &request);
     QString detectData(const QHttpServerRequest &request);
+    QString detectHistory(const QHttpServerRequest &request);
     QString stockExchangesData(const QHttpServerRequest &request);
     QString klinesIdList(const QHttpServerRequest &request);
-    QString serverStatus(const QHttpServerRequest &request);
+    QString klinesRange(const QHttpServerRequest &request);
+    QHttpServerResponse serverStatus(const QHttpServerRequest &request);
+    QString usersOnline(const QHttpServerRequest &request);
+    QString latency(const QHttpServerRequest &request);
+    QString monitor(const QHttpServerRequest &request);
 
 private:
     const TradingCatCommon::HTTPServerConfig& _serverConfig;
-    const TradingCatCommon::TradingData& _tradingData;
+    const TradingDataSnapshot& _tradingData;
+    const KLinesStore* _klinesStore = nullptr; ///< nullptr - хранилище отключено
     UsersCore& _usersCore;
+    const LatencyTracer& _latencyTracer;
+    const StockExchangeMonitor& _stockExchangeMonitor;
+    const TradingCatCommon::StockExchangesIDList _stockExchangesIdList; ///< биржи конфигурации, по ним определяется готовность
+    const QString _adminToken;
 
     std::unique_ptr<QHttpServer> _httpServer;
     std::unique_ptr<QTcpServer> _tcpServer;
 
+    QTimer* _statusTimer = nullptr;
+    QByteArray _statusAnswer;       ///< готовый JSON ответа на /status, обновляется по таймеру
+
     bool _isStarted = false;
     const QDateTime _startDateTime = QDateTime::currentDateTime();
 };
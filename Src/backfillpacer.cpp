@@ -0,0 +1,150 @@
+//STL
+#include <algorithm>
+
+//Qt
+#include <QDateTime>
+
+#include "klinesstore.h"
+#include "backfillpacer.h"
+
+using namespace TradingCatCommon;
+
+BackfillPacer::BackfillPacer(const TradingCatCommon::StockExchangeID& stockExchangeId, qsizetype requestsPerMinute, QObject* parent /* = nullptr */)
+    : QObject{parent}
+    , _stockExchangeId(stockExchangeId)
+    , _dispatchInterval(requestsPerMinute > 0 ? std::max<qint64>(60 * 1000 / requestsPerMinute, 1) : 0)
+{
+    Q_ASSERT(requestsPerMinute >= 0);
+
+    qRegisterMetaType<TradingCatCommon::KLineID>("TradingCatCommon::KLineID");
+}
+
+BackfillPacer::~BackfillPacer()
+{
+    stop();
+}
+
+const TradingCatCommon::StockExchangeID &BackfillPacer::stockExchangeId() const noexcept
+{
+    return _stockExchangeId;
+}
+
+BackfillPacer::Metrics BackfillPacer::metrics() const
+{
+    Metrics result;
+    result.pending = static_cast<qsizetype>(_requests.size());
+    result.sent = _sent;
+    result.merged = _merged;
+
+    return result;
+}
+
+void BackfillPacer::start()
+{
+    Q_ASSERT(!_isStarted);
+
+    _dispatchTimer = new QTimer(this);
+    _dispatchTimer->setSingleShot(true);
+
+    connect(_dispatchTimer, SIGNAL(timeout()), SLOT(dispatchTimerTimeout()));
+
+    _isStarted = true;
+
+    dispatch();
+}
+
+void BackfillPacer::stop()
+{
+    if (!_isStarted)
+    {
+        return;
+    }
+
+    delete _dispatchTimer;
+    _dispatchTimer = nullptr;
+
+    _requests.clear();
+
+    _isStarted = false;
+}
+
+void BackfillPacer::loadKLinesRequest(const TradingCatCommon::KLineID &klineId, qint64 from, qint64 to)
+{
+    Q_ASSERT(from <= to);
+
+    const auto interval = KLinesStore::klineInterval(klineId.type);
+
+    Request request{klineId, from, to};
+    for (auto it_requests = _requests.begin(); it_requests != _requests.end(); )
+    {
+        if (it_requests->klineId != klineId || it_requests->from > request.to + interval || it_requests->to + interval < request.from)
+        {
+            ++it_requests;
+
+            continue;
+        }
+
+        request.from = std::min(request.from, it_requests->from);
+        request.to = std::max(request.to, it_requests->to);
+
+        ++_merged;
+
+        it_requests = _requests.erase(it_requests);
+    }
+
+    _requests.push_back(request);
+
+    dispatch();
+}
+
+void BackfillPacer::dispatchTimerTimeout()
+{
+    if (_requests.empty())
+    {
+        return;
+    }
+
+    const auto currentDateTime = QDateTime::currentMSecsSinceEpoch();
+
+    // свеча закрылась не раньше одного интервала назад
+    const auto isRecent =
+        [currentDateTime](const Request& request)
+        {
+            return request.to + 2 * KLinesStore::klineInterval(request.klineId.type) >= currentDateTime;
+        };
+
+    // первыми - только что закрытые свечи, затем свечи меньшего интервала, среди них - самые свежие пропуски
+    const auto it_request = std::min_element(_requests.begin(), _requests.end(),
+        [&isRecent](const auto& left, const auto& right)
+        {
+            const auto isLeftRecent = isRecent(left);
+            if (isLeftRecent != isRecent(right))
+            {
+                return isLeftRecent;
+            }
+
+            const auto leftInterval = KLinesStore::klineInterval(left.klineId.type);
+            const auto rightInterval = KLinesStore::klineInterval(right.klineId.type);
+
+            return leftInterval != rightInterval ? leftInterval < rightInterval : left.to > right.to;
+        });
+
+    const auto request = *it_request;
+    _requests.erase(it_request);
+
+    ++_sent;
+
+    emit loadKLines(request.klineId, request.from, request.to);
+
+    dispatch();
+}
+
+void BackfillPacer::dispatch()
+{
+    if (!_isStarted || _requests.empty() || _dispatchTimer->isActive())
+    {
+        return;
+    }
+
+    _dispatchTimer->start(_dispatchInterval);
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+//STL
+#include <vector>
+
+//Qt
+#include <QObject>
+#include <QTimer>
+
+//My
+#include <TradingCatCommon/stockexchange.h>
+#include <TradingCatCommon/kline.h>
+
+
+///////////////////////////////////////////////////////////////////////////////
+///     The BackfillPacer class - темп запросов дозагрузки свечей к бирже. Запросы
+///         отправляются равномерно по одному через интервал 60 000 / limit мс, где
+///         limit - доля лимита биржи, отведенная дозагрузке. Пересекающиеся и смежные
+///         диапазоны одной свечи объединяются, несмежные пропуски запрашиваются отдельно.
+///         Первыми отправляются запросы только что закрытых свечей, затем свечей
+///         меньшего интервала и более свежие пропуски. Регулярный опрос бирж ведут
+///         сами реализации IStockExchange со своим темпом, BackfillPacer его не учитывает.
+///         Объект живет в потоке Core
+///
+class BackfillPacer final
+    : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Metrics
+    {
+        qsizetype pending = 0;   ///< запросов в очереди
+        quint64 sent = 0;        ///< отправлено запросов
+        quint64 merged = 0;      ///< запросов, объединенных с уже стоящими в очереди
+    };
+
+public:
+    /*!
+        Конструктор
+        @param stockExchangeId - биржа
+        @param requestsPerMinute - лимит запросов дозагрузки в минуту. 0 - без ограничения
+    */
+    BackfillPacer(const TradingCatCommon::StockExchangeID& stockExchangeId, qsizetype requestsPerMinute, QObject* parent = nullptr);
+    ~BackfillPacer() override;
+
+    const TradingCatCommon::StockExchangeID& stockExchangeId() const noexcept;
+    Metrics metrics() const;
+
+public slots:
+    void start();
+    void stop();
+
+    /*!
+        Ставит в очередь запрос свечей klineId с временем открытия в [from, to]
+    */
+    void loadKLinesRequest(const TradingCatCommon::KLineID& klineId, qint64 from, qint64 to);
+
+signals:
+    void loadKLines(const TradingCatCommon::KLineID& klineId, qint64 from, qint64 to);
+
+private slots:
+    void dispatchTimerTimeout();
+
+private:
+    BackfillPacer() = delete;
+    Q_DISABLE_COPY_MOVE(BackfillPacer);
+
+    struct Request
+    {
+        TradingCatCommon::KLineID klineId;
+        qint64 from = 0;
+        qint64 to = 0;
+    };
+
+    void dispatch();
+
+private:
+    const TradingCatCommon::StockExchangeID _stockExchangeId;
+    const qint64 _dispatchInterval = 0;                ///< мс между запросами. 0 - без ограничения
+
+    QTimer* _dispatchTimer = nullptr;
+
+    std::vector<Request> _requests;                    ///< диапазоны одной свечи не пересекаются и не смежны
+
+    quint64 _sent = 0;
+    quint64 _merged = 0;
+
+    bool _isStarted = false;
+};
@@ -1,394 +1,799 @@
-//Qt
-#include <QSettings>
-#include <QFileInfo>
-#include <QDebug>
-#include <QDir>
-
-//My
-#include <Common/common.h>
-
-//#include <StockExchange/moex.h>
-#include <StockExchange/mexc.h>
-#include <StockExchange/gate.h>
-#include <StockExchange/kucoin.h>
-#include <StockExchange/bybit.h>
-#include <StockExchange/binance.h>
-#include <StockExchange/bitget.h>
-#include <StockExchange/bitmart.h>
-#include <StockExchange/bingx.h>
-#include <StockExchange/okx.h>
-#include <StockExchange/htx.h>
-#include <StockExchange/kucoinfutures.h>
-#include <StockExchange/bitgetfutures.h>
-#include <StockExchange/gatefutures.h>
-#include <StockExchange/bybitfutures.h>
-#include <StockExchange/mexcfutures.h>
-#include <StockExchange/bingxfutures.h>
-#include <StockExchange/bitmartfutures.h>
-#include <StockExchange/lbank.h>
-
-#include "config.h"
-
-using namespace TradingCatCommon;
-using namespace StockExchange;
-using namespace Common;
-
-Q_GLOBAL_STATIC_WITH_ARGS(const QStringList, STOCK_NAME_LIST,
-                          ({ //Moex::STOCK_ID.name,
-                              Mexc::STOCK_ID.name,
-                              Gate::STOCK_ID.name,
-                              Kucoin::STOCK_ID.name,
-                              Bybit::STOCK_ID.name,
-                              Bitget::STOCK_ID.name,
-                              Bitmart::STOCK_ID.name,
-                              Bingx::STOCK_ID.name,
-                              Okx::STOCK_ID.name,
-                              Htx::STOCK_ID.name,
-                              Binance::STOCK_ID.name,
-                              KucoinFutures::STOCK_ID.name,
-                              BitgetFutures::STOCK_ID.name,
-                              BybitFutures::STOCK_ID.name,
-                              GateFutures::STOCK_ID.name,
-                              MexcFutures::STOCK_ID.name,
-                              BingxFutures::STOCK_ID.name,
-                              BitmartFutures::STOCK_ID.name,
-                              LBank::STOCK_ID.name
-                          }));
-
-//static
-static Config* config_ptr = nullptr;
-
-Config* Config::config(const QString& configFileName)
-{
-    if (config_ptr == nullptr)
-    {
-        config_ptr = new Config(configFileName);
-    }
-
-    return config_ptr;
-};
-
-void Config::deleteConfig()
-{
-    Q_CHECK_PTR(config_ptr);
-
-    if (config_ptr != nullptr)
-    {
-        delete config_ptr;
-
-        config_ptr= nullptr;
-    }
-}
-
-//class
-Config::Config(const QString& configFileName) :
-    _configFileName(configFileName)
-{
-    if (_configFileName.isEmpty())
-    {
-        _errorString = "Configuration file name cannot be empty";
-
-        return;
-    }
-    if (!QFileInfo::exists(_configFileName))
-    {
-        _errorString = "Configuration file not exist. File name: " + _configFileName;
-
-        return;
-    }
-
-    qInfo() << QString("%1 %2").arg(QTime::currentTime().toString(SIMPLY_TIME_FORMAT)).arg("Reading configuration from " +  _configFileName);
-
-    QSettings ini(_configFileName, QSettings::IniFormat);
-
-    QStringList groups = ini.childGroups();
-    if (!groups.contains("DATABASE"))
-    {
-        _errorString = "Configuration file not contains [DATABASE] group";
-
-        return;
-    }
-    if (!groups.contains("SERVER"))
-    {
-        _errorString = "Configuration file not contains [SERVER] group";
-
-        return;
-    }
-
-    //Database
-    ini.beginGroup("DATABASE");
-
-    _dbConnectionInfo.driver = ini.value("Driver", "").toString();
-    _dbConnectionInfo.dbName = ini.value("DataBase", "").toString();
-    _dbConnectionInfo.userName = ini.value("UID", "").toString();
-    _dbConnectionInfo.password = ini.value("PWD", "").toString();
-    _dbConnectionInfo.connectOptions = ini.value("ConnectionOptions", "").toString();
-    _dbConnectionInfo.port = ini.value("Port", "").toUInt();
-    _dbConnectionInfo.host = ini.value("Host", "").toString();
-
-    const auto errDataBase = _dbConnectionInfo.check();
-
-    if (!errDataBase.isEmpty())
-    {
-        _errorString = QString("Incorrect value [DATABASE]. Error: %1").arg(errDataBase);
-
-        return;
-    }
-
-    ini.endGroup();
-
-    //SYSTEM
-    ini.beginGroup("SYSTEM");
-
-    _debugMode = ini.value("DebugMode", "0").toBool();
-    _logTableName = ini.value("LogTableName", "").toString();
-
-    ini.endGroup();
-
-    //SERVER
-    ini.beginGroup("SERVER");
-
-    const auto address_str =ini.value("Address", QHostAddress::LocalHost).toString();
-    _httpServerConfig.address = QHostAddress(address_str);
-    if (_httpServerConfig.address.isNull())
-    {
-        _errorString = QString("Invalid value in [SERVER]/Address. Value: %1").arg(address_str);
-
-        return;
-    }
-    _httpServerConfig.port = ini.value("Port", 80).toUInt();
-    if (_httpServerConfig.port == 0)
-    {
-        _errorString = QString("Value in [SERVER]/Port must be number");
-
-        return;
-    }
-    _httpServerConfig.maxUsers = ini.value("MaxUsers", 100).toUInt();
-    if (_httpServerConfig.maxUsers == 0)
-    {
-        _errorString = QString("Value in [SERVER]/MaxUsers must be number");
-
-        return;
-    }
-    _httpServerConfig.rootDir = ini.value("RootDir", QCoreApplication::applicationDirPath()).toString();
-    _httpServerConfig.name = ini.value("Name", "").toString();
-
-    ini.endGroup();
-
-    //PROXY_N
-    for (quint8 currentProxyIndex = 0; currentProxyIndex < std::numeric_limits<quint8>().max(); ++currentProxyIndex)
-    {
-        const auto group =  QString("PROXY_%1").arg(currentProxyIndex);
-        if (groups.contains(group))
-        {
-            ini.beginGroup(group);
-
-            TradingCatCommon::ProxyData tmp;
-            tmp.address = QHostAddress(ini.value("Host", "").toString());
-            if (tmp.address.isNull())
-            {
-                _errorString = QString("Value in [%1]/Host is not valid").arg(group);
-
-                return;
-            }
-
-            bool ok = false;
-            tmp.port = ini.value("Port", 51888).toUInt(&ok);
-            if (tmp.port == 0)
-            {
-                _errorString = QString("Value in [%1]/Port must be number").arg(group);
-
-                return;
-            }
-
-            tmp.user = ini.value("User").toString();
-            tmp.password = ini.value("Password").toString();
-
-            ini.endGroup();
-
-            _proxyDataList.emplace_back(std::move(tmp));
-        }
-    }
-
-    //STOCK_EXCHANGE_N
-    for (quint8 currentStockExchangeIndex = 0; currentStockExchangeIndex < std::numeric_limits<quint8>().max(); ++currentStockExchangeIndex)
-    {
-        const auto group = QString("STOCK_EXCHANGE_%1").arg(currentStockExchangeIndex);
-        if (groups.contains(group))
-        {
-            ini.beginGroup(group);
-
-            StockExchangeConfig tmp;
-
-            tmp.type = ini.value("Type", "").toString();
-            if (tmp.type.isEmpty() || !STOCK_NAME_LIST->contains(tmp.type))
-            {
-                _errorString = QString("Value in [%1]/Type cannot by empty or undefined or incorrect. Support: %2").arg(group).arg(STOCK_NAME_LIST->join(','));
-
-                return;
-            }
-
-            tmp.user = ini.value("User", "").toString();
-            tmp.password = ini.value("Password", "").toString();
-
-            tmp.klineTypes = stringToKLineTypes(ini.value("KLineTypes", "1m").toString());
-            if (tmp.klineTypes.empty())
-            {
-                _errorString = QString("Value in [%1]/KLineTypes cannot by empty or undefined or incorrect").arg(group);
-
-                return;
-            }
-
-            tmp.klineNames = ini.value("KLineNames").toString().split(',');
-            if (tmp.klineNames.first().isEmpty())
-            {
-                tmp.klineNames.clear();
-            }
-
-            ini.endGroup();
-
-            _stockExchangeConfigList.emplace_back(std::move(tmp));
-        }
-    }
-
-    if (_stockExchangeConfigList.empty())
-    {
-        _errorString = QString("There are no stock exchanges in the configuration. Check [STOCK_EXCHANGE_0] group");
-
-        return;
-    }
-}
-
-const DBConnectionInfo &Config::dbConnectionInfo() const noexcept
-{
-    return _dbConnectionInfo;
-}
-
-bool Config::debugMode() const noexcept
-{
-    return _debugMode;
-}
-
-const QString& Config::logTableName() const noexcept
-{
-    return _logTableName;
-}
-
-const HTTPServerConfig &Config::httpServerConfig() const noexcept
-{
-    return _httpServerConfig;
-}
-
-void Config::makeConfig(const QString& configFileName)
-{
-    if (configFileName.isEmpty())
-    {
-        qWarning() << "Configuration file name cannot be empty";
-
-        return;
-    }
-
-    QSettings ini(configFileName, QSettings::IniFormat);
-
-    if (!ini.isWritable())
-    {
-        qWarning() << QString("Can not write configuration file: %1").arg(configFileName);
-
-        return;
-    }
-
-    ini.clear();
-
-    //Database
-    ini.beginGroup("DATABASE");
-
-    ini.remove("");
-
-    ini.setValue("Driver", "QMYSQL");
-    ini.setValue("DataBase", "TradingCat");
-    ini.setValue("UID", "user");
-    ini.setValue("PWD", "password");
-    ini.setValue("ConnectionOptions", "");
-    ini.setValue("Port", "3306");
-    ini.setValue("Host", "localhost");
-
-    ini.endGroup();
-
-    //System
-    ini.beginGroup("SYSTEM");
-
-    ini.remove("");
-
-    ini.setValue("DebugMode", true);
-    ini.setValue("LogTableName", QString("%1Log").arg(QCoreApplication::applicationName()));
-
-    ini.endGroup();
-
-    //SERVER
-    ini.beginGroup("SERVER");
-
-    ini.remove("");
-
-    ini.setValue("Address", QHostAddress::LocalHost);
-    ini.setValue("Port", 80);
-    ini.setValue("RootDir", QCoreApplication::applicationDirPath());
-    ini.setValue("CRTFileName", "");
-    ini.setValue("KEYFileName", "");
-    ini.setValue("Name", "MyServer");
-
-    ini.endGroup();
-
-    //PROXY
-    ini.beginGroup("PROXY_0");
-
-    ini.remove("");
-
-    ini.setValue("Host", "localhost");
-    ini.setValue("Port", "1234");
-    ini.setValue("User", "user");
-    ini.setValue("Password", "password");
-
-    ini.endGroup();
-
-    //PROXY
-    ini.beginGroup("STOCK_EXCHANGE_0");
-
-    ini.remove("");
-
-    ini.setValue("Type", STOCK_NAME_LIST->join(','));
-    ini.setValue("User", "user");
-    ini.setValue("Password", "password");
-    ini.setValue("KLineTypes", "1m,5m,10m,1h,1w,1d");
-    ini.setValue("KLineNames", "");
-
-    ini.endGroup();
-
-    //сбрасываем буфер
-    ini.sync();
-
-    qInfo() << QString("Save configuration to %1").arg(configFileName);
-}
-
-const TradingCatCommon::ProxyDataList& Config::proxyDataList() const noexcept
-{
-    return _proxyDataList;
-}
-
-QString Config::errorString()
-{
-    auto res = _errorString;
-    _errorString.clear();
-
-    return res;
-}
-
-
-bool Config::isError() const
-{
-    return !_errorString.isEmpty();
-}
-
-const StockExchangeConfigList &Config::stockExchangeConfigList() const noexcept
-{
-    return _stockExchangeConfigList;
-}
+//Qt
+#include <QSettings>
+#include <QFileInfo>
+#include <QDebug>
+#include <QDir>
+#include <QThread>
+
+//My
+#include <Common/common.h>
+
+//#include <StockExchange/moex.h>
+#include <StockExchange/mexc.h>
+#include <StockExchange/gate.h>
+#include <StockExchange/kucoin.h>
+#include <StockExchange/bybit.h>
+#include <StockExchange/binance.h>
+#include <StockExchange/bitget.h>
+#include <StockExchange/bitmart.h>
+#include <StockExchange/bingx.h>
+#include <StockExchange/okx.h>
+#include <StockExchange/htx.h>
+#include <StockExchange/kucoinfutures.h>
+#include <StockExchange/bitgetfutures.h>
+#include <StockExchange/gatefutures.h>
+#include <StockExchange/bybitfutures.h>
+#include <StockExchange/mexcfutures.h>
+#include <StockExchange/bingxfutures.h>
+#include <StockExchange/bitmartfutures.h>
+#include <StockExchange/lbank.h>
+
+#include "klinesrecorder.h"
+
+#include "config.h"
+
+using namespace TradingCatCommon;
+using namespace StockExchange;
+using namespace Common;
+
+Q_GLOBAL_STATIC_WITH_ARGS(const QStringList, STOCK_NAME_LIST,
+                          ({ //Moex::STOCK_ID.name,
+                              Mexc::STOCK_ID.name,
+                              Gate::STOCK_ID.name,
+                              Kucoin::STOCK_ID.name,
+                              Bybit::STOCK_ID.name,
+                              Bitget::STOCK_ID.name,
+                              Bitmart::STOCK_ID.name,
+                              Bingx::STOCK_ID.name,
+                              Okx::STOCK_ID.name,
+                              Htx::STOCK_ID.name,
+                              Binance::STOCK_ID.name,
+                              KucoinFutures::STOCK_ID.name,
+                              BitgetFutures::STOCK_ID.name,
+                              BybitFutures::STOCK_ID.name,
+                              GateFutures::STOCK_ID.name,
+                              MexcFutures::STOCK_ID.name,
+                              BingxFutures::STOCK_ID.name,
+                              BitmartFutures::STOCK_ID.name,
+                              LBank::STOCK_ID.name
+                          }));
+
+Q_GLOBAL_STATIC_WITH_ARGS(const QString, REPLAY_TYPE, ("Replay"));
+
+static const QMetaObject* stockExchangeMetaObject(const QString& stockExchangeType)
+{
+    // Spot
+    //if (stockExchangeType == Moex::STOCK_ID.name)
+    //{
+    //    return &Moex::staticMetaObject;
+    //}
+    //else
+    if (stockExchangeType == Mexc::STOCK_ID.name)
+    {
+        return &Mexc::staticMetaObject;
+    }
+    else if (stockExchangeType == Gate::STOCK_ID.name)
+    {
+        return &Gate::staticMetaObject;
+    }
+    else if (stockExchangeType == Kucoin::STOCK_ID.name)
+    {
+        return &Kucoin::staticMetaObject;
+    }
+    else if (stockExchangeType == Bybit::STOCK_ID.name)
+    {
+        return &Bybit::staticMetaObject;
+    }
+    else if (stockExchangeType == Binance::STOCK_ID.name)
+    {
+        return &Binance::staticMetaObject;
+    }
+    else if (stockExchangeType == Bitget::STOCK_ID.name)
+    {
+        return &Bitget::staticMetaObject;
+    }
+    else if (stockExchangeType == Bitmart::STOCK_ID.name)
+    {
+        return &Bitmart::staticMetaObject;
+    }
+    else if (stockExchangeType == Bingx::STOCK_ID.name)
+    {
+        return &Bingx::staticMetaObject;
+    }
+    else if (stockExchangeType == Okx::STOCK_ID.name)
+    {
+        return &Okx::staticMetaObject;
+    }
+    else if (stockExchangeType == Htx::STOCK_ID.name)
+    {
+        return &Htx::staticMetaObject;
+    }
+    else if (stockExchangeType == LBank::STOCK_ID.name)
+    {
+        return &LBank::staticMetaObject;
+    }
+
+    // Futures
+    else if (stockExchangeType == KucoinFutures::STOCK_ID.name)
+    {
+        return &KucoinFutures::staticMetaObject;
+    }
+    else if (stockExchangeType == BitgetFutures::STOCK_ID.name)
+    {
+        return &BitgetFutures::staticMetaObject;
+    }
+    else if (stockExchangeType == GateFutures::STOCK_ID.name)
+    {
+        return &GateFutures::staticMetaObject;
+    }
+    else if (stockExchangeType == BybitFutures::STOCK_ID.name)
+    {
+        return &BybitFutures::staticMetaObject;
+    }
+    else if (stockExchangeType == MexcFutures::STOCK_ID.name)
+    {
+        return &MexcFutures::staticMetaObject;
+    }
+    else if (stockExchangeType == BingxFutures::STOCK_ID.name)
+    {
+        return &BingxFutures::staticMetaObject;
+    }
+    else if (stockExchangeType == BitmartFutures::STOCK_ID.name)
+    {
+        return &BitmartFutures::staticMetaObject;
+    }
+
+    return nullptr;
+}
+
+static const qsizetype DEFAULT_BACKFILL_REQUESTS_PER_MINUTE = 60; // для бирж без известного лимита
+
+/*!
+    Запросов дозагрузки в минуту по умолчанию - около десятой части публичного лимита REST
+        биржи на запрос свечей. Остальное остается регулярному опросу коннектора
+*/
+static qsizetype defaultBackfillRequestsPerMinute(const QString& stockExchangeType)
+{
+    static const QHash<QString, qsizetype> requestsPerMinute =
+        {
+            // Spot
+            {Binance::STOCK_ID.name, 300},
+            {Bybit::STOCK_ID.name, 300},
+            {Mexc::STOCK_ID.name, 300},
+            {Okx::STOCK_ID.name, 120},
+            {Gate::STOCK_ID.name, 120},
+            {Kucoin::STOCK_ID.name, 120},
+            {Bitget::STOCK_ID.name, 120},
+            {Htx::STOCK_ID.name, 120},
+            {LBank::STOCK_ID.name, 120},
+            {Bingx::STOCK_ID.name, 60},
+            {Bitmart::STOCK_ID.name, 30},
+
+            // Futures
+            {BybitFutures::STOCK_ID.name, 300},
+            {KucoinFutures::STOCK_ID.name, 120},
+            {BitgetFutures::STOCK_ID.name, 120},
+            {GateFutures::STOCK_ID.name, 120},
+            {MexcFutures::STOCK_ID.name, 60},
+            {BingxFutures::STOCK_ID.name, 60},
+            {BitmartFutures::STOCK_ID.name, 30}
+        };
+
+    return requestsPerMinute.value(stockExchangeType, DEFAULT_BACKFILL_REQUESTS_PER_MINUTE);
+}
+
+//static
+static Config* config_ptr = nullptr;
+
+Config* Config::config(const QString& configFileName)
+{
+    if (config_ptr == nullptr)
+    {
+        config_ptr = new Config(configFileName);
+    }
+
+    return config_ptr;
+};
+
+void Config::deleteConfig()
+{
+    Q_CHECK_PTR(config_ptr);
+
+    if (config_ptr != nullptr)
+    {
+        delete config_ptr;
+
+        config_ptr= nullptr;
+    }
+}
+
+//class
+Config::Config(const QString& configFileName) :
+    _configFileName(configFileName)
+{
+    if (_configFileName.isEmpty())
+    {
+        _errorString = "Configuration file name cannot be empty";
+
+        return;
+    }
+    if (!QFileInfo::exists(_configFileName))
+    {
+        _errorString = "Configuration file not exist. File name: " + _configFileName;
+
+        return;
+    }
+
+    qInfo() << QString("%1 %2").arg(QTime::currentTime().toString(SIMPLY_TIME_FORMAT)).arg("Reading configuration from " +  _configFileName);
+
+    QSettings ini(_configFileName, QSettings::IniFormat);
+
+    QStringList groups = ini.childGroups();
+    if (!groups.contains("DATABASE"))
+    {
+        _errorString = "Configuration file not contains [DATABASE] group";
+
+        return;
+    }
+    if (!groups.contains("SERVER"))
+    {
+        _errorString = "Configuration file not contains [SERVER] group";
+
+        return;
+    }
+
+    //Database
+    ini.beginGroup("DATABASE");
+
+    _dbConnectionInfo.driver = ini.value("Driver", "").toString();
+    _dbConnectionInfo.dbName = ini.value("DataBase", "").toString();
+    _dbConnectionInfo.userName = ini.value("UID", "").toString();
+    _dbConnectionInfo.password = ini.value("PWD", "").toString();
+    _dbConnectionInfo.connectOptions = ini.value("ConnectionOptions", "").toString();
+    _dbConnectionInfo.port = ini.value("Port", "").toUInt();
+    _dbConnectionInfo.host = ini.value("Host", "").toString();
+
+    const auto errDataBase = _dbConnectionInfo.check();
+
+    if (!errDataBase.isEmpty())
+    {
+        _errorString = QString("Incorrect value [DATABASE]. Error: %1").arg(errDataBase);
+
+        return;
+    }
+
+    ini.endGroup();
+
+    //SYSTEM
+    ini.beginGroup("SYSTEM");
+
+    _debugMode = ini.value("DebugMode", "0").toBool();
+    _logTableName = ini.value("LogTableName", "").toString();
+    _maxQueueKLines = ini.value("MaxQueueKLines", 100000).toLongLong();
+    if (_maxQueueKLines <= 0)
+    {
+        _errorString = QString("Value in [SYSTEM]/MaxQueueKLines must be positive number");
+
+        return;
+    }
+    _storeKLinesCount = ini.value("StoreKLinesCount", 0).toLongLong();
+    if (_storeKLinesCount < 0)
+    {
+        _errorString = QString("Value in [SYSTEM]/StoreKLinesCount cannot be negative");
+
+        return;
+    }
+    // бюджет ограничивает только хранилище /data/klines, память TradingData не ограничивается
+    _storeMemoryBudget = ini.value("StoreMemoryBudget", 0).toLongLong() * 1024 * 1024;
+    if (_storeMemoryBudget < 0)
+    {
+        _errorString = QString("Value in [SYSTEM]/StoreMemoryBudget cannot be negative");
+
+        return;
+    }
+    if (_storeMemoryBudget > 0 && _storeKLinesCount == 0)
+    {
+        _errorString = QString("Value in [SYSTEM]/StoreMemoryBudget limits the /data/klines store only and requires [SYSTEM]/StoreKLinesCount > 0");
+
+        return;
+    }
+    _historyDir = ini.value("HistoryDir", "").toString();
+    _recordDir = ini.value("RecordDir", "").toString();
+    _demandDrivenStreams = ini.value("DemandDrivenStreams", false).toBool();
+    _detectCooldown = ini.value("DetectCooldown", 0).toLongLong() * 1000;
+    if (_detectCooldown < 0)
+    {
+        _errorString = QString("Value in [SYSTEM]/DetectCooldown cannot be negative");
+
+        return;
+    }
+    _stockExchangeThreadsCount = ini.value("StockExchangeThreads", 0).toLongLong();
+    if (_stockExchangeThreadsCount < 0)
+    {
+        _errorString = QString("Value in [SYSTEM]/StockExchangeThreads cannot be negative");
+
+        return;
+    }
+    if (_stockExchangeThreadsCount == 0)
+    {
+        _stockExchangeThreadsCount = qMax(QThread::idealThreadCount(), 1);
+    }
+
+    ini.endGroup();
+
+    //SERVER
+    ini.beginGroup("SERVER");
+
+    const auto address_str =ini.value("Address", QHostAddress::LocalHost).toString();
+    _httpServerConfig.address = QHostAddress(address_str);
+    if (_httpServerConfig.address.isNull())
+    {
+        _errorString = QString("Invalid value in [SERVER]/Address. Value: %1").arg(address_str);
+
+        return;
+    }
+    _httpServerConfig.port = ini.value("Port", 80).toUInt();
+    if (_httpServerConfig.port == 0)
+    {
+        _errorString = QString("Value in [SERVER]/Port must be number");
+
+        return;
+    }
+    _httpServerConfig.maxUsers = ini.value("MaxUsers", 100).toUInt();
+    if (_httpServerConfig.maxUsers == 0)
+    {
+        _errorString = QString("Value in [SERVER]/MaxUsers must be number");
+
+        return;
+    }
+    _httpServerConfig.rootDir = ini.value("RootDir", QCoreApplication::applicationDirPath()).toString();
+    _httpServerConfig.name = ini.value("Name", "").toString();
+    _adminToken = ini.value("AdminToken", "").toString();
+
+    ini.endGroup();
+
+    //PROXY_N
+    for (quint8 currentProxyIndex = 0; currentProxyIndex < std::numeric_limits<quint8>().max(); ++currentProxyIndex)
+    {
+        const auto group =  QString("PROXY_%1").arg(currentProxyIndex);
+        if (groups.contains(group))
+        {
+            ini.beginGroup(group);
+
+            TradingCatCommon::ProxyData tmp;
+            tmp.address = QHostAddress(ini.value("Host", "").toString());
+            if (tmp.address.isNull())
+            {
+                _errorString = QString("Value in [%1]/Host is not valid").arg(group);
+
+                return;
+            }
+
+            bool ok = false;
+            tmp.port = ini.value("Port", 51888).toUInt(&ok);
+            if (tmp.port == 0)
+            {
+                _errorString = QString("Value in [%1]/Port must be number").arg(group);
+
+                return;
+            }
+
+            tmp.user = ini.value("User").toString();
+            tmp.password = ini.value("Password").toString();
+
+            ini.endGroup();
+
+            _proxyDataList.emplace_back(std::move(tmp));
+        }
+    }
+
+    //STOCK_EXCHANGE_N
+    QSet<QString> liveTypes; // типы живых бирж
+    for (quint8 currentStockExchangeIndex = 0; currentStockExchangeIndex < std::numeric_limits<quint8>().max(); ++currentStockExchangeIndex)
+    {
+        const auto group = QString("STOCK_EXCHANGE_%1").arg(currentStockExchangeIndex);
+        if (groups.contains(group))
+        {
+            ini.beginGroup(group);
+
+            StockExchangeConfig tmp;
+
+            tmp.type = ini.value("Type", "").toString();
+            const auto isReplay = tmp.type == *REPLAY_TYPE;
+
+            // воспроизведение записи работает от имени записанной биржи
+            if (isReplay)
+            {
+                const auto replayFileName = ini.value("ReplayFile", "").toString();
+                const auto stockExchangeName = KLinesRecorder::stockExchangeName(replayFileName);
+                if (stockExchangeName.isEmpty())
+                {
+                    _errorString = QString("Value in [%1]/ReplayFile must be a klines record file").arg(group);
+
+                    return;
+                }
+
+                const auto replaySpeed = ini.value("ReplaySpeed", 1.0).toDouble();
+                if (replaySpeed < 0.0)
+                {
+                    _errorString = QString("Value in [%1]/ReplaySpeed cannot be negative").arg(group);
+
+                    return;
+                }
+
+                tmp.type = stockExchangeName;
+                _replayFileNames.insert(tmp.type, replayFileName);
+                _replaySpeeds.insert(tmp.type, replaySpeed);
+            }
+
+            if (tmp.type.isEmpty() || !STOCK_NAME_LIST->contains(tmp.type))
+            {
+                _errorString = QString("Value in [%1]/Type cannot by empty or undefined or incorrect. Support: %2,%3").arg(group).arg(STOCK_NAME_LIST->join(',')).arg(*REPLAY_TYPE);
+
+                return;
+            }
+
+            // настройки и данные биржи хранятся по ее типу, поэтому живая биржа и воспроизведение ее записи одновременно не работают
+            const auto isCollision = isReplay ? liveTypes.contains(tmp.type) : _replayFileNames.contains(tmp.type);
+            if (isCollision)
+            {
+                _errorString = QString("Value in [%1]/Type: stock exchange %2 and the replay of its record cannot run together").arg(group).arg(tmp.type);
+
+                return;
+            }
+            if (!isReplay)
+            {
+                liveTypes.insert(tmp.type);
+            }
+
+            tmp.user = ini.value("User", "").toString();
+            tmp.password = ini.value("Password", "").toString();
+
+            tmp.klineTypes = stringToKLineTypes(ini.value("KLineTypes", "1m").toString());
+            if (tmp.klineTypes.empty())
+            {
+                _errorString = QString("Value in [%1]/KLineTypes cannot by empty or undefined or incorrect").arg(group);
+
+                return;
+            }
+
+            tmp.klineNames = ini.value("KLineNames").toString().split(',');
+            if (tmp.klineNames.first().isEmpty())
+            {
+                tmp.klineNames.clear();
+            }
+
+            const auto storeMemoryBudget = ini.value("StoreMemoryBudget", 0).toLongLong();
+            if (storeMemoryBudget < 0)
+            {
+                _errorString = QString("Value in [%1]/StoreMemoryBudget cannot be negative").arg(group);
+
+                return;
+            }
+            if (storeMemoryBudget > 0 && _storeKLinesCount == 0)
+            {
+                _errorString = QString("Value in [%1]/StoreMemoryBudget limits the /data/klines store only and requires [SYSTEM]/StoreKLinesCount > 0").arg(group);
+
+                return;
+            }
+            if (storeMemoryBudget > 0)
+            {
+                _storeMemoryBudgets.insert(tmp.type, storeMemoryBudget * 1024 * 1024);
+            }
+
+            // дозагрузка пропущенных свечей включена по умолчанию для живых бирж. Коннектор обязан
+            // иметь слот LOAD_KLINES_SLOT - IStockExchange его не объявляет, поэтому он проверяется здесь
+            const auto isReplay = _replayFileNames.contains(tmp.type);
+            const auto isBackfill = ini.value("Backfill", !isReplay).toBool();
+            if (isBackfill)
+            {
+                if (isReplay)
+                {
+                    _errorString = QString("Value in [%1]/Backfill: the replay of a record does not support klines backfill").arg(group);
+
+                    return;
+                }
+
+                const auto metaObject = stockExchangeMetaObject(tmp.type);
+                if (metaObject == nullptr || metaObject->indexOfSlot(LOAD_KLINES_SLOT) < 0)
+                {
+                    _errorString = QString("Value in [%1]/Backfill: stock exchange %2 has no slot %3. Set Backfill=false to run without klines backfill").arg(group).arg(tmp.type).arg(LOAD_KLINES_SLOT);
+
+                    return;
+                }
+
+                _backfillTypes.insert(tmp.type);
+            }
+
+            // пусто - доля лимита биржи по умолчанию
+            const auto backfillRequestsPerMinuteString = ini.value("BackfillRequestsPerMinute", "").toString();
+            auto backfillRequestsPerMinute = defaultBackfillRequestsPerMinute(tmp.type);
+            if (!backfillRequestsPerMinuteString.isEmpty())
+            {
+                bool ok = false;
+                backfillRequestsPerMinute = backfillRequestsPerMinuteString.toLongLong(&ok);
+                if (!ok || backfillRequestsPerMinute < 0)
+                {
+                    _errorString = QString("Value in [%1]/BackfillRequestsPerMinute must be empty or a non-negative number").arg(group);
+
+                    return;
+                }
+            }
+            _backfillRequestsPerMinute.insert(tmp.type, backfillRequestsPerMinute);
+
+            const auto streamUrl = QUrl(ini.value("StreamUrl", "").toString());
+            if (!streamUrl.isEmpty())
+            {
+                if (!streamUrl.isValid() || (streamUrl.scheme() != "ws" && streamUrl.scheme() != "wss"))
+                {
+                    _errorString = QString("Value in [%1]/StreamUrl must be empty or correct ws:// or wss:// URL").arg(group);
+
+                    return;
+                }
+                // поддерживается только протокол потоков kline Binance
+                if (tmp.type != Binance::STOCK_ID.name)
+                {
+                    _errorString = QString("Value in [%1]/StreamUrl is supported for %2 only").arg(group).arg(Binance::STOCK_ID.name);
+
+                    return;
+                }
+                _streamUrls.insert(tmp.type, streamUrl);
+            }
+
+            // с биржи запрашиваются только минутные свечи, остальные интервалы строятся локально.
+            // Начало первых свечей и неполные свечи дозагружаются с биржи - без дозагрузки данные теряются
+            if (ini.value("AggregateKLines", false).toBool())
+            {
+                if (!isBackfill)
+                {
+                    _errorString = QString("Value in [%1]/AggregateKLines requires Backfill=true. Higher intervals cannot be built from 1m klines without klines backfill").arg(group);
+
+                    return;
+                }
+
+                _aggregateKLineTypes.insert(tmp.type, tmp.klineTypes);
+                tmp.klineTypes = KLineTypes{KLineType::MIN1};
+            }
+
+            ini.endGroup();
+
+            _stockExchangeConfigList.emplace_back(std::move(tmp));
+        }
+    }
+
+    if (_stockExchangeConfigList.empty())
+    {
+        _errorString = QString("There are no stock exchanges in the configuration. Check [STOCK_EXCHANGE_0] group");
+
+        return;
+    }
+}
+
+const DBConnectionInfo &Config::dbConnectionInfo() const noexcept
+{
+    return _dbConnectionInfo;
+}
+
+bool Config::debugMode() const noexcept
+{
+    return _debugMode;
+}
+
+const QString& Config::logTableName() const noexcept
+{
+    return _logTableName;
+}
+
+qsizetype Config::maxQueueKLines() const noexcept
+{
+    return _maxQueueKLines;
+}
+
+qsizetype Config::storeKLinesCount() const noexcept
+{
+    return _storeKLinesCount;
+}
+
+qsizetype Config::storeMemoryBudget() const noexcept
+{
+    return _storeMemoryBudget;
+}
+
+const QString& Config::historyDir() const noexcept
+{
+    return _historyDir;
+}
+
+qsizetype Config::stockExchangeThreadsCount() const noexcept
+{
+    return _stockExchangeThreadsCount;
+}
+
+const QString& Config::recordDir() const noexcept
+{
+    return _recordDir;
+}
+
+bool Config::demandDrivenStreams() const noexcept
+{
+    return _demandDrivenStreams;
+}
+
+qint64 Config::detectCooldown() const noexcept
+{
+    return _detectCooldown;
+}
+
+const HTTPServerConfig &Config::httpServerConfig() const noexcept
+{
+    return _httpServerConfig;
+}
+
+const QString& Config::adminToken() const noexcept
+{
+    return _adminToken;
+}
+
+void Config::makeConfig(const QString& configFileName)
+{
+    if (configFileName.isEmpty())
+    {
+        qWarning() << "Configuration file name cannot be empty";
+
+        return;
+    }
+
+    QSettings ini(configFileName, QSettings::IniFormat);
+
+    if (!ini.isWritable())
+    {
+        qWarning() << QString("Can not write configuration file: %1").arg(configFileName);
+
+        return;
+    }
+
+    ini.clear();
+
+    //Database
+    ini.beginGroup("DATABASE");
+
+    ini.remove("");
+
+    ini.setValue("Driver", "QMYSQL");
+    ini.setValue("DataBase", "TradingCat");
+    ini.setValue("UID", "user");
+    ini.setValue("PWD", "password");
+    ini.setValue("ConnectionOptions", "");
+    ini.setValue("Port", "3306");
+    ini.setValue("Host", "localhost");
+
+    ini.endGroup();
+
+    //System
+    ini.beginGroup("SYSTEM");
+
+    ini.remove("");
+
+    ini.setValue("DebugMode", true);
+    ini.setValue("LogTableName", QString("%1Log").arg(QCoreApplication::applicationName()));
+    ini.setValue("MaxQueueKLines", 100000);
+    ini.setValue("StoreKLinesCount", 0);
+    ini.setValue("StoreMemoryBudget", 0);
+    ini.setValue("HistoryDir", "");
+    ini.setValue("StockExchangeThreads", 0);
+    ini.setValue("RecordDir", "");
+    ini.setValue("DemandDrivenStreams", false);
+    ini.setValue("DetectCooldown", 0);
+
+    ini.endGroup();
+
+    //SERVER
+    ini.beginGroup("SERVER");
+
+    ini.remove("");
+
+    ini.setValue("Address", QHostAddress::LocalHost);
+    ini.setValue("Port", 80);
+    ini.setValue("RootDir", QCoreApplication::applicationDirPath());
+    ini.setValue("CRTFileName", "");
+    ini.setValue("KEYFileName", "");
+    ini.setValue("Name", "MyServer");
+    ini.setValue("AdminToken", "");
+
+    ini.endGroup();
+
+    //PROXY
+    ini.beginGroup("PROXY_0");
+
+    ini.remove("");
+
+    ini.setValue("Host", "localhost");
+    ini.setValue("Port", "1234");
+    ini.setValue("User", "user");
+    ini.setValue("Password", "password");
+
+    ini.endGroup();
+
+    //PROXY
+    ini.beginGroup("STOCK_EXCHANGE_0");
+
+    ini.remove("");
+
+    ini.setValue("Type", STOCK_NAME_LIST->join(','));
+    ini.setValue("User", "user");
+    ini.setValue("Password", "password");
+    // у потоков Binance нет интервала 10m - при заданном StreamUrl такие свечи обновляются только через REST
+    ini.setValue("KLineTypes", "1m,5m,10m,1h,1w,1d");
+    ini.setValue("KLineNames", "");
+    ini.setValue("AggregateKLines", false);
+    ini.setValue("StreamUrl", "");
+    ini.setValue("BackfillRequestsPerMinute", "");
+    ini.setValue("ReplayFile", "");
+    ini.setValue("ReplaySpeed", 1.0);
+
+    ini.endGroup();
+
+    //сбрасываем буфер
+    ini.sync();
+
+    qInfo() << QString("Save configuration to %1").arg(configFileName);
+}
+
+const TradingCatCommon::ProxyDataList& Config::proxyDataList() const noexcept
+{
+    return _proxyDataList;
+}
+
+QString Config::errorString()
+{
+    auto res = _errorString;
+    _errorString.clear();
+
+    return res;
+}
+
+
+bool Config::isError() const
+{
+    return !_errorString.isEmpty();
+}
+
+const StockExchangeConfigList &Config::stockExchangeConfigList() const noexcept
+{
+    return _stockExchangeConfigList;
+}
+
+KLineTypes Config::aggregateKLineTypes(const QString& stockExchangeType) const
+{
+    return _aggregateKLineTypes.value(stockExchangeType);
+}
+
+qsizetype Config::storeMemoryBudget(const QString& stockExchangeType) const
+{
+    return _storeMemoryBudgets.value(stockExchangeType, 0);
+}
+
+QUrl Config::streamUrl(const QString& stockExchangeType) const
+{
+    return _streamUrls.value(stockExchangeType);
+}
+
+qsizetype Config::backfillRequestsPerMinute(const QString& stockExchangeType) const
+{
+    return _backfillRequestsPerMinute.value(stockExchangeType, 0);
+}
+
+QString Config::replayFileName(const QString& stockExchangeType) const
+{
+    return _replayFileNames.value(stockExchangeType);
+}
+
+double Config::replaySpeed(const QString& stockExchangeType) const
+{
+    return _replaySpeeds.value(stockExchangeType, 1.0);
+}
+
+bool Config::isBackfill(const QString& stockExchangeType) const
+{
+    return _backfillTypes.contains(stockExchangeType);
+}
@@ -1,69 +1,110 @@
-#pragma once
-
-//QT
-#include <QString>
-#include <QSet>
-
-//My
-#include <Common/sql.h>
-
-#include <TradingCatCommon/types.h>
-#include <TradingCatCommon/stockexchange.h>
-#include <TradingCatCommon/httpserver.h>
-
-#include <StockExchange/istockexchange.h>
-
-class Config final
-{
-public:
-    static Config* config(const QString& configFileName = QString());
-    static void deleteConfig();
-
-    static void makeConfig(const QString& configFileName);
-
-private:
-    explicit Config(const QString& configFileName);
-
-public:
-    //[DATABASE]
-    const Common::DBConnectionInfo& dbConnectionInfo() const noexcept;
-
-    //[SYSTEM]
-    bool debugMode() const noexcept;
-    const QString& logTableName() const noexcept;
-
-    //SERVER
-    const TradingCatCommon::HTTPServerConfig& httpServerConfig() const noexcept;
-
-    //[PROXY_N]
-    const TradingCatCommon::ProxyDataList& proxyDataList() const noexcept;
-
-    [[nodiscard]] QString errorString();
-    bool isError() const;
-
-    //[STOCK_EXCHANGE_N]
-    const StockExchange::StockExchangeConfigList& stockExchangeConfigList() const noexcept;
-
-private:
-    const QString _configFileName;
-
-    QString _errorString;
-
-    //[SYSTEM]
-    bool _debugMode = true;
-    QString _logTableName;
-
-    //[DATABASE]
-    Common::DBConnectionInfo _dbConnectionInfo;
-
-    //SERVER
-    TradingCatCommon::HTTPServerConfig _httpServerConfig;
-
-    //[PROXY_N]
-    TradingCatCommon::ProxyDataList _proxyDataList;
-
-    //[STOCK_EXCHANGE_N]
-    StockExchange::StockExchangeConfigList _stockExchangeConfigList;
-
-};
-
+#pragma once
+
+//QT
+#include <QString>
+#include <QSet>
+#include <QHash>
+#include <QUrl>
+
+//My
+#include <Common/sql.h>
+
+#include <TradingCatCommon/types.h>
+#include <TradingCatCommon/stockexchange.h>
+#include <TradingCatCommon/httpserver.h>
+
+#include <StockExchange/istockexchange.h>
+
+class Config final
+{
+public:
+    static Config* config(const QString& configFileName = QString());
+    static void deleteConfig();
+
+    static void makeConfig(const QString& configFileName);
+
+private:
+    explicit Config(const QString& configFileName);
+
+public:
+    //[DATABASE]
+    const Common::DBConnectionInfo& dbConnectionInfo() const noexcept;
+
+    //[SYSTEM]
+    bool debugMode() const noexcept;
+    const QString& logTableName() const noexcept;
+    qsizetype maxQueueKLines() const noexcept;
+    qsizetype storeKLinesCount() const noexcept;
+    qsizetype storeMemoryBudget() const noexcept;
+    const QString& historyDir() const noexcept;
+    qsizetype stockExchangeThreadsCount() const noexcept;
+    const QString& recordDir() const noexcept;
+    bool demandDrivenStreams() const noexcept;
+    qint64 detectCooldown() const noexcept;
+
+    //SERVER
+    const TradingCatCommon::HTTPServerConfig& httpServerConfig() const noexcept;
+    const QString& adminToken() const noexcept;
+
+    //[PROXY_N]
+    const TradingCatCommon::ProxyDataList& proxyDataList() const noexcept;
+
+    [[nodiscard]] QString errorString();
+    bool isError() const;
+
+    //[STOCK_EXCHANGE_N]
+    const StockExchange::StockExchangeConfigList& stockExchangeConfigList() const noexcept;
+    TradingCatCommon::KLineTypes aggregateKLineTypes(const QString& stockExchangeType) const;
+    qsizetype storeMemoryBudget(const QString& stockExchangeType) const;
+    QUrl streamUrl(const QString& stockExchangeType) const;
+    qsizetype backfillRequestsPerMinute(const QString& stockExchangeType) const;
+    QString replayFileName(const QString& stockExchangeType) const;
+    double replaySpeed(const QString& stockExchangeType) const;
+
+    /*!
+        Дозагрузка пропущенных свечей включена (ключ Backfill). При загрузке конфига
+            проверяется, что коннектор биржи имеет слот LOAD_KLINES_SLOT
+    */
+    bool isBackfill(const QString& stockExchangeType) const;
+
+    static constexpr const char* LOAD_KLINES_SLOT = "loadKLines(TradingCatCommon::KLineID,qint64,qint64)";
+
+private:
+    const QString _configFileName;
+
+    QString _errorString;
+
+    //[SYSTEM]
+    bool _debugMode = true;
+    QString _logTableName;
+    qsizetype _maxQueueKLines = 100000;
+    qsizetype _storeKLinesCount = 0; ///< свечей одного KLineID для /data/klines. 0 - хранилище KLinesStore отключено, запрос недоступен
+    qsizetype _storeMemoryBudget = 0; ///< байт, 0 - без ограничения. Ограничивает только хранилище /data/klines, память TradingData не ограничивается
+    QString _historyDir;
+    qsizetype _stockExchangeThreadsCount = 1; ///< 0 в конфиге - по количеству ядер
+    QString _recordDir; ///< каталог записи пакетов бирж. Пусто - запись отключена
+    bool _demandDrivenStreams = false; ///< WebSocket-потоки подписаны, только пока онлайн есть сессии с фильтрами
+    qint64 _detectCooldown = 0; ///< мс, минимальный интервал между отдачей клиенту событий одной свечи и фильтра. 0 - без ограничения
+
+    //[DATABASE]
+    Common::DBConnectionInfo _dbConnectionInfo;
+
+    //SERVER
+    TradingCatCommon::HTTPServerConfig _httpServerConfig;
+    QString _adminToken; ///< ключ доступа к служебным запросам. Пустой - служебные запросы отключены
+
+    //[PROXY_N]
+    TradingCatCommon::ProxyDataList _proxyDataList;
+
+    //[STOCK_EXCHANGE_N]
+    StockExchange::StockExchangeConfigList _stockExchangeConfigList;
+    QHash<QString, TradingCatCommon::KLineTypes> _aggregateKLineTypes; ///< интервалы, которые строятся из минутных свечей, по типу биржи
+    QHash<QString, qsizetype> _storeMemoryBudgets; ///< бюджет памяти хранилища /data/klines в байтах по типу биржи
+    QHash<QString, QUrl> _streamUrls; ///< адреса WebSocket-потоков свечей по типу биржи (только Binance). Нет адреса - только REST. Интервалы без потока (10m) - только REST
+    QSet<QString> _backfillTypes; ///< типы бирж с дозагрузкой пропущенных свечей
+    QHash<QString, qsizetype> _backfillRequestsPerMinute; ///< лимит запросов дозагрузки в минуту по типу биржи, не включает регулярный опрос. 0 - без ограничения
+    QHash<QString, QString> _replayFileNames; ///< файлы записи для бирж, которые воспроизводятся вместо подключения
+    QHash<QString, double> _replaySpeeds; ///< скорость воспроизведения по типу биржи. 0 - максимальная
+
+};
+
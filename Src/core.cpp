@@ -1,6 +1,10 @@
+//STL
+#include <algorithm>
+
 //QT
 #include <QtNetwork/QNetworkProxy>
 #include <QCoreApplication>
+#include <QDateTime>
 
 //My
 //#include <StockExchange/moex.h>
@@ -23,12 +27,18 @@
 #include <StockExchange/bingxfutures.h>
 #include <StockExchange/bitmartfutures.h>
 
+#include "klinespool.h"
 #include "core.h"
 
 using namespace TradingCatCommon;
 using namespace Common;
 using namespace StockExchange;
 
+static const qint64 STATISTIC_INTERVAL = 60 * 1000;
+static const qint64 MIN_RESTART_INTERVAL = 10 * 1000;
+static const qint64 MAX_RESTART_INTERVAL = 10 * 60 * 1000;   // после такой работы без ошибок задержка перезапуска сбрасывается
+static const qsizetype ARCHIVE_LOAD_KLINES_COUNT = 100;     // окно свечей детектора, загружаемое из архива при запуске
+
 Core::Core(QObject *parent)
     : QObject{parent}
     , _cnf(Config::config())
@@ -53,21 +63,92 @@ void Core::start()
     Q_CHECK_PTR(_loger);
     Q_CHECK_PTR(_cnf);
 
-    //Data thread
+    // список бирж строится один раз по конфигурации и общий для трассировки, монитора, TradingData, архива и сервера
+    TradingCatCommon::StockExchangesIDList stockExchangeIdList;
+    for (const auto& stockExchangeIdConfig: _cnf->stockExchangeConfigList())
     {
-        TradingCatCommon::StockExchangesIDList stockExchangeIdList;
-        for (const auto& stockExchangeIdConfig: _cnf->stockExchangeConfigList())
-        {
-            stockExchangeIdList.emplace(StockExchangeID(stockExchangeIdConfig.type));
-        }
+        stockExchangeIdList.emplace(StockExchangeID(stockExchangeIdConfig.type));
+    }
+
+    // задержка от закрытия свечи до каждого этапа. Точки трассировки вызываются в потоках отправителей
+    _latencyTracer = std::make_unique<LatencyTracer>(stockExchangeIdList);
 
+    // счетчики каждой биржи. Упавшая биржа перезапускается, остальные продолжают работать
+    _stockExchangeMonitor = std::make_unique<StockExchangeMonitor>(stockExchangeIdList);
+
+    //Data thread
+    {
         _dataThread = std::make_unique<DataThread>();
         _dataThread->data = std::make_unique<TradingData>(stockExchangeIdList);
         _dataThread->thread = std::make_unique<QThread>();
         _dataThread->data->moveToThread(_dataThread->thread.get());
+        _dataThread->queue = std::make_unique<KLinesQueue>("TradingData", _cnf->maxQueueKLines());
+        _dataThread->queue->moveToThread(_dataThread->thread.get());
+
+        connect(_dataThread->queue.get(), SIGNAL(getKLines(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesList&)),
+                _latencyTracer.get(), SLOT(tradingDataKLines(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesList&)), Qt::DirectConnection);
+        connect(_dataThread->queue.get(), SIGNAL(getKLines(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesList&)),
+                _dataThread->data.get(), SLOT(addKLines(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesList&)), Qt::DirectConnection);
+        connect(_dataThread->queue.get(), SIGNAL(sendLogMsg(Common::MSG_CODE, const QString&)),
+                SLOT(sendLogMsgKLinesQueue(Common::MSG_CODE, const QString&)), Qt::QueuedConnection);
+
+        // хранилище свечей для /data/klines. Детектор читает TradingData, поэтому хранилище необязательно
+        if (_cnf->storeKLinesCount() > 0)
+        {
+            _dataThread->store = std::make_unique<KLinesStore>(_cnf->storeKLinesCount());
+            _dataThread->store->setMemoryBudget(_cnf->storeMemoryBudget());
+            for (const auto& stockExchangeIdConfig: _cnf->stockExchangeConfigList())
+            {
+                _dataThread->store->setMemoryBudget(StockExchangeID(stockExchangeIdConfig.type), _cnf->storeMemoryBudget(stockExchangeIdConfig.type));
+            }
+            _dataThread->store->moveToThread(_dataThread->thread.get());
+
+            connect(_dataThread->store.get(), SIGNAL(sendLogMsg(Common::MSG_CODE, const QString&)),
+                    SLOT(sendLogMsgKLinesStore(Common::MSG_CODE, const QString&)), Qt::QueuedConnection);
+
+            connect(_dataThread->queue.get(), SIGNAL(getKLines(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesList&)),
+                    _dataThread->store.get(), SLOT(addKLines(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesList&)), Qt::DirectConnection);
+        }
 
         connect(_dataThread->thread.get(), SIGNAL(started()), _dataThread->data.get(), SLOT(start()), Qt::DirectConnection);
         connect(_dataThread->data.get(), SIGNAL(finished()), _dataThread->thread.get(), SLOT(quit()), Qt::DirectConnection);
+
+        // снимок для потоков запросов. Перестраивается после применения каждого списка свечей
+        _dataThread->snapshot = std::make_unique<TradingDataSnapshot>(*_dataThread->data);
+        _dataThread->snapshot->moveToThread(_dataThread->thread.get());
+
+        connect(_dataThread->thread.get(), SIGNAL(started()), _dataThread->snapshot.get(), SLOT(start()), Qt::DirectConnection);
+        connect(this, SIGNAL(stopAll()), _dataThread->snapshot.get(), SLOT(stop()), Qt::QueuedConnection);
+        connect(_dataThread->data.get(), SIGNAL(started()), _dataThread->snapshot.get(), SLOT(refresh()), Qt::DirectConnection);
+
+        // архив. Запускается после TradingData и загружает историю до того, как биржи пришлют данные
+        if (!_cnf->historyDir().isEmpty())
+        {
+            _dataThread->archive = std::make_unique<KLinesArchive>(_cnf->historyDir(), stockExchangeIdList, std::max(_cnf->storeKLinesCount(), ARCHIVE_LOAD_KLINES_COUNT));
+            _dataThread->archive->moveToThread(_dataThread->thread.get());
+
+            connect(_dataThread->thread.get(), SIGNAL(started()), _dataThread->archive.get(), SLOT(start()), Qt::DirectConnection);
+            connect(this, SIGNAL(stopAll()), _dataThread->archive.get(), SLOT(stop()), Qt::QueuedConnection);
+
+            connect(_dataThread->archive.get(), SIGNAL(getKLinesID(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesIDList&)),
+                    _dataThread->data.get(), SLOT(getKLinesID(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesIDList&)), Qt::DirectConnection);
+            connect(_dataThread->archive.get(), SIGNAL(getKLinesID(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesIDList&)),
+                    _dataThread->snapshot.get(), SLOT(refresh()), Qt::DirectConnection);
+            connect(_dataThread->archive.get(), SIGNAL(getKLines(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesList&)),
+                    _dataThread->data.get(), SLOT(addKLines(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesList&)), Qt::DirectConnection);
+            if (_dataThread->store)
+            {
+                connect(_dataThread->archive.get(), SIGNAL(getKLines(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesList&)),
+                        _dataThread->store.get(), SLOT(addKLines(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesList&)), Qt::DirectConnection);
+            }
+            connect(_dataThread->queue.get(), SIGNAL(getKLines(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesList&)),
+                    _dataThread->archive.get(), SLOT(addKLines(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesList&)), Qt::DirectConnection);
+            connect(_dataThread->archive.get(), SIGNAL(sendLogMsg(Common::MSG_CODE, const QString&)),
+                    SLOT(sendLogMsgKLinesArchive(Common::MSG_CODE, const QString&)), Qt::QueuedConnection);
+            // Свечи из архива задают поиску пропусков ожидаемое время, чтобы простой до запуска был дозагружен
+            connect(_dataThread->archive.get(), SIGNAL(getKLines(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesList&)),
+                    SLOT(archiveKLines(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesList&)), Qt::QueuedConnection);
+        }
         connect(this, SIGNAL(stopAll()), _dataThread->data.get(), SLOT(stop()), Qt::QueuedConnection);
         connect(_dataThread->data.get(), SIGNAL(started()), SLOT(startedTradingData()), Qt::QueuedConnection);
 
@@ -80,7 +161,9 @@ void Core::start()
     //UsersCore
     {
         _usersCoreThread = std::make_unique<UsersCoreThread>();
-        _usersCoreThread->usersCore = std::make_unique<UsersCore>(_cnf->dbConnectionInfo(), *_dataThread->data);
+        _usersCoreThread->usersCore = std::make_unique<UsersCore>(_cnf->dbConnectionInfo(), *_dataThread->snapshot);
+        _usersCoreThread->usersCore->setLatencyTracer(_latencyTracer.get());
+        _usersCoreThread->usersCore->setDetectCooldown(_cnf->detectCooldown());
         _usersCoreThread->thread = std::make_unique<QThread>();
         _usersCoreThread->usersCore->moveToThread(_usersCoreThread->thread.get());
 
@@ -93,7 +176,6 @@ void Core::start()
                 SLOT(errorOccurredUsersCore(Common::EXIT_CODE, const QString&)), Qt::QueuedConnection);
         connect(_usersCoreThread->usersCore.get(), SIGNAL(sendLogMsg(Common::MSG_CODE, const QString&)),
                 SLOT(sendLogMsgUsersCore(Common::MSG_CODE, const QString&)), Qt::QueuedConnection);
-
     }
 
     // Detector
@@ -102,6 +184,16 @@ void Core::start()
         _detectorThread->detector = std::make_unique<Detector>(*_dataThread->data);
         _detectorThread->thread = std::make_unique<QThread>();
         _detectorThread->detector->moveToThread(_detectorThread->thread.get());
+        _detectorThread->queue = std::make_unique<KLinesQueue>("Detector", _cnf->maxQueueKLines());
+        _detectorThread->queue->setSkipOutdated(true); // дозагрузка и история идут только в TradingData
+        _detectorThread->queue->moveToThread(_detectorThread->thread.get());
+
+        connect(_detectorThread->queue.get(), SIGNAL(getKLines(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesList&)),
+                _latencyTracer.get(), SLOT(detectorKLines(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesList&)), Qt::DirectConnection);
+        connect(_detectorThread->queue.get(), SIGNAL(getKLines(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesList&)),
+                _detectorThread->detector.get(), SLOT(addKLines(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesList&)), Qt::DirectConnection);
+        connect(_detectorThread->queue.get(), SIGNAL(sendLogMsg(Common::MSG_CODE, const QString&)),
+                SLOT(sendLogMsgKLinesQueue(Common::MSG_CODE, const QString&)), Qt::QueuedConnection);
 
         connect(_detectorThread->thread.get(), SIGNAL(started()), _detectorThread->detector.get(), SLOT(start()), Qt::DirectConnection);
         connect(_detectorThread->detector.get(), SIGNAL(finished()), _detectorThread->thread.get(), SLOT(quit()), Qt::DirectConnection);
@@ -123,13 +215,43 @@ void Core::start()
 
     }
 
+    // Спрос на свечи по сессиям онлайн. Без сессий с фильтрами WebSocket-потоки снимают подписки
+    if (_cnf->demandDrivenStreams())
+    {
+        _demandTracker = std::make_unique<DemandTracker>();
+
+        connect(_usersCoreThread->usersCore.get(), SIGNAL(userOnline(qint64, const TradingCatCommon::UserConfig&)),
+                _demandTracker.get(), SLOT(userOnline(qint64, const TradingCatCommon::UserConfig&)), Qt::QueuedConnection);
+        connect(_usersCoreThread->usersCore.get(), SIGNAL(userOffline(qint64)),
+                _demandTracker.get(), SLOT(userOffline(qint64)), Qt::QueuedConnection);
+    }
+
     //Stock exchange
     {
+        // биржи делят пул потоков с циклами событий. Пул ограничивает число потоков.
+        // Его влияние на задержку свечей не измерено: DetectorBenchmark запускает только детектор
+        const auto threadsCount = std::min<qsizetype>(_cnf->stockExchangeThreadsCount(), static_cast<qsizetype>(_cnf->stockExchangeConfigList().size()));
+        for (qsizetype i = 0; i < threadsCount; ++i)
+        {
+            auto poolThread = std::make_unique<StockExchangePoolThread>();
+            poolThread->thread = std::make_unique<QThread>();
+            poolThread->thread->setObjectName(QString("StockExchange_%1").arg(i));
+
+            connect(_usersCoreThread->thread.get(), SIGNAL(started()), poolThread->thread.get(), SLOT(start()), Qt::QueuedConnection); //start afret UsersCoreThread
+
+            _stockExchangePool.emplace_back(std::move(poolThread));
+        }
+
+        qsizetype nextPoolThread = 0;
         for (const auto& stockExchangeConfig: _cnf->stockExchangeConfigList())
         {
             auto tmp = std::make_unique<StockExchangeThread>();
-            tmp->stockExchange = makeStockEchange(stockExchangeConfig);
-            if (!tmp->stockExchange)
+            tmp->stockExchangeId = StockExchangeID(stockExchangeConfig.type);
+
+            makeStockExchangeSource(*tmp, stockExchangeConfig);
+
+            QObject* const stockExchange = tmp->source();
+            if (!stockExchange)
             {
                 const auto msg = QString("Critical error while the Core running. Code: %1 Message: Undefined stock exchange type").arg(Common::EXIT_CODE::LOAD_CONFIG_ERR);
 
@@ -139,26 +261,96 @@ void Core::start()
                 return;
             }
 
-            tmp->thread = std::make_unique<QThread>();
-            tmp->stockExchange->moveToThread(tmp->thread.get());
+            auto& poolThread = *_stockExchangePool[nextPoolThread];
+            nextPoolThread = (nextPoolThread + 1) % static_cast<qsizetype>(_stockExchangePool.size());
+            ++poolThread.running;
 
-            connect(tmp->thread.get(), SIGNAL(started()), tmp->stockExchange.get(), SLOT(start()), Qt::DirectConnection);
-            connect(tmp->stockExchange.get(), SIGNAL(finished()), tmp->thread.get(), SLOT(quit()), Qt::DirectConnection);
-            connect(this, SIGNAL(stopAll()), tmp->stockExchange.get(), SLOT(stop()), Qt::QueuedConnection);
-            connect(_usersCoreThread->thread.get(), SIGNAL(started()), tmp->thread.get(), SLOT(start()), Qt::QueuedConnection); //start afret UsersCoreThread
+            tmp->thread = poolThread.thread.get();
+            stockExchange->moveToThread(tmp->thread);
 
-            connect(tmp->stockExchange.get(), SIGNAL(errorOccurred(const TradingCatCommon::StockExchangeID&, Common::EXIT_CODE, const QString&)),
-                    SLOT(errorOccurredStockExchange(const TradingCatCommon::StockExchangeID&, Common::EXIT_CODE, const QString&)), Qt::QueuedConnection);
-            connect(tmp->stockExchange.get(), SIGNAL(sendLogMsg(const TradingCatCommon::StockExchangeID&, Common::MSG_CODE, const QString&)),
-                    SLOT(sendLogMsgStockExchange(const TradingCatCommon::StockExchangeID&, Common::MSG_CODE, const QString&)), Qt::QueuedConnection);
+            connect(tmp->thread, SIGNAL(started()), stockExchange, SLOT(start()), Qt::DirectConnection);
+
+            // сырой вывод биржи записывается для воспроизведения
+            if (!_cnf->recordDir().isEmpty() && _cnf->replayFileName(stockExchangeConfig.type).isEmpty())
+            {
+                tmp->recorder = std::make_unique<KLinesRecorder>(tmp->stockExchangeId, _cnf->recordDir());
+                tmp->recorder->moveToThread(tmp->thread);
+
+                connect(tmp->thread, SIGNAL(started()), tmp->recorder.get(), SLOT(start()), Qt::DirectConnection);
+                connect(this, SIGNAL(stopAll()), tmp->recorder.get(), SLOT(stop()), Qt::QueuedConnection);
+                connect(tmp->recorder.get(), SIGNAL(sendLogMsg(const TradingCatCommon::StockExchangeID&, Common::MSG_CODE, const QString&)),
+                        SLOT(sendLogMsgStockExchange(const TradingCatCommon::StockExchangeID&, Common::MSG_CODE, const QString&)), Qt::QueuedConnection);
+            }
+
+            // свечи биржи проходят через WebSocket поток, поэтому закрытая свеча, полученная обоими, идет дальше один раз
+            const auto streamUrl = _cnf->streamUrl(stockExchangeConfig.type);
+            if (!streamUrl.isEmpty())
+            {
+                tmp->stream = std::make_unique<KLinesStream>(tmp->stockExchangeId, streamUrl, *_streamProxyPool);
+                if (_demandTracker)
+                {
+                    tmp->stream->setDemanded(_demandTracker->isDemanded());
+
+                    connect(_demandTracker.get(), SIGNAL(demandChanged(bool)), tmp->stream.get(), SLOT(setDemanded(bool)), Qt::QueuedConnection);
+                }
+                tmp->stream->moveToThread(tmp->thread);
+
+                connect(tmp->thread, SIGNAL(started()), tmp->stream.get(), SLOT(start()), Qt::DirectConnection);
+                connect(this, SIGNAL(stopAll()), tmp->stream.get(), SLOT(stop()), Qt::QueuedConnection);
+                connect(tmp->stream.get(), SIGNAL(sendLogMsg(const TradingCatCommon::StockExchangeID&, Common::MSG_CODE, const QString&)),
+                        SLOT(sendLogMsgStockExchange(const TradingCatCommon::StockExchangeID&, Common::MSG_CODE, const QString&)), Qt::QueuedConnection);
+            }
+
+            // старшие интервалы строятся из 1m свечей в потоке биржи
+            const auto aggregateKLineTypes = _cnf->aggregateKLineTypes(stockExchangeConfig.type);
+            tmp->isAggregated = !aggregateKLineTypes.empty();
+            if (tmp->isAggregated)
+            {
+                tmp->aggregator = std::make_unique<KLinesAggregator>(aggregateKLineTypes);
+                tmp->aggregator->moveToThread(tmp->thread);
+
+                if (tmp->stream)
+                {
+                    connect(tmp->stream.get(), SIGNAL(getKLines(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesList&)),
+                            tmp->aggregator.get(), SLOT(addKLines(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesList&)), Qt::DirectConnection);
+                }
+            }
+
+            // Запросы дозагрузки идут в пределах доли лимита биржи BackfillRequestsPerMinute. Регулярный опрос коннектор ведет сам
+            if (_cnf->isBackfill(stockExchangeConfig.type))
+            {
+                tmp->backfillPacer = std::make_unique<BackfillPacer>(tmp->stockExchangeId, _cnf->backfillRequestsPerMinute(stockExchangeConfig.type));
 
-            // get new data
-            connect(tmp->stockExchange.get(), SIGNAL(getKLines(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesList&)),
-                    _dataThread->data.get(), SLOT(addKLines(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesList&)), Qt::QueuedConnection);      
-            connect(tmp->stockExchange.get(), SIGNAL(getKLinesID(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesIDList&)),
-                    _dataThread->data.get(), SLOT(getKLinesID(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesIDList&)), Qt::QueuedConnection);
-            connect(tmp->stockExchange.get(), SIGNAL(getKLines(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesList&)),
-                    _detectorThread->detector.get(), SLOT(addKLines(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesList&)), Qt::QueuedConnection);
+                connect(this, SIGNAL(stopAll()), tmp->backfillPacer.get(), SLOT(stop()), Qt::DirectConnection);
+
+                // Начало первых свечей старших интервалов и неполные свечи загружаются с биржи
+                if (tmp->aggregator)
+                {
+                    connect(tmp->aggregator.get(), SIGNAL(loadKLinesRequest(const TradingCatCommon::KLineID&, qint64, qint64)),
+                            tmp->backfillPacer.get(), SLOT(loadKLinesRequest(const TradingCatCommon::KLineID&, qint64, qint64)), Qt::QueuedConnection);
+                }
+
+                tmp->backfillPacer->start();
+            }
+
+            // пропущенные свечи ищутся в потоке биржи до очередей, поэтому сжатие отстающей очереди не принимается за разрыв
+            tmp->gapDetector = std::make_unique<KLinesGapDetector>();
+            tmp->gapDetector->moveToThread(tmp->thread);
+
+            connect(tmp->gapDetector.get(), SIGNAL(gapDetected(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::KLineID&, qint64, qint64)),
+                    SLOT(gapDetected(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::KLineID&, qint64, qint64)), Qt::QueuedConnection);
+
+            connectStockExchange(*tmp);
+
+            if (tmp->aggregator)
+            {
+                connectKLinesSource(*tmp, tmp->aggregator.get());
+                connectKLinesIdSource(*tmp, tmp->aggregator.get());
+            }
+            else if (tmp->stream)
+            {
+                connectKLinesSource(*tmp, tmp->stream.get());
+            }
 
             _stockExchangeThreadList.emplace_back(std::move(tmp));
         }
@@ -166,8 +358,10 @@ void Core::start()
 
     // App Server
     {
+        // готовность бирж проверяется по конфигурации, а не по биржам, уже известным TradingData
         _appServerThread = std::make_unique<AppServerThread>();
-        _appServerThread->appServer = std::make_unique<AppServer>(_cnf->httpServerConfig(), *_dataThread->data, *_usersCoreThread->usersCore);
+        _appServerThread->appServer = std::make_unique<AppServer>(_cnf->httpServerConfig(), *_dataThread->snapshot, _dataThread->store.get(), *_usersCoreThread->usersCore, *_latencyTracer,
+                                                                  *_stockExchangeMonitor, stockExchangeIdList, _cnf->adminToken());
 
         _appServerThread->thread = std::make_unique<QThread>();
         _appServerThread->appServer->moveToThread(_appServerThread->thread.get());
@@ -175,7 +369,7 @@ void Core::start()
         connect(_appServerThread->thread.get(), SIGNAL(started()), _appServerThread->appServer.get(), SLOT(start()), Qt::DirectConnection);
         connect(_appServerThread->appServer.get(), SIGNAL(finished()), _appServerThread->thread.get(), SLOT(quit()), Qt::DirectConnection);
         connect(this, SIGNAL(stopAll()), _appServerThread->appServer.get(), SLOT(stop()), Qt::QueuedConnection);
-        connect(_dataThread->data.get(), SIGNAL(started()), _appServerThread->thread.get(), SLOT(start()), Qt::QueuedConnection); //start afret get all klines ID
+        connect(_dataThread->thread.get(), SIGNAL(started()), _appServerThread->thread.get(), SLOT(start()), Qt::QueuedConnection); //start afret DataThread. Готовность бирж сообщает /status
 
         connect(_appServerThread->appServer.get(), SIGNAL(errorOccurred(Common::EXIT_CODE, const QString&)),
                 SLOT(errorOccurredAppServer(Common::EXIT_CODE, const QString&)), Qt::QueuedConnection);
@@ -183,6 +377,13 @@ void Core::start()
                 SLOT(sendLogMsgAppServer(Common::MSG_CODE, const QString&)), Qt::QueuedConnection);
     }
 
+    // статистика
+    _statisticTimer = new QTimer(this);
+
+    connect(_statisticTimer, SIGNAL(timeout()), SLOT(statisticTimerTimeout()));
+
+    _statisticTimer->start(STATISTIC_INTERVAL);
+
     _isStarted = true;
 
     _dataThread->thread->start();
@@ -201,23 +402,51 @@ void Core::stop()
 
     Q_CHECK_PTR(_loger);
 
-    emit stopAll();
+    delete _statisticTimer;
+    _statisticTimer = nullptr;
 
+    // коннектор биржи, ожидающей перезапуска, уже остановлен, отключен от stopAll() и удален - освобождаем
+    // поток пула после обработки его остановки. Обработчики биржи живут в том же потоке
     for (const auto& stockExchangeThread: _stockExchangeThreadList)
     {
-        stockExchangeThread->thread->wait();
+        if (!stockExchangeThread->isRestarting)
+        {
+            continue;
+        }
+
+        stockExchangeThread->isRestarting = false;
+
+        QMetaObject::invokeMethod(stockExchangeThread->gapDetector.get(),
+            [this]()
+            {
+                finishedStockExchange();
+            }, Qt::QueuedConnection);
+    }
+
+    emit stopAll();
+
+    for (const auto& poolThread: _stockExchangePool)
+    {
+        poolThread->thread->wait();
     }
     _stockExchangeThreadList.clear();
+    _stockExchangePool.clear();
 
     _appServerThread->thread->wait();
     _appServerThread.reset();
 
+    _detectorThread->thread->wait();
+    _detectorThread.reset();
+
     _usersCoreThread->thread->wait();
     _usersCoreThread.reset();
 
     _dataThread->thread->wait();
     _dataThread.reset();
 
+    _latencyTracer.reset();
+    _stockExchangeMonitor.reset();
+
     _isStarted = false;
 
     _loger->sendLogMsg(MSG_CODE::INFORMATION_CODE, "Stoped successfully");
@@ -242,7 +471,67 @@ void Core::errorOccurredStockExchange(const TradingCatCommon::StockExchangeID &i
 
     qCritical() << msg;
 
-    QCoreApplication::exit(errorCode);
+    _stockExchangeMonitor->errorOccurred(id, errorString);
+
+    // ошибка одной биржи не останавливает сервер: биржа останавливается и перезапускается с нарастающей задержкой
+    const auto it_stockExchangeThread = std::find_if(_stockExchangeThreadList.begin(), _stockExchangeThreadList.end(),
+        [&id](const PStockExchangeThread& stockExchangeThread)
+        {
+            return stockExchangeThread->stockExchangeId == id;
+        });
+
+    if (it_stockExchangeThread == _stockExchangeThreadList.end())
+    {
+        return;
+    }
+
+    auto& stockExchangeThread = *it_stockExchangeThread;
+    if (stockExchangeThread->isRestarting)
+    {
+        return;
+    }
+
+    const auto currentTime = QDateTime::currentMSecsSinceEpoch();
+    if (stockExchangeThread->lastRestartTime == 0 || currentTime - stockExchangeThread->lastRestartTime > MAX_RESTART_INTERVAL)
+    {
+        stockExchangeThread->restartInterval = MIN_RESTART_INTERVAL;
+    }
+    else
+    {
+        stockExchangeThread->restartInterval = std::min(stockExchangeThread->restartInterval * 2, MAX_RESTART_INTERVAL);
+    }
+
+    stockExchangeThread->isRestarting = true;
+
+    // коннектор отключается от всех получателей: его остановка не должна освобождать поток пула,
+    // а stopAll() - останавливать его повторно. После остановки коннектор удаляется в своем потоке,
+    // при перезапуске создается новый
+    QObject* const stockExchange = stockExchangeThread->stockExchange
+        ? static_cast<QObject*>(stockExchangeThread->stockExchange.release())
+        : static_cast<QObject*>(stockExchangeThread->replay.release());
+    stockExchange->disconnect();
+    disconnect(this, nullptr, stockExchange, nullptr);
+
+    // запросы дозагрузки не отправляются, пока коннектора нет
+    if (stockExchangeThread->backfillPacer)
+    {
+        disconnect(stockExchangeThread->backfillPacer.get(), nullptr, stockExchange, nullptr);
+        stockExchangeThread->backfillPacer->stop();
+    }
+
+    connect(stockExchange, SIGNAL(finished()), stockExchange, SLOT(deleteLater()), Qt::DirectConnection);
+
+    QMetaObject::invokeMethod(stockExchange, "stop", Qt::QueuedConnection);
+
+    _loger->sendLogMsg(MSG_CODE::WARNING_CODE, QString("Stock exchange %1 is stopped. Restart after %2 s")
+                                                   .arg(id.toString())
+                                                   .arg(stockExchangeThread->restartInterval / 1000));
+
+    QTimer::singleShot(stockExchangeThread->restartInterval, this,
+        [this, id]()
+        {
+            restartStockExchange(id);
+        });
 }
 
 void Core::sendLogMsgStockExchange(const TradingCatCommon::StockExchangeID &id, Common::MSG_CODE category, const QString &msg)
@@ -319,6 +608,271 @@ void Core::sendLogMsgAppServer(Common::MSG_CODE category, const QString &msg)
     _loger->sendLogMsg(category, QString("Application HTTP server: %1").arg(msg));
 }
 
+void Core::sendLogMsgKLinesQueue(Common::MSG_CODE category, const QString &msg)
+{
+    _loger->sendLogMsg(category, QString("KLines queue: %1").arg(msg));
+}
+
+void Core::sendLogMsgKLinesStore(Common::MSG_CODE category, const QString &msg)
+{
+    _loger->sendLogMsg(category, QString("KLines store: %1").arg(msg));
+}
+
+void Core::sendLogMsgKLinesArchive(Common::MSG_CODE category, const QString &msg)
+{
+    _loger->sendLogMsg(category, QString("KLines archive: %1").arg(msg));
+}
+
+void Core::finishedStockExchange()
+{
+    // вызывается в потоке пула, в котором работала биржа. Поток останавливается после завершения всех его бирж
+    const auto currentThread = QThread::currentThread();
+    for (const auto& poolThread: _stockExchangePool)
+    {
+        if (poolThread->thread.get() == currentThread)
+        {
+            if (--poolThread->running == 0)
+            {
+                poolThread->thread->quit();
+            }
+
+            return;
+        }
+    }
+}
+
+void Core::restartStockExchange(const TradingCatCommon::StockExchangeID &stockExchangeId)
+{
+    if (!_isStarted)
+    {
+        return;
+    }
+
+    const auto it_stockExchangeThread = std::find_if(_stockExchangeThreadList.begin(), _stockExchangeThreadList.end(),
+        [&stockExchangeId](const PStockExchangeThread& stockExchangeThread)
+        {
+            return stockExchangeThread->stockExchangeId == stockExchangeId;
+        });
+
+    if (it_stockExchangeThread == _stockExchangeThreadList.end())
+    {
+        return;
+    }
+
+    auto& stockExchangeThread = *it_stockExchangeThread;
+    if (!stockExchangeThread->isRestarting)
+    {
+        return;
+    }
+
+    const auto& stockExchangeConfigList = _cnf->stockExchangeConfigList();
+    const auto it_stockExchangeConfig = std::find_if(stockExchangeConfigList.begin(), stockExchangeConfigList.end(),
+        [&stockExchangeId](const StockExchange::StockExchangeConfig& stockExchangeConfig)
+        {
+            return StockExchangeID(stockExchangeConfig.type) == stockExchangeId;
+        });
+
+    Q_ASSERT(it_stockExchangeConfig != stockExchangeConfigList.end());
+
+    stockExchangeThread->isRestarting = false;
+    stockExchangeThread->lastRestartTime = QDateTime::currentMSecsSinceEpoch();
+
+    // коннектор с ошибкой удален, новый запускается с нуля, как при старте сервера
+    makeStockExchangeSource(*stockExchangeThread, *it_stockExchangeConfig);
+
+    QObject* const stockExchange = stockExchangeThread->source();
+    Q_CHECK_PTR(stockExchange);
+
+    stockExchange->moveToThread(stockExchangeThread->thread);
+
+    // состояние, построенное по свечам старого коннектора, сбрасывается до запуска нового
+    if (stockExchangeThread->stream)
+    {
+        QMetaObject::invokeMethod(stockExchangeThread->stream.get(), "reset", Qt::QueuedConnection);
+    }
+    if (stockExchangeThread->aggregator)
+    {
+        QMetaObject::invokeMethod(stockExchangeThread->aggregator.get(), "reset", Qt::QueuedConnection);
+    }
+    QMetaObject::invokeMethod(stockExchangeThread->gapDetector.get(), "reset", Qt::QueuedConnection);
+
+    if (stockExchangeThread->backfillPacer)
+    {
+        stockExchangeThread->backfillPacer->start();
+    }
+
+    connectStockExchange(*stockExchangeThread);
+
+    QMetaObject::invokeMethod(stockExchange, "start", Qt::QueuedConnection);
+
+    _stockExchangeMonitor->restarted(stockExchangeId);
+
+    _loger->sendLogMsg(MSG_CODE::INFORMATION_CODE, QString("Stock exchange %1 is restarted").arg(stockExchangeId.toString()));
+}
+
+void Core::gapDetected(const TradingCatCommon::StockExchangeID &stockExchangeId, const TradingCatCommon::KLineID &klineId, qint64 from, qint64 to)
+{
+    const auto it_stockExchangeThread = std::find_if(_stockExchangeThreadList.begin(), _stockExchangeThreadList.end(),
+        [&stockExchangeId](const PStockExchangeThread& stockExchangeThread)
+        {
+            return stockExchangeThread->stockExchangeId == stockExchangeId;
+        });
+
+    if (it_stockExchangeThread == _stockExchangeThreadList.end())
+    {
+        return;
+    }
+
+    auto& stockExchangeThread = *it_stockExchangeThread;
+    if (!stockExchangeThread->backfillPacer)
+    {
+        return;
+    }
+
+    // старшие интервалы строятся локально - с биржи дозагружаются только минутные свечи
+    if (stockExchangeThread->isAggregated && klineId.type != KLineType::MIN1)
+    {
+        return;
+    }
+
+    _loger->sendLogMsg(MSG_CODE::WARNING_CODE, QString("Stock exchange %1: missed klines %2 from %3 to %4. Request backfill")
+                                                   .arg(stockExchangeId.toString())
+                                                   .arg(klineId.toString())
+                                                   .arg(QDateTime::fromMSecsSinceEpoch(from).toString(DATETIME_FORMAT))
+                                                   .arg(QDateTime::fromMSecsSinceEpoch(to).toString(DATETIME_FORMAT)));
+
+    stockExchangeThread->backfillPacer->loadKLinesRequest(klineId, from, to);
+}
+
+void Core::archiveKLines(const TradingCatCommon::StockExchangeID &stockExchangeId, const TradingCatCommon::PKLinesList &klines)
+{
+    const auto it_stockExchangeThread = std::find_if(_stockExchangeThreadList.begin(), _stockExchangeThreadList.end(),
+        [&stockExchangeId](const PStockExchangeThread& stockExchangeThread)
+        {
+            return stockExchangeThread->stockExchangeId == stockExchangeId;
+        });
+
+    if (it_stockExchangeThread == _stockExchangeThreadList.end())
+    {
+        return;
+    }
+
+    // архив загружается при запуске потока данных, до получения первых свечей с биржи
+    QMetaObject::invokeMethod((*it_stockExchangeThread)->gapDetector.get(), "addArchiveKLines", Qt::QueuedConnection,
+                              Q_ARG(TradingCatCommon::StockExchangeID, stockExchangeId), Q_ARG(TradingCatCommon::PKLinesList, klines));
+}
+
+void Core::statisticTimerTimeout()
+{
+    for (const auto queue: {_dataThread->queue.get(), _detectorThread->queue.get()})
+    {
+        const auto metrics = queue->metrics();
+
+        _loger->sendLogMsg(MSG_CODE::INFORMATION_CODE, QString("KLines queue %1: depth: %2 max depth: %3 pushed: %4 coalesced: %5 compacted: %6 dropped: %7 outdated: %8")
+                                                           .arg(queue->name())
+                                                           .arg(metrics.depth)
+                                                           .arg(metrics.maxDepth)
+                                                           .arg(metrics.pushed)
+                                                           .arg(metrics.coalesced)
+                                                           .arg(metrics.compacted)
+                                                           .arg(metrics.dropped)
+                                                           .arg(metrics.outdated));
+    }
+
+    if (_dataThread->store)
+    {
+        _loger->sendLogMsg(MSG_CODE::INFORMATION_CODE, QString("KLines store /data/klines (TradingData is not counted): klines: %1 memory: %2 KB evicted: %3")
+                                                           .arg(_dataThread->store->klinesCount())
+                                                           .arg(_dataThread->store->memoryUsage() / 1024)
+                                                           .arg(_dataThread->store->evictedKLines()));
+    }
+
+    KLinesGapDetector::Metrics gapMetrics;
+    for (const auto& stockExchangeThread: _stockExchangeThreadList)
+    {
+        const auto metrics = stockExchangeThread->gapDetector->metrics();
+        gapMetrics.gaps += metrics.gaps;
+        gapMetrics.missedKLines += metrics.missedKLines;
+    }
+    _loger->sendLogMsg(MSG_CODE::INFORMATION_CODE, QString("KLines gaps: gaps: %1 missed klines: %2")
+                                                       .arg(gapMetrics.gaps)
+                                                       .arg(gapMetrics.missedKLines));
+
+    const auto poolStatistic = KLinesPool::statistic();
+    _loger->sendLogMsg(MSG_CODE::INFORMATION_CODE, QString("KLines pool: allocated: %1 reused: %2 returned: %3 released: %4")
+                                                       .arg(poolStatistic.allocated)
+                                                       .arg(poolStatistic.reused)
+                                                       .arg(poolStatistic.returned)
+                                                       .arg(poolStatistic.released));
+
+    for (const auto& stockExchangeThread: _stockExchangeThreadList)
+    {
+        if (!stockExchangeThread->backfillPacer)
+        {
+            continue;
+        }
+
+        const auto backfillPacerMetrics = stockExchangeThread->backfillPacer->metrics();
+        _loger->sendLogMsg(MSG_CODE::INFORMATION_CODE, QString("Backfill pacer %1: pending: %2 sent: %3 merged: %4")
+                                                           .arg(stockExchangeThread->stockExchangeId.toString())
+                                                           .arg(backfillPacerMetrics.pending)
+                                                           .arg(backfillPacerMetrics.sent)
+                                                           .arg(backfillPacerMetrics.merged));
+    }
+
+    for (const auto& stockExchangeThread: _stockExchangeThreadList)
+    {
+        for (const auto& proxyStatistic: _streamProxyPool->statistic(stockExchangeThread->stockExchangeId))
+        {
+            if (proxyStatistic.requests == 0)
+            {
+                continue;
+            }
+
+            _loger->sendLogMsg(MSG_CODE::INFORMATION_CODE, QString("Stream proxy %1 for %2: latency: %3 ms error rate: %4 requests: %5 errors: %6%7")
+                                                               .arg(proxyStatistic.proxy)
+                                                               .arg(stockExchangeThread->stockExchangeId.toString())
+                                                               .arg(qRound64(proxyStatistic.latency))
+                                                               .arg(proxyStatistic.errorRate, 0, 'f', 2)
+                                                               .arg(proxyStatistic.requests)
+                                                               .arg(proxyStatistic.errors)
+                                                               .arg(proxyStatistic.isEjected ? " ejected" : ""));
+        }
+    }
+
+    const auto currentTime = QDateTime::currentMSecsSinceEpoch();
+    for (const auto& counters: _stockExchangeMonitor->counters())
+    {
+        _loger->sendLogMsg(MSG_CODE::INFORMATION_CODE, QString("Stock exchange monitor %1: %2 batches: %3 klines: %4 lag: %5 s warnings: %6 errors: %7 restarts: %8")
+                                                           .arg(counters.stockExchangeId.toString())
+                                                           .arg(counters.isRunning ? "running" : "restarting")
+                                                           .arg(counters.batches)
+                                                           .arg(counters.klines)
+                                                           .arg(counters.lag(currentTime) >= 0 ? QString::number(counters.lag(currentTime) / 1000) : QString("-"))
+                                                           .arg(counters.warnings)
+                                                           .arg(counters.errors)
+                                                           .arg(counters.restarts));
+    }
+
+    for (const auto& stockExchangeStatistic: _latencyTracer->statistic())
+    {
+        QStringList hops;
+        for (qsizetype hop = 0; hop < LatencyTracer::HOPS_COUNT; ++hop)
+        {
+            const auto& histogram = stockExchangeStatistic.hops[hop];
+            hops.push_back(QString("%1: %2/%3/%4")
+                               .arg(LatencyTracer::hopName(static_cast<LatencyTracer::Hop>(hop)))
+                               .arg(histogram.percentile(0.5))
+                               .arg(histogram.percentile(0.99))
+                               .arg(histogram.max));
+        }
+
+        _loger->sendLogMsg(MSG_CODE::INFORMATION_CODE, QString("Latency %1 (p50/p99/max ms from kline close): %2")
+                                                           .arg(stockExchangeStatistic.stockExchangeId.toString())
+                                                           .arg(hops.join(" ")));
+    }
+}
+
 std::unique_ptr<IStockExchange> Core::makeStockEchange(const StockExchange::StockExchangeConfig& stockExchangeConfig) const
 {
     // Spot
@@ -405,6 +959,113 @@ std::unique_ptr<IStockExchange> Core::makeStockEchange(const StockExchange::Stoc
     return nullptr;
 }
 
+void Core::makeStockExchangeSource(StockExchangeThread &stockExchangeThread, const StockExchange::StockExchangeConfig &stockExchangeConfig) const
+{
+    // воспроизведение записи вместо подключения к бирже
+    const auto replayFileName = _cnf->replayFileName(stockExchangeConfig.type);
+    if (!replayFileName.isEmpty())
+    {
+        stockExchangeThread.replay = std::make_unique<KLinesReplay>(stockExchangeThread.stockExchangeId, replayFileName, _cnf->replaySpeed(stockExchangeConfig.type));
+    }
+    else
+    {
+        stockExchangeThread.stockExchange = makeStockEchange(stockExchangeConfig);
+    }
+}
+
+void Core::connectStockExchange(StockExchangeThread &stockExchangeThread)
+{
+    QObject* const stockExchange = stockExchangeThread.source();
+    Q_CHECK_PTR(stockExchange);
+
+    connect(stockExchange, SIGNAL(finished()), SLOT(finishedStockExchange()), Qt::DirectConnection);
+    connect(this, SIGNAL(stopAll()), stockExchange, SLOT(stop()), Qt::QueuedConnection);
+
+    connect(stockExchange, SIGNAL(errorOccurred(const TradingCatCommon::StockExchangeID&, Common::EXIT_CODE, const QString&)),
+            SLOT(errorOccurredStockExchange(const TradingCatCommon::StockExchangeID&, Common::EXIT_CODE, const QString&)), Qt::QueuedConnection);
+    connect(stockExchange, SIGNAL(sendLogMsg(const TradingCatCommon::StockExchangeID&, Common::MSG_CODE, const QString&)),
+            SLOT(sendLogMsgStockExchange(const TradingCatCommon::StockExchangeID&, Common::MSG_CODE, const QString&)), Qt::QueuedConnection);
+
+    connect(stockExchange, SIGNAL(sendLogMsg(const TradingCatCommon::StockExchangeID&, Common::MSG_CODE, const QString&)),
+            _stockExchangeMonitor.get(), SLOT(sendLogMsg(const TradingCatCommon::StockExchangeID&, Common::MSG_CODE, const QString&)), Qt::DirectConnection);
+    connect(stockExchange, SIGNAL(getKLines(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesList&)),
+            _stockExchangeMonitor.get(), SLOT(getKLines(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesList&)), Qt::DirectConnection);
+    connect(stockExchange, SIGNAL(getKLinesID(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesIDList&)),
+            _stockExchangeMonitor.get(), SLOT(getKLinesID(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesIDList&)), Qt::DirectConnection);
+
+    if (stockExchangeThread.recorder)
+    {
+        connect(stockExchange, SIGNAL(getKLinesID(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesIDList&)),
+                stockExchangeThread.recorder.get(), SLOT(addKLinesID(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesIDList&)), Qt::DirectConnection);
+        connect(stockExchange, SIGNAL(getKLines(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesList&)),
+                stockExchangeThread.recorder.get(), SLOT(addKLines(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesList&)), Qt::DirectConnection);
+    }
+
+    if (stockExchangeThread.stream)
+    {
+        connect(stockExchange, SIGNAL(getKLinesID(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesIDList&)),
+                stockExchangeThread.stream.get(), SLOT(addKLinesID(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesIDList&)), Qt::DirectConnection);
+        connect(stockExchange, SIGNAL(getKLines(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesList&)),
+                stockExchangeThread.stream.get(), SLOT(addKLines(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesList&)), Qt::DirectConnection);
+    }
+
+    if (stockExchangeThread.aggregator)
+    {
+        if (!stockExchangeThread.stream)
+        {
+            connect(stockExchange, SIGNAL(getKLines(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesList&)),
+                    stockExchangeThread.aggregator.get(), SLOT(addKLines(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesList&)), Qt::DirectConnection);
+        }
+        connect(stockExchange, SIGNAL(getKLinesID(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesIDList&)),
+                stockExchangeThread.aggregator.get(), SLOT(addKLinesID(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesIDList&)), Qt::DirectConnection);
+    }
+
+    if (stockExchangeThread.backfillPacer)
+    {
+        connect(stockExchangeThread.backfillPacer.get(), SIGNAL(loadKLines(const TradingCatCommon::KLineID&, qint64, qint64)),
+                stockExchange, SLOT(loadKLines(const TradingCatCommon::KLineID&, qint64, qint64)), Qt::QueuedConnection);
+    }
+
+    // без потока и агрегатора свечи идут потребителям прямо от биржи
+    if (!stockExchangeThread.stream && !stockExchangeThread.aggregator)
+    {
+        connectKLinesSource(stockExchangeThread, stockExchange);
+    }
+    if (!stockExchangeThread.aggregator)
+    {
+        connectKLinesIdSource(stockExchangeThread, stockExchange);
+    }
+}
+
+void Core::connectKLinesSource(StockExchangeThread &stockExchangeThread, QObject *klinesSource)
+{
+    Q_CHECK_PTR(klinesSource);
+
+    connect(klinesSource, SIGNAL(getKLines(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesList&)),
+            stockExchangeThread.gapDetector.get(), SLOT(addKLines(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesList&)), Qt::DirectConnection);
+
+    // get new data. Свечи идут через ограниченные очереди в потоках потребителей
+    connect(klinesSource, SIGNAL(getKLines(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesList&)),
+            _latencyTracer.get(), SLOT(receivedKLines(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesList&)), Qt::DirectConnection);
+    connect(klinesSource, SIGNAL(getKLines(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesList&)),
+            _dataThread->queue.get(), SLOT(push(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesList&)), Qt::DirectConnection);
+    connect(klinesSource, SIGNAL(getKLines(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesList&)),
+            _detectorThread->queue.get(), SLOT(push(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesList&)), Qt::DirectConnection);
+}
+
+void Core::connectKLinesIdSource(StockExchangeThread &stockExchangeThread, QObject *klinesIdSource)
+{
+    Q_CHECK_PTR(klinesIdSource);
+
+    // индексы ID назначаются всему списку до прихода свечей в потоке биржи
+    connect(klinesIdSource, SIGNAL(getKLinesID(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesIDList&)),
+            stockExchangeThread.gapDetector.get(), SLOT(addKLinesID(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesIDList&)), Qt::DirectConnection);
+    connect(klinesIdSource, SIGNAL(getKLinesID(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesIDList&)),
+            _dataThread->data.get(), SLOT(getKLinesID(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesIDList&)), Qt::QueuedConnection);
+    connect(klinesIdSource, SIGNAL(getKLinesID(const TradingCatCommon::StockExchangeID&, const TradingCatCommon::PKLinesIDList&)),
+            _dataThread->snapshot.get(), SLOT(refresh()), Qt::QueuedConnection);
+}
+
 void Core::makeProxyList()
 {
     _proxyList.clear();
@@ -420,6 +1081,8 @@ void Core::makeProxyList()
 
         _proxyList.emplace_back(std::move(proxy));
     }
+
+    _streamProxyPool = std::make_unique<StreamProxyPool>(_proxyList);
 }
 
 QString Core::errorString()
@@ -2,10 +2,13 @@
 
 //STL
 #include <memory>
+#include <atomic>
+#include <vector>
 
 //QT
 #include <QObject>
 #include <QThread>
+#include <QTimer>
 
 //My
 #include <Common/tdbloger.h>
@@ -19,6 +22,20 @@
 
 #include "userscore.h"
 #include "appserver.h"
+#include "klinesqueue.h"
+#include "klinesstore.h"
+#include "klinesarchive.h"
+#include "klinesaggregator.h"
+#include "klinesstream.h"
+#include "demandtracker.h"
+#include "klinesrecorder.h"
+#include "klinesreplay.h"
+#include "backfillpacer.h"
+#include "streamproxypool.h"
+#include "latencytracer.h"
+#include "stockexchangemonitor.h"
+#include "klinesgapdetector.h"
+#include "tradingdatasnapshot.h"
 #include "config.h"
 
 class Core final
@@ -46,6 +63,7 @@ private slots:
 
     void errorOccurredStockExchange(const TradingCatCommon::StockExchangeID& id, Common::EXIT_CODE errorCode, const QString& errorString);
     void sendLogMsgStockExchange(const TradingCatCommon::StockExchangeID& id, Common::MSG_CODE category, const QString& msg);
+    void finishedStockExchange();
 
     void errorOccurredTradingData(Common::EXIT_CODE errorCode, const QString& errorString);
     void sendLogMsgTradingData(Common::MSG_CODE category, const QString& msg);
@@ -60,9 +78,34 @@ private slots:
     void errorOccurredAppServer(Common::EXIT_CODE errorCode, const QString& errorString);
     void sendLogMsgAppServer(Common::MSG_CODE category, const QString& msg);
 
+    void sendLogMsgKLinesQueue(Common::MSG_CODE category, const QString& msg);
+    void sendLogMsgKLinesStore(Common::MSG_CODE category, const QString& msg);
+    void sendLogMsgKLinesArchive(Common::MSG_CODE category, const QString& msg);
+
+    void gapDetected(const TradingCatCommon::StockExchangeID& stockExchangeId, const TradingCatCommon::KLineID& klineId, qint64 from, qint64 to);
+    void archiveKLines(const TradingCatCommon::StockExchangeID& stockExchangeId, const TradingCatCommon::PKLinesList& klines);
+
+    void statisticTimerTimeout();
+
 private:
+    struct StockExchangeThread;
+
     std::unique_ptr<StockExchange::IStockExchange> makeStockEchange(const StockExchange::StockExchangeConfig& stockExchangeConfig) const;
     void makeProxyList();
+    void restartStockExchange(const TradingCatCommon::StockExchangeID& stockExchangeId);
+
+    /*!
+        Создает источник свечей биржи: коннектор или воспроизведение записи
+    */
+    void makeStockExchangeSource(StockExchangeThread& stockExchangeThread, const StockExchange::StockExchangeConfig& stockExchangeConfig) const;
+
+    /*!
+        Подключает сигналы источника свечей биржи к серверу и к уже созданным обработчикам биржи.
+            Вызывается при запуске и после пересоздания коннектора при перезапуске
+    */
+    void connectStockExchange(StockExchangeThread& stockExchangeThread);
+    void connectKLinesSource(StockExchangeThread& stockExchangeThread, QObject* klinesSource);
+    void connectKLinesIdSource(StockExchangeThread& stockExchangeThread, QObject* klinesIdSource);
 
 private:
     Config *_cnf = nullptr;                            //Конфигурация
@@ -71,18 +114,53 @@ private:
     QString _errorString;
 
     Common::ProxyList _proxyList;
+    std::unique_ptr<StreamProxyPool> _streamProxyPool; ///< выбор прокси для WebSocket-потоков свечей. REST-коннекторы получают _proxyList
+    std::unique_ptr<DemandTracker> _demandTracker; ///< спрос на свечи по сессиям онлайн. nullptr - DemandDrivenStreams выключен
+    std::unique_ptr<LatencyTracer> _latencyTracer;
+    std::unique_ptr<StockExchangeMonitor> _stockExchangeMonitor;
 
     struct StockExchangeThread
     {
-        std::unique_ptr<StockExchange::IStockExchange> stockExchange;
-        std::unique_ptr<QThread> thread;
+        TradingCatCommon::StockExchangeID stockExchangeId;
+        bool isAggregated = false;                 ///< старшие интервалы строятся из минутных свечей
+        std::unique_ptr<StockExchange::IStockExchange> stockExchange; ///< коннектор биржи. nullptr - воспроизводится запись или биржа ожидает перезапуска
+        std::unique_ptr<KLinesReplay> replay;      ///< воспроизведение записи вместо коннектора. nullptr - коннектор биржи или биржа ожидает перезапуска
+        std::unique_ptr<KLinesAggregator> aggregator;
+        std::unique_ptr<KLinesStream> stream;      ///< WebSocket-поток закрытых свечей. nullptr - только REST
+        std::unique_ptr<KLinesRecorder> recorder;  ///< запись пакетов биржи. nullptr - запись отключена
+        std::unique_ptr<BackfillPacer> backfillPacer; ///< темп запросов дозагрузки. nullptr - дозагрузка отключена (Backfill=false)
+        std::unique_ptr<KLinesGapDetector> gapDetector; ///< поиск пропусков до очередей потребителей
+        QThread* thread = nullptr;                 ///< поток из пула _stockExchangePool
+
+        bool isRestarting = false;                 ///< коннектор удален после ошибки, биржа ожидает перезапуска
+        qint64 restartInterval = 0;                ///< задержка последнего перезапуска, мс
+        qint64 lastRestartTime = 0;
+
+        /*!
+            Источник свечей биржи: коннектор или воспроизведение записи. Подключается по именам сигналов и слотов
+        */
+        QObject* source() const noexcept
+        {
+            return stockExchange ? static_cast<QObject*>(stockExchange.get()) : static_cast<QObject*>(replay.get());
+        }
     };
     using PStockExchangeThread = std::unique_ptr<StockExchangeThread>;
     std::list<PStockExchangeThread> _stockExchangeThreadList;
 
+    struct StockExchangePoolThread
+    {
+        std::unique_ptr<QThread> thread;
+        std::atomic<qsizetype> running = 0;        ///< количество работающих в потоке бирж
+    };
+    std::vector<std::unique_ptr<StockExchangePoolThread>> _stockExchangePool;
+
     struct DataThread
     {
         std::unique_ptr<TradingCatCommon::TradingData> data;
+        std::unique_ptr<KLinesQueue> queue;
+        std::unique_ptr<KLinesStore> store;
+        std::unique_ptr<KLinesArchive> archive;
+        std::unique_ptr<TradingDataSnapshot> snapshot;
         std::unique_ptr<QThread> thread;
     };
     std::unique_ptr<DataThread> _dataThread;
@@ -104,10 +182,13 @@ private:
     struct DetectorThread
     {
         std::unique_ptr<TradingCatCommon::Detector> detector;
+        std::unique_ptr<KLinesQueue> queue;
         std::unique_ptr<QThread> thread;
     };
     std::unique_ptr<DetectorThread> _detectorThread;
 
+    QTimer* _statisticTimer = nullptr;
+
     bool _isStarted = false;
 
 }; //class Core
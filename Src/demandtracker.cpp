@@ -0,0 +1,61 @@
+//Qt
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+
+#include "demandtracker.h"
+
+using namespace TradingCatCommon;
+
+DemandTracker::DemandTracker(QObject* parent /* = nullptr */)
+    : QObject{parent}
+{
+    qRegisterMetaType<TradingCatCommon::UserConfig>("TradingCatCommon::UserConfig");
+}
+
+bool DemandTracker::isDemanded() const noexcept
+{
+    return _isDemanded;
+}
+
+qsizetype DemandTracker::filtersCount(const TradingCatCommon::UserConfig &config)
+{
+    const auto json = QJsonDocument::fromJson(config.toJson().toUtf8()).object();
+
+    return json.value("Filter").toObject().value("Filters").toArray().size();
+}
+
+void DemandTracker::userOnline(qint64 sessionId, const TradingCatCommon::UserConfig &config)
+{
+    // при изменении конфигурации сессия приходит повторно
+    if (filtersCount(config) > 0)
+    {
+        _watchingSessions.insert(sessionId);
+    }
+    else
+    {
+        _watchingSessions.remove(sessionId);
+    }
+
+    update();
+}
+
+void DemandTracker::userOffline(qint64 sessionId)
+{
+    _watchingSessions.remove(sessionId);
+
+    update();
+}
+
+void DemandTracker::update()
+{
+    const auto isDemanded = !_watchingSessions.isEmpty();
+    if (isDemanded == _isDemanded)
+    {
+        return;
+    }
+
+    _isDemanded = isDemanded;
+
+    emit demandChanged(_isDemanded);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+//Qt
+#include <QObject>
+#include <QSet>
+
+//My
+#include <TradingCatCommon/filter.h>
+
+///////////////////////////////////////////////////////////////////////////////
+///     The DemandTracker class - спрос на свечи по сессиям онлайн. Фильтры пользователей
+///         задают только пороги (Delta, Volume и т.п.) и не ограничивают биржи, символы и
+///         интервалы, поэтому фильтр может сработать на любой свече, а сессия без фильтров -
+///         ни на одной. Спрос есть, пока онлайн хотя бы одна сессия с фильтром. Без спроса
+///         WebSocket-потоки снимают подписки и свечи обновляются только REST-опросом
+///         коннекторов, который нужен TradingData, архиву и /data/klines.
+///         Объект живет в потоке Core
+///
+class DemandTracker final
+    : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DemandTracker(QObject* parent = nullptr);
+    ~DemandTracker() override = default;
+
+    bool isDemanded() const noexcept;
+
+    /*!
+        Количество фильтров в конфигурации пользователя
+    */
+    static qsizetype filtersCount(const TradingCatCommon::UserConfig& config);
+
+public slots:
+    /*!
+        Сессия вошла или изменила конфигурацию
+    */
+    void userOnline(qint64 sessionId, const TradingCatCommon::UserConfig& config);
+    void userOffline(qint64 sessionId);
+
+signals:
+    void demandChanged(bool isDemanded);
+
+private:
+    Q_DISABLE_COPY_MOVE(DemandTracker);
+
+    void update();
+
+private:
+    QSet<qint64> _watchingSessions;   ///< сессии хотя бы с одним фильтром
+    bool _isDemanded = false;
+};
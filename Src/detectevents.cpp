@@ -0,0 +1,85 @@
+#include "idinterner.h"
+#include "detectevents.h"
+
+using namespace TradingCatCommon;
+
+quint64 DetectEvents::key(const TradingCatCommon::Detector::KLineDetectData &detectData)
+{
+    Q_CHECK_PTR(detectData.history);
+    Q_ASSERT(!detectData.history->empty());
+
+    // индексы IDInterner плотные: старшие 32 бита - свеча биржи, затем 24 бита - биржа, младшие 8 бит - тип фильтра
+    const auto stockExchangeIndex = IDInterner::stockExchange(detectData.stockExchangeId);
+    const auto klineIndex = IDInterner::kline(stockExchangeIndex, detectData.history->back()->id);
+    const auto filterType = static_cast<quint64>(detectData.filterActivate);
+
+    Q_ASSERT(stockExchangeIndex < (1u << 24));
+    Q_ASSERT(filterType < (1u << 8));
+
+    return (static_cast<quint64>(klineIndex) << 32) | (static_cast<quint64>(stockExchangeIndex) << 8) | filterType;
+}
+
+DetectEvents::AddResult DetectEvents::add(const TradingCatCommon::Detector::PKLineDetectData &detectData, qint64 cooldown, qint64 currentTime)
+{
+    Q_CHECK_PTR(detectData);
+
+    const auto detectKey = key(*detectData);
+
+    // событие по этой свече и фильтру еще не отдано клиенту - заменяем его более свежим
+    for (auto& detected: _klinesDetectedList.detected)
+    {
+        if (key(*detected) == detectKey)
+        {
+            detected = detectData;
+
+            return AddResult::REPLACED;
+        }
+    }
+
+    if (static_cast<qsizetype>(_klinesDetectedList.detected.size()) > MAX_EVENTS)
+    {
+        _klinesDetectedList.isFull = true;
+
+        return AddResult::FULL;
+    }
+
+    // событие уже отдавалось клиенту недавно - пропускаем
+    const auto it_lastDetect = _lastDetect.find(detectKey);
+    if (it_lastDetect != _lastDetect.end() && currentTime - it_lastDetect->second < cooldown)
+    {
+        return AddResult::SUPPRESSED;
+    }
+
+    _klinesDetectedList.detected.emplace_back(detectData);
+
+    return AddResult::ADDED;
+}
+
+void DetectEvents::delivered(qint64 currentTime)
+{
+    for (const auto& detectData: _klinesDetectedList.detected)
+    {
+        _lastDetect.insert_or_assign(key(*detectData), currentTime);
+    }
+
+    _klinesDetectedList.clear();
+}
+
+void DetectEvents::expire(qint64 cooldown, qint64 currentTime)
+{
+    std::erase_if(_lastDetect,
+        [cooldown, currentTime](const auto& lastDetect)
+        {
+            return currentTime - lastDetect.second >= cooldown;
+        });
+}
+
+void DetectEvents::clearPending()
+{
+    _klinesDetectedList.clear();
+}
+
+const TradingCatCommon::Detector::KLinesDetectedList &DetectEvents::klinesDetectedList() const noexcept
+{
+    return _klinesDetectedList;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+//STL
+#include <unordered_map>
+
+//Qt
+#include <QtGlobal>
+
+//My
+#include <TradingCatCommon/detector.h>
+
+///////////////////////////////////////////////////////////////////////////////
+///     The DetectEvents class - события детектора одной сессии до отдачи клиенту.
+///         Неотданное событие по той же свече и фильтру заменяется более свежим.
+///         Событие, отданное клиенту недавно, подавляется на время cooldown.
+///         Не потокобезопасен - защищается блокировкой сессий UsersCore
+///
+class DetectEvents final
+{
+public:
+    enum class AddResult: quint8
+    {
+        ADDED = 0,       ///< событие добавлено
+        REPLACED = 1,    ///< заменило неотданное событие той же свечи и фильтра
+        SUPPRESSED = 2,  ///< событие уже отдавалось клиенту в течение cooldown
+        FULL = 3         ///< список неотданных событий заполнен
+    };
+
+    static constexpr qsizetype MAX_EVENTS = 5;
+
+public:
+    DetectEvents() = default;
+
+    /*!
+        Ключ события: биржа, свеча и тип сработавшего фильтра
+    */
+    static quint64 key(const TradingCatCommon::Detector::KLineDetectData& detectData);
+
+    /*!
+        Добавляет событие детектора
+        @param cooldown - мс, минимальный интервал между отдачей клиенту событий с одним ключом. 0 - события не подавляются
+    */
+    AddResult add(const TradingCatCommon::Detector::PKLineDetectData& detectData, qint64 cooldown, qint64 currentTime);
+
+    /*!
+        События отданы клиенту: от этого момента отсчитывается cooldown, список очищается
+    */
+    void delivered(qint64 currentTime);
+
+    /*!
+        Забывает время отдачи событий, у которых cooldown истек
+    */
+    void expire(qint64 cooldown, qint64 currentTime);
+
+    /*!
+        Сбрасывает неотданные события. Время отдачи событий сохраняется
+    */
+    void clearPending();
+
+    const TradingCatCommon::Detector::KLinesDetectedList& klinesDetectedList() const noexcept;
+
+private:
+    TradingCatCommon::Detector::KLinesDetectedList _klinesDetectedList;
+    std::unordered_map<quint64, qint64> _lastDetect; ///< время последней отдачи события клиенту по ключу
+};
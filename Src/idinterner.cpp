@@ -0,0 +1,209 @@
+//STL
+#include <unordered_map>
+#include <vector>
+#include <array>
+#include <memory>
+#include <atomic>
+
+//Qt
+#include <QMutex>
+
+#include "idinterner.h"
+
+using namespace TradingCatCommon;
+
+static const quint32 MAX_STOCK_EXCHANGES = 256; // таблицы KLineID бирж создаются заранее и не перемещаются
+
+namespace
+{
+
+template <typename ID>
+struct InternData
+{
+    std::unordered_map<ID, quint32> indexes;
+    std::vector<ID> ids;
+};
+
+/*!
+    Таблица ID. Опубликованная таблица не изменяется: новые ID добавляются в копию,
+        которая заменяет ее под блокировкой записи. Потоки держат ссылку на последнюю
+        полученную копию в Cache и обращаются к блокировке только после замены таблицы
+*/
+template <typename ID>
+class InternTable
+{
+public:
+    using PData = std::shared_ptr<const InternData<ID>>;
+
+    struct Cache
+    {
+        quint64 version = 0;
+        PData data;
+    };
+
+public:
+    InternTable()
+        : _data(std::make_shared<const InternData<ID>>())
+    {
+    }
+
+    const InternData<ID>& data(Cache& cache) const
+    {
+        if (cache.version != _version.load(std::memory_order_acquire))
+        {
+            QMutexLocker locker(&_mutex);
+
+            cache.data = _data;
+            cache.version = _version.load(std::memory_order_relaxed);
+        }
+
+        return *cache.data;
+    }
+
+    quint32 find(const ID& id, Cache& cache) const
+    {
+        const auto& data = this->data(cache);
+
+        const auto it_indexes = data.indexes.find(id);
+
+        return it_indexes != data.indexes.end() ? it_indexes->second : IDInterner::NO_INDEX;
+    }
+
+    quint32 index(const ID& id, Cache& cache)
+    {
+        const auto result = find(id, cache);
+        if (result != IDInterner::NO_INDEX)
+        {
+            return result;
+        }
+
+        add(&id, &id + 1);
+
+        return find(id, cache);
+    }
+
+    /*!
+        Добавляет ID диапазона одной заменой таблицы
+    */
+    template <typename Iterator>
+    void add(Iterator begin, Iterator end)
+    {
+        QMutexLocker locker(&_mutex);
+
+        std::shared_ptr<InternData<ID>> newData;
+        for (auto it_id = begin; it_id != end; ++it_id)
+        {
+            const auto& currentData = newData ? *newData : *_data;
+            if (currentData.indexes.contains(*it_id))
+            {
+                continue;
+            }
+
+            if (!newData)
+            {
+                newData = std::make_shared<InternData<ID>>(*_data);
+            }
+
+            newData->indexes.emplace(*it_id, static_cast<quint32>(newData->ids.size()));
+            newData->ids.push_back(*it_id);
+        }
+
+        if (!newData)
+        {
+            return;
+        }
+
+        _data = std::move(newData);
+        _version.fetch_add(1, std::memory_order_release);
+    }
+
+private:
+    mutable QMutex _mutex;
+    PData _data;                           ///< изменяется только под _mutex
+    std::atomic<quint64> _version = 1;
+};
+
+using StockExchangesTable = InternTable<TradingCatCommon::StockExchangeID>;
+using KLinesTable = InternTable<TradingCatCommon::KLineID>;
+using KLinesTables = std::array<KLinesTable, MAX_STOCK_EXCHANGES>; ///< по индексу биржи
+
+thread_local StockExchangesTable::Cache stockExchangesCache;
+thread_local std::array<KLinesTable::Cache, MAX_STOCK_EXCHANGES> klinesCaches; ///< по индексу биржи
+
+} // namespace
+
+Q_GLOBAL_STATIC(StockExchangesTable, stockExchangesTable);
+Q_GLOBAL_STATIC(KLinesTables, klinesTables);
+
+quint32 IDInterner::stockExchange(const TradingCatCommon::StockExchangeID &stockExchangeId)
+{
+    const auto result = stockExchangesTable->index(stockExchangeId, stockExchangesCache);
+    if (result >= MAX_STOCK_EXCHANGES)
+    {
+        qFatal("IDInterner: too many stock exchanges");
+    }
+
+    return result;
+}
+
+quint32 IDInterner::kline(quint32 stockExchangeIndex, const TradingCatCommon::KLineID &klineId)
+{
+    Q_ASSERT(stockExchangeIndex < MAX_STOCK_EXCHANGES);
+
+    return (*klinesTables)[stockExchangeIndex].index(klineId, klinesCaches[stockExchangeIndex]);
+}
+
+void IDInterner::klines(quint32 stockExchangeIndex, const TradingCatCommon::KLinesIDList &klinesIdList)
+{
+    Q_ASSERT(stockExchangeIndex < MAX_STOCK_EXCHANGES);
+
+    (*klinesTables)[stockExchangeIndex].add(klinesIdList.begin(), klinesIdList.end());
+}
+
+quint32 IDInterner::findStockExchange(const TradingCatCommon::StockExchangeID &stockExchangeId)
+{
+    return stockExchangesTable->find(stockExchangeId, stockExchangesCache);
+}
+
+quint32 IDInterner::findKLine(quint32 stockExchangeIndex, const TradingCatCommon::KLineID &klineId)
+{
+    if (stockExchangeIndex >= MAX_STOCK_EXCHANGES)
+    {
+        return NO_INDEX;
+    }
+
+    return (*klinesTables)[stockExchangeIndex].find(klineId, klinesCaches[stockExchangeIndex]);
+}
+
+TradingCatCommon::StockExchangeID IDInterner::stockExchangeId(quint32 index)
+{
+    const auto& data = stockExchangesTable->data(stockExchangesCache);
+    Q_ASSERT(index < data.ids.size());
+
+    return data.ids[index];
+}
+
+TradingCatCommon::KLineID IDInterner::klineId(quint32 stockExchangeIndex, quint32 index)
+{
+    Q_ASSERT(stockExchangeIndex < MAX_STOCK_EXCHANGES);
+
+    const auto& data = (*klinesTables)[stockExchangeIndex].data(klinesCaches[stockExchangeIndex]);
+    Q_ASSERT(index < data.ids.size());
+
+    return data.ids[index];
+}
+
+qsizetype IDInterner::stockExchangesCount()
+{
+    return static_cast<qsizetype>(stockExchangesTable->data(stockExchangesCache).ids.size());
+}
+
+qsizetype IDInterner::klinesCount(quint32 stockExchangeIndex)
+{
+    if (stockExchangeIndex >= MAX_STOCK_EXCHANGES)
+    {
+        return 0;
+    }
+
+    return static_cast<qsizetype>((*klinesTables)[stockExchangeIndex].data(klinesCaches[stockExchangeIndex]).ids.size());
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+//STL
+#include <limits>
+
+//Qt
+#include <QtGlobal>
+
+//My
+#include <TradingCatCommon/stockexchange.h>
+#include <TradingCatCommon/kline.h>
+
+///////////////////////////////////////////////////////////////////////////////
+///     The IDInterner class - глобальная таблица соответствия StockExchangeID и KLineID
+///         плотным 32-битным индексам. Индексы KLineID назначаются отдельно для каждой
+///         биржи, поэтому таблицы [биржа][KLineID] растут по числу свечей биржи, а не
+///         по числу свечей всех бирж. Индекс присваивается при первом обращении и не
+///         меняется до завершения программы. Внутренние таблицы сервера адресуются
+///         индексами, строковые ID нужны только при формировании ответов.
+///         Опубликованная таблица не изменяется: новые ID добавляются в копию, которая
+///         заменяет таблицу. Поиск идет по копии, сохраненной в потоке, и не блокируется,
+///         пока таблица не заменена. Поэтому ID списка свечей биржи добавляются одной
+///         заменой при получении списка - klines(), а не по одной свече.
+///         Потокобезопасен
+///
+class IDInterner final
+{
+public:
+    static constexpr quint32 NO_INDEX = std::numeric_limits<quint32>::max();
+
+public:
+    /*!
+        Индекс биржи. Присваивает новый индекс, если биржа встречается впервые
+    */
+    static quint32 stockExchange(const TradingCatCommon::StockExchangeID& stockExchangeId);
+
+    /*!
+        Индекс свечи в пределах биржи. Присваивает новый индекс, если KLineID встречается на бирже впервые
+        @param stockExchangeIndex - индекс биржи, полученный от stockExchange()
+    */
+    static quint32 kline(quint32 stockExchangeIndex, const TradingCatCommon::KLineID& klineId);
+
+    /*!
+        Присваивает индексы всем новым ID списка одной заменой таблицы биржи. Вызывается
+            при получении списка ID свечей, до прихода самих свечей
+        @param stockExchangeIndex - индекс биржи, полученный от stockExchange()
+    */
+    static void klines(quint32 stockExchangeIndex, const TradingCatCommon::KLinesIDList& klinesIdList);
+
+    /*!
+        Поиск индекса без добавления. Используется для ID из запросов клиентов
+        @return NO_INDEX - если ID еще не встречался
+    */
+    static quint32 findStockExchange(const TradingCatCommon::StockExchangeID& stockExchangeId);
+    static quint32 findKLine(quint32 stockExchangeIndex, const TradingCatCommon::KLineID& klineId);
+
+    /*!
+        Обратное преобразование индекса в ID. Индекс должен быть получен от IDInterner
+    */
+    static TradingCatCommon::StockExchangeID stockExchangeId(quint32 index);
+    static TradingCatCommon::KLineID klineId(quint32 stockExchangeIndex, quint32 index);
+
+    static qsizetype stockExchangesCount();
+    static qsizetype klinesCount(quint32 stockExchangeIndex);
+
+private:
+    IDInterner() = delete;
+};
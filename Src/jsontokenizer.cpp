@@ -0,0 +1,201 @@
+//STL
+#include <charconv>
+
+#include "jsontokenizer.h"
+
+static constexpr quint32 MAX_DEPTH = 64;
+
+JsonTokenizer::JsonTokenizer(QByteArrayView data) noexcept
+    : _pos(data.data())
+    , _end(data.data() + data.size())
+{
+}
+
+JsonTokenizer::Token JsonTokenizer::next() noexcept
+{
+    while (true)
+    {
+        skipSpaces();
+        if (_pos == _end)
+        {
+            return _depth == 0 ? Token::END : Token::ERROR;
+        }
+
+        switch (*_pos)
+        {
+        case '{':
+        case '[':
+        {
+            if (_depth == MAX_DEPTH)
+            {
+                return Token::ERROR;
+            }
+
+            const auto isObject = *_pos == '{';
+            if (isObject)
+            {
+                _objectLevels |= quint64(1) << _depth;
+            }
+            else
+            {
+                _objectLevels &= ~(quint64(1) << _depth);
+            }
+            ++_depth;
+            ++_pos;
+            _isKeyExpected = isObject;
+
+            return isObject ? Token::BEGIN_OBJECT : Token::BEGIN_ARRAY;
+        }
+        case '}':
+        case ']':
+        {
+            const auto isObject = *_pos == '}';
+            if (_depth == 0 || isObject != bool(_objectLevels & (quint64(1) << (_depth - 1))))
+            {
+                return Token::ERROR;
+            }
+
+            --_depth;
+            ++_pos;
+            _isKeyExpected = false;
+
+            return isObject ? Token::END_OBJECT : Token::END_ARRAY;
+        }
+        case ',':
+            ++_pos;
+            _isKeyExpected = _depth > 0 && (_objectLevels & (quint64(1) << (_depth - 1)));
+
+            continue;
+        case ':':
+            ++_pos;
+
+            continue;
+        case '"':
+        {
+            if (!readString())
+            {
+                return Token::ERROR;
+            }
+
+            if (_isKeyExpected)
+            {
+                _isKeyExpected = false;
+
+                return Token::KEY;
+            }
+
+            return Token::STRING;
+        }
+        case 't':
+        case 'f':
+        case 'n':
+        {
+            const auto literal = *_pos == 't' ? QByteArrayView("true") : *_pos == 'f' ? QByteArrayView("false") : QByteArrayView("null");
+            if (_end - _pos < literal.size() || QByteArrayView(_pos, literal.size()) != literal)
+            {
+                return Token::ERROR;
+            }
+            _pos += literal.size();
+
+            return *literal.data() == 't' ? Token::TRUE_VALUE : *literal.data() == 'f' ? Token::FALSE_VALUE : Token::NULL_VALUE;
+        }
+        default:
+        {
+            _textBegin = _pos;
+            while (_pos != _end && ((*_pos >= '0' && *_pos <= '9') || *_pos == '-' || *_pos == '+' || *_pos == '.' || *_pos == 'e' || *_pos == 'E'))
+            {
+                ++_pos;
+            }
+            _textEnd = _pos;
+
+            return _textBegin != _textEnd ? Token::NUMBER : Token::ERROR;
+        }
+        }
+    }
+}
+
+QByteArrayView JsonTokenizer::text() const noexcept
+{
+    return QByteArrayView(_textBegin, _textEnd - _textBegin);
+}
+
+bool JsonTokenizer::isEscaped() const noexcept
+{
+    return _isEscaped;
+}
+
+bool JsonTokenizer::skipValue() noexcept
+{
+    const auto depth = _depth;
+
+    auto token = next();
+    if (token != Token::BEGIN_OBJECT && token != Token::BEGIN_ARRAY)
+    {
+        return token != Token::ERROR && token != Token::END && token != Token::END_OBJECT && token != Token::END_ARRAY;
+    }
+
+    while (_depth > depth)
+    {
+        token = next();
+        if (token == Token::ERROR || token == Token::END)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool JsonTokenizer::toDouble(double &value) const noexcept
+{
+    const auto [ptr, error] = std::from_chars(_textBegin, _textEnd, value);
+
+    return error == std::errc() && ptr == _textEnd;
+}
+
+bool JsonTokenizer::toInt64(qint64 &value) const noexcept
+{
+    const auto [ptr, error] = std::from_chars(_textBegin, _textEnd, value);
+
+    return error == std::errc() && ptr == _textEnd;
+}
+
+void JsonTokenizer::skipSpaces() noexcept
+{
+    while (_pos != _end && (*_pos == ' ' || *_pos == '\n' || *_pos == '\r' || *_pos == '\t'))
+    {
+        ++_pos;
+    }
+}
+
+bool JsonTokenizer::readString() noexcept
+{
+    Q_ASSERT(*_pos == '"');
+
+    ++_pos;
+    _textBegin = _pos;
+    _isEscaped = false;
+
+    while (_pos != _end)
+    {
+        if (*_pos == '\\')
+        {
+            _isEscaped = true;
+            _pos += _end - _pos > 1 ? 2 : 1;
+
+            continue;
+        }
+
+        if (*_pos == '"')
+        {
+            _textEnd = _pos;
+            ++_pos;
+
+            return true;
+        }
+
+        ++_pos;
+    }
+
+    return false;
+}
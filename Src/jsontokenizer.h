@@ -0,0 +1,79 @@
+#pragma once
+
+//Qt
+#include <QtGlobal>
+#include <QByteArrayView>
+
+///////////////////////////////////////////////////////////////////////////////
+///     The JsonTokenizer class - последовательное (SAX) чтение JSON без построения
+///         QJsonDocument. Токены возвращаются по одному, строки и числа - ссылками
+///         на исходный буфер без копирования. Используется для разбора сообщений
+///         WebSocket-потока свечей, где из сообщения нужны несколько полей. Ответы
+///         REST разбирают коннекторы библиотеки StockExchange. Буфер должен жить
+///         дольше объекта
+///
+class JsonTokenizer final
+{
+public:
+    enum class Token: quint8
+    {
+        BEGIN_OBJECT,
+        END_OBJECT,
+        BEGIN_ARRAY,
+        END_ARRAY,
+        KEY,          ///< ключ объекта, text() - имя ключа
+        STRING,       ///< text() - строка без кавычек
+        NUMBER,       ///< text() - запись числа
+        TRUE_VALUE,
+        FALSE_VALUE,
+        NULL_VALUE,
+        END,          ///< конец данных
+        ERROR         ///< некорректный JSON
+    };
+
+public:
+    explicit JsonTokenizer(QByteArrayView data) noexcept;
+
+    Token next() noexcept;
+
+    /*!
+        Текст последнего токена KEY, STRING или NUMBER
+    */
+    QByteArrayView text() const noexcept;
+
+    /*!
+        Последняя строка содержит escape-последовательности и text() возвращает ее без декодирования
+    */
+    bool isEscaped() const noexcept;
+
+    /*!
+        Пропускает значение целиком (включая вложенные объекты и массивы). Вызывается после KEY
+        @return false - некорректный JSON
+    */
+    bool skipValue() noexcept;
+
+    /*!
+        Преобразование text() в число. Строковые значения вида "1.5" также допускаются
+        @return false - text() не является числом
+    */
+    bool toDouble(double& value) const noexcept;
+    bool toInt64(qint64& value) const noexcept;
+
+private:
+    JsonTokenizer() = delete;
+
+    void skipSpaces() noexcept;
+    bool readString() noexcept;
+
+private:
+    const char* _pos = nullptr;
+    const char* const _end = nullptr;
+
+    const char* _textBegin = nullptr;
+    const char* _textEnd = nullptr;
+    bool _isEscaped = false;
+
+    bool _isKeyExpected = false;   ///< следующая строка в объекте - ключ
+    quint32 _depth = 0;
+    quint64 _objectLevels = 0;     ///< битовая маска: 1 - уровень вложенности является объектом (до 64 уровней)
+};
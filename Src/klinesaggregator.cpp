@@ -0,0 +1,292 @@
+//STL
+#include <algorithm>
+
+//Qt
+#include <QDateTime>
+
+#include "idinterner.h"
+#include "klinespool.h"
+#include "klinesstore.h"
+#include "klinesaggregator.h"
+
+using namespace TradingCatCommon;
+
+static const qint64 DAY_INTERVAL = 24 * 60 * 60 * 1000;
+static const qint64 WEEK_OPEN_OFFSET = 4 * DAY_INTERVAL; // 01.01.1970 - четверг, недельные свечи открываются в понедельник
+
+KLinesAggregator::KLinesAggregator(const TradingCatCommon::KLineTypes& klineTypes, QObject* parent /* = nullptr */)
+    : QObject{parent}
+{
+    for (const auto& type: klineTypes)
+    {
+        if (type != KLineType::MIN1)
+        {
+            _klineTypes.push_back(type);
+        }
+    }
+
+    qRegisterMetaType<TradingCatCommon::StockExchangeID>("TradingCatCommon::StockExchangeID");
+    qRegisterMetaType<TradingCatCommon::PKLinesList>("TradingCatCommon::PKLinesList");
+    qRegisterMetaType<TradingCatCommon::PKLinesIDList>("TradingCatCommon::PKLinesIDList");
+    qRegisterMetaType<TradingCatCommon::KLineID>("TradingCatCommon::KLineID");
+}
+
+qint64 KLinesAggregator::intervalOpenTime(qint64 time, TradingCatCommon::KLineType type) noexcept
+{
+    const auto interval = KLinesStore::klineInterval(type);
+    const auto offset = type == KLineType::WEEK1 ? WEEK_OPEN_OFFSET : 0;
+
+    return (time - offset) / interval * interval + offset;
+}
+
+void KLinesAggregator::addKLines(const TradingCatCommon::StockExchangeID &stockExchangeId, const TradingCatCommon::PKLinesList &klines)
+{
+    Q_CHECK_PTR(klines);
+
+    if (_klineTypes.empty())
+    {
+        emit getKLines(stockExchangeId, klines);
+
+        return;
+    }
+
+    const auto minuteInterval = KLinesStore::klineInterval(KLineType::MIN1);
+    const auto currentTime = QDateTime::currentMSecsSinceEpoch();
+
+    const auto stockExchangeIndex = IDInterner::stockExchange(stockExchangeId);
+
+    PKLinesList result;
+
+    for (const auto& minuteKLine: *klines)
+    {
+        if (minuteKLine->id.type != KLineType::MIN1)
+        {
+            continue;
+        }
+
+        const auto klineIndex = IDInterner::kline(stockExchangeIndex, minuteKLine->id);
+        if (klineIndex >= _aggregates.size())
+        {
+            _aggregates.resize(klineIndex + 1);
+        }
+
+        auto& aggregates = _aggregates[klineIndex];
+        if (aggregates.empty())
+        {
+            aggregates.resize(_klineTypes.size());
+
+            // одним запросом - минутные свечи от начала самого длинного интервала до первой полученной свечи
+            auto from = minuteKLine->openTime;
+            for (const auto type: _klineTypes)
+            {
+                from = std::min(from, intervalOpenTime(minuteKLine->openTime, type));
+            }
+            from = std::max(from, minuteKLine->openTime - HISTORY_MINUTES_COUNT * minuteInterval);
+
+            if (from < minuteKLine->openTime)
+            {
+                emit loadKLinesRequest(minuteKLine->id, from, minuteKLine->openTime - minuteInterval);
+            }
+        }
+
+        const auto isMinuteClosed = minuteKLine->closeTime < currentTime;
+
+        for (std::size_t typeIndex = 0; typeIndex < _klineTypes.size(); ++typeIndex)
+        {
+            const auto type = _klineTypes[typeIndex];
+            const auto interval = KLinesStore::klineInterval(type);
+            const auto openTime = intervalOpenTime(minuteKLine->openTime, type);
+
+            auto& aggregate = aggregates[typeIndex];
+            auto& kline = aggregate.kline;
+
+            if (aggregate.isStarted && minuteKLine->openTime < aggregate.lastMinuteOpenTime)
+            {
+                // дозагруженная минутная свеча начала строящегося интервала. Остальные - устаревшие
+                if (!aggregate.isFinished && isMinuteClosed && minuteKLine->openTime >= kline.openTime && minuteKLine->openTime < aggregate.firstMinuteOpenTime)
+                {
+                    addHistoryMinute(aggregate, *minuteKLine);
+                }
+
+                continue;
+            }
+
+            if (!aggregate.isStarted)
+            {
+                kline.id = KLineID(minuteKLine->id.symbol, type);
+            }
+
+            if (!aggregate.isStarted || kline.openTime != openTime)
+            {
+                // предыдущая свеча не получила закрытую последнюю минутную свечу
+                if (aggregate.isStarted && !aggregate.isFinished)
+                {
+                    aggregate.isContiguous = false;
+
+                    if (!result)
+                    {
+                        result = std::make_shared<KLinesList>();
+                    }
+                    finish(aggregate, *result);
+                }
+
+                // начало нового интервала. Свеча, начатая не с первой минуты, полная только после дозагрузки начала
+                aggregate.isStarted = true;
+                aggregate.isContiguous = true;
+                aggregate.isFinished = false;
+                aggregate.firstMinuteOpenTime = minuteKLine->openTime;
+                aggregate.historyFirstOpenTime = 0;
+                aggregate.historyLastOpenTime = 0;
+                aggregate.isHistoryContiguous = false;
+                kline.openTime = openTime;
+                kline.closeTime = openTime + interval - 1;
+                kline.open = minuteKLine->open;
+                kline.high = minuteKLine->high;
+                kline.low = minuteKLine->low;
+                kline.volume = 0.0;
+                kline.quoteAssetVolume = 0.0;
+            }
+            else if (minuteKLine->openTime == aggregate.lastMinuteOpenTime)
+            {
+                // свеча уже передана - повторная закрытая минутная свеча ее не меняет
+                if (aggregate.isFinished)
+                {
+                    continue;
+                }
+
+                // обновление незакрытой минутной свечи - заменяем ее вклад в объем
+                kline.volume -= aggregate.lastMinuteVolume;
+                kline.quoteAssetVolume -= aggregate.lastMinuteQuoteAssetVolume;
+            }
+            else if (minuteKLine->openTime != aggregate.lastMinuteOpenTime + minuteInterval)
+            {
+                // пропущены минутные свечи
+                aggregate.isContiguous = false;
+            }
+
+            kline.high = std::max(kline.high, minuteKLine->high);
+            kline.low = std::min(kline.low, minuteKLine->low);
+            kline.close = minuteKLine->close;
+            kline.volume += minuteKLine->volume;
+            kline.quoteAssetVolume += minuteKLine->quoteAssetVolume;
+
+            aggregate.lastMinuteOpenTime = minuteKLine->openTime;
+            aggregate.lastMinuteVolume = minuteKLine->volume;
+            aggregate.lastMinuteQuoteAssetVolume = minuteKLine->quoteAssetVolume;
+
+            // закрылась последняя минутная свеча интервала
+            if (isMinuteClosed && minuteKLine->closeTime >= kline.closeTime)
+            {
+                if (!result)
+                {
+                    result = std::make_shared<KLinesList>();
+                }
+                finish(aggregate, *result);
+            }
+        }
+    }
+
+    if (!result)
+    {
+        emit getKLines(stockExchangeId, klines);
+
+        return;
+    }
+
+    result->insert(result->begin(), klines->begin(), klines->end());
+
+    emit getKLines(stockExchangeId, result);
+}
+
+bool KLinesAggregator::isComplete(const Aggregate &aggregate) noexcept
+{
+    if (!aggregate.isContiguous)
+    {
+        return false;
+    }
+
+    if (aggregate.firstMinuteOpenTime == aggregate.kline.openTime)
+    {
+        return true;
+    }
+
+    return aggregate.isHistoryContiguous
+           && aggregate.historyFirstOpenTime == aggregate.kline.openTime
+           && aggregate.historyLastOpenTime + KLinesStore::klineInterval(KLineType::MIN1) == aggregate.firstMinuteOpenTime;
+}
+
+void KLinesAggregator::addHistoryMinute(Aggregate &aggregate, const TradingCatCommon::KLine &minuteKLine)
+{
+    auto& kline = aggregate.kline;
+
+    // история приходит по возрастанию времени: первая свеча задает цену открытия, повторы пропускаются
+    if (aggregate.historyFirstOpenTime == 0)
+    {
+        aggregate.historyFirstOpenTime = minuteKLine.openTime;
+        aggregate.isHistoryContiguous = true;
+        kline.open = minuteKLine.open;
+    }
+    else if (minuteKLine.openTime <= aggregate.historyLastOpenTime)
+    {
+        return;
+    }
+    else if (minuteKLine.openTime != aggregate.historyLastOpenTime + KLinesStore::klineInterval(KLineType::MIN1))
+    {
+        aggregate.isHistoryContiguous = false;
+    }
+
+    aggregate.historyLastOpenTime = minuteKLine.openTime;
+
+    kline.high = std::max(kline.high, minuteKLine.high);
+    kline.low = std::min(kline.low, minuteKLine.low);
+    kline.volume += minuteKLine.volume;
+    kline.quoteAssetVolume += minuteKLine.quoteAssetVolume;
+}
+
+void KLinesAggregator::finish(Aggregate &aggregate, TradingCatCommon::KLinesList &result)
+{
+    Q_ASSERT(aggregate.isStarted && !aggregate.isFinished);
+
+    aggregate.isFinished = true;
+
+    result.push_back(KLinesPool::make(aggregate.kline));
+
+    // неполная свеча заменяется свечой биржи
+    if (!isComplete(aggregate))
+    {
+        emit loadKLinesRequest(aggregate.kline.id, aggregate.kline.openTime, aggregate.kline.openTime);
+    }
+}
+
+void KLinesAggregator::reset()
+{
+    _aggregates.clear();
+}
+
+void KLinesAggregator::addKLinesID(const TradingCatCommon::StockExchangeID &stockExchangeId, const TradingCatCommon::PKLinesIDList &klinesIdList)
+{
+    Q_CHECK_PTR(klinesIdList);
+
+    if (_klineTypes.empty())
+    {
+        emit getKLinesID(stockExchangeId, klinesIdList);
+
+        return;
+    }
+
+    auto result = std::make_shared<KLinesIDList>(*klinesIdList);
+    for (const auto& klineId: *klinesIdList)
+    {
+        if (klineId.type != KLineType::MIN1)
+        {
+            continue;
+        }
+
+        for (const auto& type: _klineTypes)
+        {
+            result->emplace(klineId.symbol, type);
+        }
+    }
+
+    emit getKLinesID(stockExchangeId, result);
+}
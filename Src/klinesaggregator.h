@@ -0,0 +1,111 @@
+#pragma once
+
+//STL
+#include <vector>
+
+//Qt
+#include <QObject>
+
+//My
+#include <TradingCatCommon/stockexchange.h>
+#include <TradingCatCommon/kline.h>
+
+///////////////////////////////////////////////////////////////////////////////
+///     The KLinesAggregator class - построение свечей старших интервалов из минутных.
+///         Объект живет в потоке биржи и стоит между биржей и потребителями данных:
+///         минутные свечи и свечи старших интервалов, полученные с биржи, передаются
+///         дальше без изменений, к ним добавляются свечи старших интервалов, построенные
+///         из минутных. Свеча старшего интервала передается один раз - после закрытия
+///         последней минутной свечи интервала. При первой минутной свече инструмента одним
+///         запросом дозагружаются минутные свечи от начала самого длинного строящегося
+///         интервала (не больше HISTORY_MINUTES_COUNT), и первые свечи строятся с начала
+///         интервала. Свеча, для которой не хватило минутных свечей (начало интервала
+///         раньше дозагруженной истории или пропуск минутных свечей), все равно передается
+///         по имеющимся минутным свечам, и дополнительно запрашивается с биржи для замены.
+///         Список ID свечей дополняется ID старших интервалов
+///
+class KLinesAggregator final
+    : public QObject
+{
+    Q_OBJECT
+
+public:
+    /*!
+        Конструктор
+        @param klineTypes - интервалы, которые нужно строить из минутных свечей
+    */
+    explicit KLinesAggregator(const TradingCatCommon::KLineTypes& klineTypes, QObject* parent = nullptr);
+
+    /*!
+        Максимальное количество минутных свечей, запрашиваемых с биржи при первой минутной свече инструмента
+    */
+    static constexpr qsizetype HISTORY_MINUTES_COUNT = 1000;
+    ~KLinesAggregator() override = default;
+
+    /*!
+        Начало интервала, содержащего момент времени time
+    */
+    static qint64 intervalOpenTime(qint64 time, TradingCatCommon::KLineType type) noexcept;
+
+public slots:
+    void addKLines(const TradingCatCommon::StockExchangeID& stockExchangeId, const TradingCatCommon::PKLinesList& klines);
+    void addKLinesID(const TradingCatCommon::StockExchangeID& stockExchangeId, const TradingCatCommon::PKLinesIDList& klinesIdList);
+
+    /*!
+        Сброс строящихся свечей при перезапуске коннектора биржи. Следующая минутная свеча
+            инструмента запрашивает историю минутных свечей, как при запуске
+    */
+    void reset();
+
+signals:
+    void getKLines(const TradingCatCommon::StockExchangeID& stockExchangeId, const TradingCatCommon::PKLinesList& klines);
+    void getKLinesID(const TradingCatCommon::StockExchangeID& stockExchangeId, const TradingCatCommon::PKLinesIDList& klinesIdList);
+
+    /*!
+        Запрос свечей с биржи: минутные свечи начала строящихся интервалов при запуске
+            или свеча старшего интервала, которую не удалось построить полностью
+        @param klineId - ID свечи
+        @param from - время открытия первой свечи
+        @param to - время открытия последней свечи
+    */
+    void loadKLinesRequest(const TradingCatCommon::KLineID& klineId, qint64 from, qint64 to);
+
+private:
+    KLinesAggregator() = delete;
+    Q_DISABLE_COPY_MOVE(KLinesAggregator);
+
+private:
+    struct Aggregate
+    {
+        bool isStarted = false;
+        bool isContiguous = false;           ///< минутные свечи с firstMinuteOpenTime получены без пропусков
+        bool isFinished = false;             ///< последняя минутная свеча интервала закрыта, свеча передана
+        TradingCatCommon::KLine kline;       ///< текущая свеча старшего интервала
+        qint64 firstMinuteOpenTime = 0;      ///< время открытия первой полученной минутной свечи интервала
+        qint64 lastMinuteOpenTime = 0;       ///< время открытия последней учтенной минутной свечи
+        double lastMinuteVolume = 0.0;       ///< объемы последней минутной свечи для учета ее обновлений
+        double lastMinuteQuoteAssetVolume = 0.0;
+        qint64 historyFirstOpenTime = 0;     ///< дозагруженные минутные свечи до firstMinuteOpenTime. 0 - не было
+        qint64 historyLastOpenTime = 0;
+        bool isHistoryContiguous = false;
+    };
+
+    /*!
+        Свеча построена с начала интервала без пропусков минутных свечей
+    */
+    static bool isComplete(const Aggregate& aggregate) noexcept;
+
+    /*!
+        Учитывает дозагруженную минутную свечу, открытую раньше первой полученной свечи интервала
+    */
+    static void addHistoryMinute(Aggregate& aggregate, const TradingCatCommon::KLine& minuteKLine);
+
+    /*!
+        Завершает свечу интервала и добавляет ее в result. Неполная свеча дополнительно запрашивается с биржи
+    */
+    void finish(Aggregate& aggregate, TradingCatCommon::KLinesList& result);
+
+private:
+    std::vector<TradingCatCommon::KLineType> _klineTypes;
+    std::vector<std::vector<Aggregate>> _aggregates;   ///< свечи по индексу минутного KLineID биржи в IDInterner и номеру интервала в _klineTypes
+};
@@ -0,0 +1,412 @@
+//STL
+#include <map>
+#include <algorithm>
+
+//Qt
+#include <QTextStream>
+#include <QDateTime>
+
+#include "idinterner.h"
+#include "klinespool.h"
+#include "klinesstore.h"
+#include "klinesarchive.h"
+
+using namespace TradingCatCommon;
+using namespace Common;
+
+static const qint64 FLUSH_INTERVAL = 10 * 1000;
+static const quint32 MAX_SEGMENTS = 3;
+
+KLinesArchive::KLinesArchive(const QString& dirName, const TradingCatCommon::StockExchangesIDList& stockExchangesIdList, qsizetype loadKLinesCount,
+                             qint64 segmentRecords /* = SEGMENT_RECORDS */, QObject* parent /* = nullptr */)
+    : QObject{parent}
+    , _dir(dirName)
+    , _stockExchangesIdList(stockExchangesIdList)
+    , _loadKLinesCount(loadKLinesCount)
+    , _segmentRecords(segmentRecords)
+{
+    Q_ASSERT(!dirName.isEmpty());
+    Q_ASSERT(_loadKLinesCount > 0);
+    Q_ASSERT(_segmentRecords > 0);
+
+    qRegisterMetaType<TradingCatCommon::StockExchangeID>("TradingCatCommon::StockExchangeID");
+    qRegisterMetaType<TradingCatCommon::PKLinesList>("TradingCatCommon::PKLinesList");
+    qRegisterMetaType<TradingCatCommon::PKLinesIDList>("TradingCatCommon::PKLinesIDList");
+}
+
+KLinesArchive::~KLinesArchive()
+{
+    stop();
+}
+
+void KLinesArchive::start()
+{
+    Q_ASSERT(!_isStarted);
+
+    if (!_dir.mkpath("."))
+    {
+        emit sendLogMsg(MSG_CODE::WARNING_CODE, QString("Cannot create archive directory %1. Archive disabled").arg(_dir.absolutePath()));
+
+        return;
+    }
+
+    for (const auto& stockExchangeId: _stockExchangesIdList)
+    {
+        load(stockExchangeId);
+    }
+
+    _flushTimer = new QTimer(this);
+
+    connect(_flushTimer, SIGNAL(timeout()), SLOT(flushTimerTimeout()));
+
+    _flushTimer->start(FLUSH_INTERVAL);
+
+    _isStarted = true;
+}
+
+void KLinesArchive::stop()
+{
+    if (!_isStarted)
+    {
+        return;
+    }
+
+    delete _flushTimer;
+    _flushTimer = nullptr;
+
+    flush();
+
+    _data.clear();
+
+    _isStarted = false;
+}
+
+void KLinesArchive::addKLines(const TradingCatCommon::StockExchangeID &stockExchangeId, const TradingCatCommon::PKLinesList &klines)
+{
+    Q_CHECK_PTR(klines);
+
+    if (!_isStarted)
+    {
+        return;
+    }
+
+    auto& data = stockExchangeData(stockExchangeId);
+
+    const auto currentTime = QDateTime::currentMSecsSinceEpoch();
+
+    for (const auto& kline: *klines)
+    {
+        // незакрытая свеча обновляется при каждом опросе биржи - в архив пишется только закрытая
+        if (kline->closeTime >= currentTime)
+        {
+            continue;
+        }
+
+        const auto symbol = symbolIndex(data, kline->id.symbol);
+        const auto interval = KLinesStore::klineInterval(kline->id.type);
+
+        auto [it_lastOpenTime, isNew] = data.lastOpenTimes.try_emplace(recordKey(symbol, interval), kline->openTime);
+        if (!isNew)
+        {
+            if (kline->openTime <= it_lastOpenTime->second)
+            {
+                continue;
+            }
+
+            it_lastOpenTime->second = kline->openTime;
+        }
+
+        Record record;
+        record.openTime = kline->openTime;
+        record.open = kline->open;
+        record.high = kline->high;
+        record.low = kline->low;
+        record.close = kline->close;
+        record.volume = kline->volume;
+        record.quoteAssetVolume = kline->quoteAssetVolume;
+        record.symbol = symbol;
+
+        auto& currentSegment = segment(data, interval);
+        if (!currentSegment.file->isOpen())
+        {
+            continue;
+        }
+
+        currentSegment.buffer.append(reinterpret_cast<const char*>(&record), sizeof(Record));
+        ++currentSegment.recordsCount;
+
+        // сегмент заполнен - начинаем следующий
+        if (currentSegment.recordsCount >= _segmentRecords)
+        {
+            const auto number = currentSegment.number + 1;
+
+            if (currentSegment.file->write(currentSegment.buffer) != currentSegment.buffer.size())
+            {
+                emit sendLogMsg(MSG_CODE::WARNING_CODE, QString("Cannot write archive segment %1: %2").arg(currentSegment.file->fileName()).arg(currentSegment.file->errorString()));
+            }
+            currentSegment.file->close();
+            data.segments.erase(interval);
+
+            Segment nextSegment;
+            if (openSegment(data, interval, number, nextSegment))
+            {
+                data.segments.emplace(interval, std::move(nextSegment));
+            }
+
+            removeOldSegments(data.dir, interval, number);
+        }
+    }
+}
+
+void KLinesArchive::flushTimerTimeout()
+{
+    flush();
+}
+
+KLinesArchive::StockExchangeData &KLinesArchive::stockExchangeData(const TradingCatCommon::StockExchangeID &stockExchangeId)
+{
+    auto it_data = _data.find(stockExchangeId);
+    if (it_data != _data.end())
+    {
+        return it_data->second;
+    }
+
+    StockExchangeData data;
+    data.dir = QDir(_dir.absoluteFilePath(stockExchangeId.name));
+    data.dir.mkpath(".");
+
+    data.symbolsFile = std::make_unique<QFile>(data.dir.absoluteFilePath("symbols.idx"));
+    if (data.symbolsFile->open(QIODevice::ReadWrite | QIODevice::Text))
+    {
+        QTextStream stream(data.symbolsFile.get());
+        while (!stream.atEnd())
+        {
+            const auto symbol = stream.readLine();
+            data.symbols.emplace(symbol, static_cast<quint32>(data.symbolNames.size()));
+            data.symbolNames.push_back(symbol);
+        }
+        data.symbolsFile->seek(data.symbolsFile->size());
+    }
+    else
+    {
+        emit sendLogMsg(MSG_CODE::WARNING_CODE, QString("Cannot open archive index %1: %2").arg(data.symbolsFile->fileName()).arg(data.symbolsFile->errorString()));
+    }
+
+    return _data.emplace(stockExchangeId, std::move(data)).first->second;
+}
+
+quint32 KLinesArchive::symbolIndex(StockExchangeData &data, const QString &symbol)
+{
+    const auto it_symbols = data.symbols.find(symbol);
+    if (it_symbols != data.symbols.end())
+    {
+        return it_symbols->second;
+    }
+
+    const auto index = static_cast<quint32>(data.symbolNames.size());
+    data.symbols.emplace(symbol, index);
+    data.symbolNames.push_back(symbol);
+
+    // индекс пишется сразу, чтобы сегменты не ссылались на несохраненные инструменты
+    data.symbolsFile->write(QString("%1\n").arg(symbol).toUtf8());
+    data.symbolsFile->flush();
+
+    return index;
+}
+
+KLinesArchive::Segment &KLinesArchive::segment(StockExchangeData &data, qint64 interval)
+{
+    auto it_segments = data.segments.find(interval);
+    if (it_segments != data.segments.end())
+    {
+        return it_segments->second;
+    }
+
+    // продолжаем последний сегмент интервала
+    quint32 number = 0;
+    const auto fileNames = data.dir.entryList({QString("%1_*.seg").arg(interval)}, QDir::Files);
+    for (const auto& fileName: fileNames)
+    {
+        number = std::max(number, fileName.section('_', 1).section('.', 0, 0).toUInt());
+    }
+
+    Segment newSegment;
+    openSegment(data, interval, number, newSegment);
+
+    return data.segments.emplace(interval, std::move(newSegment)).first->second;
+}
+
+bool KLinesArchive::openSegment(StockExchangeData &data, qint64 interval, quint32 number, Segment &segment)
+{
+    segment.number = number;
+    segment.file = std::make_unique<QFile>(data.dir.absoluteFilePath(QString("%1_%2.seg").arg(interval).arg(number)));
+    if (!segment.file->open(QIODevice::ReadWrite))
+    {
+        emit sendLogMsg(MSG_CODE::WARNING_CODE, QString("Cannot open archive segment %1: %2").arg(segment.file->fileName()).arg(segment.file->errorString()));
+
+        return false;
+    }
+
+    // неполная запись в конце файла остается после аварийного завершения - отбрасываем ее
+    segment.recordsCount = segment.file->size() / static_cast<qint64>(sizeof(Record));
+    segment.file->resize(segment.recordsCount * static_cast<qint64>(sizeof(Record)));
+    segment.file->seek(segment.file->size());
+
+    return true;
+}
+
+void KLinesArchive::removeOldSegments(const QDir &dir, qint64 interval, quint32 lastNumber)
+{
+    if (lastNumber < MAX_SEGMENTS)
+    {
+        return;
+    }
+
+    const auto fileNames = dir.entryList({QString("%1_*.seg").arg(interval)}, QDir::Files);
+    for (const auto& fileName: fileNames)
+    {
+        const auto number = fileName.section('_', 1).section('.', 0, 0).toUInt();
+        if (number <= lastNumber - MAX_SEGMENTS)
+        {
+            QFile::remove(dir.absoluteFilePath(fileName));
+        }
+    }
+}
+
+void KLinesArchive::load(const TradingCatCommon::StockExchangeID &stockExchangeId)
+{
+    auto& data = stockExchangeData(stockExchangeId);
+
+    auto klinesIdList = std::make_shared<KLinesIDList>();
+    auto klines = std::make_shared<KLinesList>();
+
+    // сегменты по интервалам в порядке номеров
+    std::map<qint64, std::map<quint32, QString>> segmentFileNames;
+    for (const auto& fileName: data.dir.entryList({"*.seg"}, QDir::Files))
+    {
+        const auto interval = fileName.section('_', 0, 0).toLongLong();
+        const auto number = fileName.section('_', 1).section('.', 0, 0).toUInt();
+        if (interval > 0)
+        {
+            segmentFileNames[interval].emplace(number, data.dir.absoluteFilePath(fileName));
+        }
+    }
+
+    for (const auto& [interval, fileNames]: segmentFileNames)
+    {
+        std::vector<std::unique_ptr<QFile>> files;
+        std::unordered_map<quint32, std::map<qint64, const Record*>> symbolsRecords;
+
+        for (const auto& fileName: fileNames)
+        {
+            auto file = std::make_unique<QFile>(fileName.second);
+            if (!file->open(QIODevice::ReadOnly))
+            {
+                continue;
+            }
+
+            const auto recordsCount = file->size() / static_cast<qint64>(sizeof(Record));
+            if (recordsCount == 0)
+            {
+                continue;
+            }
+
+            const auto memory = file->map(0, recordsCount * static_cast<qint64>(sizeof(Record)));
+            if (memory == nullptr)
+            {
+                emit sendLogMsg(MSG_CODE::WARNING_CODE, QString("Cannot map archive segment %1: %2").arg(file->fileName()).arg(file->errorString()));
+
+                continue;
+            }
+
+            const auto records = reinterpret_cast<const Record*>(memory);
+            for (qint64 recordIndex = 0; recordIndex < recordsCount; ++recordIndex)
+            {
+                const auto& record = records[recordIndex];
+                if (record.symbol >= data.symbolNames.size())
+                {
+                    continue;
+                }
+
+                // более поздняя запись той же свечи заменяет предыдущую
+                auto& symbolRecords = symbolsRecords[record.symbol];
+                symbolRecords.insert_or_assign(record.openTime, &record);
+                if (static_cast<qsizetype>(symbolRecords.size()) > _loadKLinesCount)
+                {
+                    symbolRecords.erase(symbolRecords.begin());
+                }
+            }
+
+            files.emplace_back(std::move(file));
+        }
+
+        const auto type = static_cast<KLineType>(interval);
+        for (const auto& [symbol, records]: symbolsRecords)
+        {
+            const KLineID klineId(data.symbolNames[symbol], type);
+            klinesIdList->emplace(klineId);
+
+            data.lastOpenTimes.insert_or_assign(recordKey(symbol, interval), records.rbegin()->first);
+
+            for (const auto& [openTime, record]: records)
+            {
+                auto kline = KLinesPool::make();
+                kline->id = klineId;
+                kline->openTime = record->openTime;
+                kline->closeTime = record->openTime + interval - 1;
+                kline->open = record->open;
+                kline->high = record->high;
+                kline->low = record->low;
+                kline->close = record->close;
+                kline->volume = record->volume;
+                kline->quoteAssetVolume = record->quoteAssetVolume;
+
+                klines->push_back(std::move(kline));
+            }
+        }
+    }
+
+    if (klines->empty())
+    {
+        return;
+    }
+
+    emit sendLogMsg(MSG_CODE::INFORMATION_CODE, QString("Load from archive %1 klines of %2 klines ID for stock exchange %3")
+                                                    .arg(klines->size())
+                                                    .arg(klinesIdList->size())
+                                                    .arg(stockExchangeId.toString()));
+
+    // индексы всех ID архива назначаются одной заменой таблицы, до обработки свечей
+    IDInterner::klines(IDInterner::stockExchange(stockExchangeId), *klinesIdList);
+
+    emit getKLinesID(stockExchangeId, klinesIdList);
+    emit getKLines(stockExchangeId, klines);
+}
+
+quint64 KLinesArchive::recordKey(quint32 symbol, qint64 interval) noexcept
+{
+    // интервал свечи в мс (не больше недели) помещается в 32 бита
+    return (static_cast<quint64>(symbol) << 32) | static_cast<quint32>(interval);
+}
+
+void KLinesArchive::flush()
+{
+    for (auto& data: _data)
+    {
+        for (auto& segment: data.second.segments)
+        {
+            auto& currentSegment = segment.second;
+            if (currentSegment.buffer.isEmpty() || !currentSegment.file || !currentSegment.file->isOpen())
+            {
+                continue;
+            }
+
+            if (currentSegment.file->write(currentSegment.buffer) != currentSegment.buffer.size())
+            {
+                emit sendLogMsg(MSG_CODE::WARNING_CODE, QString("Cannot write archive segment %1: %2").arg(currentSegment.file->fileName()).arg(currentSegment.file->errorString()));
+            }
+            currentSegment.file->flush();
+            currentSegment.buffer.clear();
+        }
+    }
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+//STL
+#include <unordered_map>
+#include <memory>
+#include <vector>
+
+//Qt
+#include <QObject>
+#include <QDir>
+#include <QFile>
+#include <QTimer>
+
+//My
+#include <Common/common.h>
+
+#include <TradingCatCommon/stockexchange.h>
+#include <TradingCatCommon/kline.h>
+
+///////////////////////////////////////////////////////////////////////////////
+///     The KLinesArchive class - хранилище истории свечей на диске для быстрого
+///         перезапуска. Для каждой биржи и интервала закрытые свечи пишутся в файлы сегментов
+///         записями фиксированного размера, имена инструментов - в индексный файл. Каждая
+///         свеча пишется один раз: незакрытые свечи и свечи не новее последней записанной
+///         пропускаются (дозагруженные пропуски в архив не попадают).
+///         При запуске сегменты отображаются в память и последние свечи передаются
+///         в TradingData до получения данных с бирж
+///
+///     Структура каталога:
+///         <dir>/<stock exchange>/symbols.idx         - имена инструментов, номер строки - индекс
+///         <dir>/<stock exchange>/<interval>_<N>.seg  - сегменты свечей интервала <interval> мс
+///
+class KLinesArchive final
+    : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr qint64 SEGMENT_RECORDS = 1000000; ///< записей в одном сегменте
+
+public:
+    /*!
+        Конструктор
+        @param dirName - каталог архива
+        @param stockExchangesIdList - список бирж для загрузки
+        @param loadKLinesCount - количество последних свечей каждого KLineID, загружаемых при запуске
+        @param segmentRecords - количество записей в одном сегменте
+    */
+    KLinesArchive(const QString& dirName, const TradingCatCommon::StockExchangesIDList& stockExchangesIdList, qsizetype loadKLinesCount,
+                  qint64 segmentRecords = SEGMENT_RECORDS, QObject* parent = nullptr);
+    ~KLinesArchive() override;
+
+public slots:
+    void start();
+    void stop();
+
+    /*!
+        Добавляет свечи в архив. Данные сбрасываются на диск по таймеру
+    */
+    void addKLines(const TradingCatCommon::StockExchangeID& stockExchangeId, const TradingCatCommon::PKLinesList& klines);
+
+signals:
+    /*!
+        Свечи, загруженные из архива при запуске
+    */
+    void getKLines(const TradingCatCommon::StockExchangeID& stockExchangeId, const TradingCatCommon::PKLinesList& klines);
+    void getKLinesID(const TradingCatCommon::StockExchangeID& stockExchangeId, const TradingCatCommon::PKLinesIDList& klinesIdList);
+
+    /*!
+        Сообщение логеру
+        @param category - категория сообщения
+        @param msg - текст сообщения
+    */
+    void sendLogMsg(Common::MSG_CODE category, const QString& msg);
+
+private slots:
+    void flushTimerTimeout();
+
+private:
+    KLinesArchive() = delete;
+    Q_DISABLE_COPY_MOVE(KLinesArchive);
+
+    /*!
+        Запись сегмента. Размер записи - 64 байта
+    */
+    struct Record
+    {
+        qint64 openTime = 0;
+        double open = 0.0;
+        double high = 0.0;
+        double low = 0.0;
+        double close = 0.0;
+        double volume = 0.0;
+        double quoteAssetVolume = 0.0;
+        quint32 symbol = 0;
+        quint32 reserved = 0;
+    };
+    static_assert(sizeof(Record) == 64, "Incorrect size of archive record");
+
+    struct Segment
+    {
+        std::unique_ptr<QFile> file;
+        quint32 number = 0;
+        qint64 recordsCount = 0;
+        QByteArray buffer;          ///< записи, еще не сброшенные на диск
+    };
+
+    struct StockExchangeData
+    {
+        QDir dir;
+        std::unique_ptr<QFile> symbolsFile;
+        std::unordered_map<QString, quint32> symbols;
+        std::vector<QString> symbolNames;
+        std::unordered_map<qint64, Segment> segments;   ///< открытый сегмент по интервалу
+        std::unordered_map<quint64, qint64> lastOpenTimes; ///< время открытия последней записанной свечи по ключу recordKey()
+    };
+
+    static quint64 recordKey(quint32 symbol, qint64 interval) noexcept;
+
+    StockExchangeData& stockExchangeData(const TradingCatCommon::StockExchangeID& stockExchangeId);
+    quint32 symbolIndex(StockExchangeData& data, const QString& symbol);
+    Segment& segment(StockExchangeData& data, qint64 interval);
+    bool openSegment(StockExchangeData& data, qint64 interval, quint32 number, Segment& segment);
+    void removeOldSegments(const QDir& dir, qint64 interval, quint32 lastNumber);
+
+    void load(const TradingCatCommon::StockExchangeID& stockExchangeId);
+    void flush();
+
+private:
+    const QDir _dir;
+    const TradingCatCommon::StockExchangesIDList _stockExchangesIdList;
+    const qsizetype _loadKLinesCount = 0;
+    const qint64 _segmentRecords = 0;
+
+    std::unordered_map<TradingCatCommon::StockExchangeID, StockExchangeData> _data;
+
+    QTimer* _flushTimer = nullptr;
+
+    bool _isStarted = false;
+};
@@ -0,0 +1,289 @@
+//STL
+#include <bit>
+#include <algorithm>
+
+#include "klinescodec.h"
+
+static quint64 bitsMask(int count) noexcept
+{
+    return count >= 64 ? ~quint64(0) : (quint64(1) << count) - 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///     The KLinesBlock class - сжатый блок свечей одного KLineID
+///
+void KLinesBlock::append(const KLineView &kline)
+{
+    if (_count == 0)
+    {
+        writeBits(static_cast<quint64>(kline.openTime), 64);
+        _firstOpenTime = kline.openTime;
+    }
+    else if (_count == 1)
+    {
+        _lastDelta = kline.openTime - _lastOpenTime;
+        writeBits(static_cast<quint64>(_lastDelta), 64);
+    }
+    else
+    {
+        Q_ASSERT(kline.openTime > _lastOpenTime);
+
+        const auto delta = kline.openTime - _lastOpenTime;
+        const auto deltaOfDelta = delta - _lastDelta;
+        _lastDelta = delta;
+
+        if (deltaOfDelta == 0)
+        {
+            writeBits(0b0, 1);
+        }
+        else if (deltaOfDelta >= -63 && deltaOfDelta <= 64)
+        {
+            writeBits(0b10, 2);
+            writeBits(static_cast<quint64>(deltaOfDelta + 63), 7);
+        }
+        else if (deltaOfDelta >= -255 && deltaOfDelta <= 256)
+        {
+            writeBits(0b110, 3);
+            writeBits(static_cast<quint64>(deltaOfDelta + 255), 9);
+        }
+        else if (deltaOfDelta >= -2047 && deltaOfDelta <= 2048)
+        {
+            writeBits(0b1110, 4);
+            writeBits(static_cast<quint64>(deltaOfDelta + 2047), 12);
+        }
+        else
+        {
+            writeBits(0b1111, 4);
+            writeBits(static_cast<quint64>(deltaOfDelta), 64);
+        }
+    }
+
+    writeValue(kline.open, _values[0]);
+    writeValue(kline.high, _values[1]);
+    writeValue(kline.low, _values[2]);
+    writeValue(kline.close, _values[3]);
+    writeValue(kline.volume, _values[4]);
+    writeValue(kline.quoteAssetVolume, _values[5]);
+
+    _lastOpenTime = kline.openTime;
+    ++_count;
+}
+
+quint32 KLinesBlock::count() const noexcept
+{
+    return _count;
+}
+
+qint64 KLinesBlock::firstOpenTime() const noexcept
+{
+    return _firstOpenTime;
+}
+
+qint64 KLinesBlock::lastOpenTime() const noexcept
+{
+    return _lastOpenTime;
+}
+
+qint64 KLinesBlock::interval() const noexcept
+{
+    return _interval;
+}
+
+void KLinesBlock::setInterval(qint64 interval) noexcept
+{
+    _interval = interval;
+}
+
+qsizetype KLinesBlock::memoryUsage() const noexcept
+{
+    return static_cast<qsizetype>(sizeof(KLinesBlock) + _bits.capacity() * sizeof(quint64));
+}
+
+void KLinesBlock::shrink()
+{
+    _bits.shrink_to_fit();
+}
+
+void KLinesBlock::writeBits(quint64 value, int count)
+{
+    while (count > 0)
+    {
+        const auto word = _bitsCount / 64;
+        const auto offset = static_cast<int>(_bitsCount % 64);
+        if (word == static_cast<qsizetype>(_bits.size()))
+        {
+            _bits.push_back(0);
+        }
+
+        const auto free = 64 - offset;
+        const auto length = std::min(free, count);
+        const auto chunk = (value >> (count - length)) & bitsMask(length);
+
+        _bits[word] |= chunk << (free - length);
+
+        count -= length;
+        _bitsCount += length;
+    }
+}
+
+void KLinesBlock::writeValue(double value, ValueState &state)
+{
+    const auto bits = std::bit_cast<quint64>(value);
+
+    if (_count == 0)
+    {
+        writeBits(bits, 64);
+        state.value = bits;
+
+        return;
+    }
+
+    const auto xorValue = bits ^ state.value;
+    state.value = bits;
+
+    if (xorValue == 0)
+    {
+        writeBits(0b0, 1);
+
+        return;
+    }
+
+    writeBits(0b1, 1);
+
+    const auto leading = std::min(std::countl_zero(xorValue), 63);
+    const auto trailing = std::countr_zero(xorValue);
+
+    // значащие биты помещаются в окно предыдущего значения
+    if (state.leading <= 64 && leading >= state.leading && trailing >= state.trailing)
+    {
+        writeBits(0b0, 1);
+        writeBits(xorValue >> state.trailing, 64 - state.leading - state.trailing);
+
+        return;
+    }
+
+    const auto length = 64 - leading - trailing;
+
+    writeBits(0b1, 1);
+    writeBits(static_cast<quint64>(leading), 6);
+    writeBits(static_cast<quint64>(length - 1), 6);
+    writeBits(xorValue >> trailing, length);
+
+    state.leading = leading;
+    state.trailing = trailing;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///     The KLinesBlock::Decoder class - последовательное чтение свечей блока
+///
+KLinesBlock::Decoder::Decoder(const KLinesBlock &block)
+    : _block(block)
+{
+}
+
+KLinesBlock::KLineView KLinesBlock::Decoder::next()
+{
+    Q_ASSERT(_index < _block._count);
+
+    if (_index == 0)
+    {
+        _openTime = static_cast<qint64>(readBits(64));
+    }
+    else if (_index == 1)
+    {
+        _delta = static_cast<qint64>(readBits(64));
+        _openTime += _delta;
+    }
+    else
+    {
+        qint64 deltaOfDelta = 0;
+        if (readBits(1) == 0)
+        {
+            deltaOfDelta = 0;
+        }
+        else if (readBits(1) == 0)
+        {
+            deltaOfDelta = static_cast<qint64>(readBits(7)) - 63;
+        }
+        else if (readBits(1) == 0)
+        {
+            deltaOfDelta = static_cast<qint64>(readBits(9)) - 255;
+        }
+        else if (readBits(1) == 0)
+        {
+            deltaOfDelta = static_cast<qint64>(readBits(12)) - 2047;
+        }
+        else
+        {
+            deltaOfDelta = static_cast<qint64>(readBits(64));
+        }
+
+        _delta += deltaOfDelta;
+        _openTime += _delta;
+    }
+
+    KLineView result;
+    result.openTime = _openTime;
+    result.closeTime = _openTime + _block._interval - 1;
+    result.open = readValue(_values[0]);
+    result.high = readValue(_values[1]);
+    result.low = readValue(_values[2]);
+    result.close = readValue(_values[3]);
+    result.volume = readValue(_values[4]);
+    result.quoteAssetVolume = readValue(_values[5]);
+
+    ++_index;
+
+    return result;
+}
+
+quint64 KLinesBlock::Decoder::readBits(int count)
+{
+    quint64 result = 0;
+
+    while (count > 0)
+    {
+        const auto word = _position / 64;
+        const auto offset = static_cast<int>(_position % 64);
+        const auto free = 64 - offset;
+        const auto length = std::min(free, count);
+
+        const auto chunk = (_block._bits[word] >> (free - length)) & bitsMask(length);
+        result = length == 64 ? chunk : (result << length) | chunk;
+
+        count -= length;
+        _position += length;
+    }
+
+    return result;
+}
+
+double KLinesBlock::Decoder::readValue(ValueState &state)
+{
+    if (_index == 0)
+    {
+        state.value = readBits(64);
+
+        return std::bit_cast<double>(state.value);
+    }
+
+    if (readBits(1) == 0)
+    {
+        return std::bit_cast<double>(state.value);
+    }
+
+    if (readBits(1) == 0)
+    {
+        const auto length = 64 - state.leading - state.trailing;
+        state.value ^= readBits(length) << state.trailing;
+    }
+    else
+    {
+        state.leading = static_cast<int>(readBits(6));
+        const auto length = static_cast<int>(readBits(6)) + 1;
+        state.trailing = 64 - state.leading - length;
+        state.value ^= readBits(length) << state.trailing;
+    }
+
+    return std::bit_cast<double>(state.value);
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+//STL
+#include <vector>
+#include <array>
+
+//Qt
+#include <QtGlobal>
+
+#include "klinesringbuffer.h"
+
+///////////////////////////////////////////////////////////////////////////////
+///     The KLinesBlock class - сжатый блок свечей одного KLineID. Время открытия
+///         кодируется разностью второго порядка (delta-of-delta), цены и объемы -
+///         XOR с предыдущим значением столбца (схема Gorilla). Для минутных свечей
+///         без пропусков время занимает 1 бит, неизменившаяся цена - 1 бит
+///
+class KLinesBlock final
+{
+public:
+    using KLineView = KLinesRingBuffer::KLineView;
+
+public:
+    KLinesBlock() = default;
+
+    /*!
+        Добавляет свечу в конец блока. Время открытия должно возрастать
+    */
+    void append(const KLineView& kline);
+
+    /*!
+        Вызывает func(const KLineView&) для каждой свечи блока с временем открытия в [from, to]
+    */
+    template <typename Func>
+    void forEach(qint64 from, qint64 to, Func func) const
+    {
+        if (_count == 0 || _lastOpenTime < from || _firstOpenTime > to)
+        {
+            return;
+        }
+
+        Decoder decoder(*this);
+        for (quint32 index = 0; index < _count; ++index)
+        {
+            const auto kline = decoder.next();
+            if (kline.openTime > to)
+            {
+                break;
+            }
+            if (kline.openTime >= from)
+            {
+                func(kline);
+            }
+        }
+    }
+
+    quint32 count() const noexcept;
+    qint64 firstOpenTime() const noexcept;
+    qint64 lastOpenTime() const noexcept;
+    qint64 interval() const noexcept;
+    void setInterval(qint64 interval) noexcept;
+
+    /*!
+        Размер данных блока в байтах
+    */
+    qsizetype memoryUsage() const noexcept;
+
+    /*!
+        Освобождает неиспользуемую память после заполнения блока
+    */
+    void shrink();
+
+private:
+    static constexpr int VALUES_COUNT = 6;
+
+    struct ValueState
+    {
+        quint64 value = 0;
+        int leading = 65;     ///< количество старших нулевых бит последнего XOR. 65 - окно не задано
+        int trailing = 0;
+    };
+
+    class Decoder
+    {
+    public:
+        explicit Decoder(const KLinesBlock& block);
+
+        KLineView next();
+
+    private:
+        quint64 readBits(int count);
+        double readValue(ValueState& state);
+
+    private:
+        const KLinesBlock& _block;
+        qsizetype _position = 0;
+        quint32 _index = 0;
+        qint64 _openTime = 0;
+        qint64 _delta = 0;
+        std::array<ValueState, VALUES_COUNT> _values;
+    };
+
+    void writeBits(quint64 value, int count);
+    void writeValue(double value, ValueState& state);
+
+private:
+    std::vector<quint64> _bits;
+    qsizetype _bitsCount = 0;
+
+    quint32 _count = 0;
+    qint64 _interval = 0;
+    qint64 _firstOpenTime = 0;
+    qint64 _lastOpenTime = 0;
+    qint64 _lastDelta = 0;
+    std::array<ValueState, VALUES_COUNT> _values;
+};
@@ -0,0 +1,104 @@
+//STL
+#include <algorithm>
+
+#include "idinterner.h"
+#include "klinesstore.h"
+#include "klinesgapdetector.h"
+
+using namespace TradingCatCommon;
+
+static const qint64 MAX_GAP_KLINES = 1000; // более длинный пропуск дозагружается только в пределах последних свечей
+
+KLinesGapDetector::KLinesGapDetector(QObject* parent /* = nullptr */)
+    : QObject{parent}
+{
+    qRegisterMetaType<TradingCatCommon::StockExchangeID>("TradingCatCommon::StockExchangeID");
+    qRegisterMetaType<TradingCatCommon::KLineID>("TradingCatCommon::KLineID");
+    qRegisterMetaType<TradingCatCommon::PKLinesList>("TradingCatCommon::PKLinesList");
+    qRegisterMetaType<TradingCatCommon::PKLinesIDList>("TradingCatCommon::PKLinesIDList");
+}
+
+KLinesGapDetector::Metrics KLinesGapDetector::metrics() const
+{
+    Metrics result;
+    result.gaps = _gaps.load(std::memory_order_relaxed);
+    result.missedKLines = _missedKLines.load(std::memory_order_relaxed);
+
+    return result;
+}
+
+void KLinesGapDetector::addKLines(const TradingCatCommon::StockExchangeID &stockExchangeId, const TradingCatCommon::PKLinesList &klines)
+{
+    Q_CHECK_PTR(klines);
+
+    quint32 stockExchangeIndex = 0;
+    auto& nextOpenTime = stockExchangeNextOpenTime(stockExchangeId, stockExchangeIndex);
+
+    for (const auto& kline: *klines)
+    {
+        auto& expectedOpenTime = KLinesGapDetector::expectedOpenTime(nextOpenTime, stockExchangeIndex, kline->id);
+        const auto interval = KLinesStore::klineInterval(kline->id.type);
+
+        if (expectedOpenTime != 0 && kline->openTime > expectedOpenTime)
+        {
+            const auto to = kline->openTime - interval;
+            const auto from = std::max(expectedOpenTime, to - (MAX_GAP_KLINES - 1) * interval);
+
+            _gaps.fetch_add(1, std::memory_order_relaxed);
+            _missedKLines.fetch_add((kline->openTime - expectedOpenTime) / interval, std::memory_order_relaxed);
+
+            emit gapDetected(stockExchangeId, kline->id, from, to);
+        }
+
+        // более старые свечи (обновления и дозагрузка) ожидаемое время не меняют
+        expectedOpenTime = std::max(expectedOpenTime, kline->openTime + interval);
+    }
+}
+
+void KLinesGapDetector::addKLinesID(const TradingCatCommon::StockExchangeID &stockExchangeId, const TradingCatCommon::PKLinesIDList &klinesIdList)
+{
+    Q_CHECK_PTR(klinesIdList);
+
+    IDInterner::klines(IDInterner::stockExchange(stockExchangeId), *klinesIdList);
+}
+
+void KLinesGapDetector::addArchiveKLines(const TradingCatCommon::StockExchangeID &stockExchangeId, const TradingCatCommon::PKLinesList &klines)
+{
+    Q_CHECK_PTR(klines);
+
+    quint32 stockExchangeIndex = 0;
+    auto& nextOpenTime = stockExchangeNextOpenTime(stockExchangeId, stockExchangeIndex);
+
+    for (const auto& kline: *klines)
+    {
+        auto& expectedOpenTime = KLinesGapDetector::expectedOpenTime(nextOpenTime, stockExchangeIndex, kline->id);
+        expectedOpenTime = std::max(expectedOpenTime, kline->openTime + KLinesStore::klineInterval(kline->id.type));
+    }
+}
+
+std::vector<qint64> &KLinesGapDetector::stockExchangeNextOpenTime(const TradingCatCommon::StockExchangeID &stockExchangeId, quint32 &stockExchangeIndex)
+{
+    stockExchangeIndex = IDInterner::stockExchange(stockExchangeId);
+    if (stockExchangeIndex >= _nextOpenTime.size())
+    {
+        _nextOpenTime.resize(stockExchangeIndex + 1);
+    }
+
+    return _nextOpenTime[stockExchangeIndex];
+}
+
+qint64 &KLinesGapDetector::expectedOpenTime(std::vector<qint64> &nextOpenTime, quint32 stockExchangeIndex, const TradingCatCommon::KLineID &klineId)
+{
+    const auto klineIndex = IDInterner::kline(stockExchangeIndex, klineId);
+    if (klineIndex >= nextOpenTime.size())
+    {
+        nextOpenTime.resize(klineIndex + 1, 0);
+    }
+
+    return nextOpenTime[klineIndex];
+}
+
+void KLinesGapDetector::reset()
+{
+    _nextOpenTime.clear();
+}
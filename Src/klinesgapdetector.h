@@ -0,0 +1,84 @@
+#pragma once
+
+//STL
+#include <vector>
+#include <atomic>
+
+//Qt
+#include <QObject>
+
+//My
+#include <TradingCatCommon/stockexchange.h>
+#include <TradingCatCommon/kline.h>
+
+///////////////////////////////////////////////////////////////////////////////
+///     The KLinesGapDetector class - поиск пропущенных свечей. Для каждой свечи
+///         (биржа, KLineID) хранится ожидаемое время открытия следующей свечи. Если
+///         пришла более поздняя свеча, пропущенный интервал сообщается для дозагрузки
+///         только недостающих свечей. Объект живет в потоке биржи и получает свечи до
+///         очередей потребителей: сжатие отстающей очереди не считается пропуском.
+///         Свечи из архива задают ожидаемое время без поиска пропусков, поэтому простой
+///         между последней записанной в архив и первой полученной с биржи свечой
+///         дозагружается
+///
+class KLinesGapDetector final
+    : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Metrics
+    {
+        quint64 gaps = 0;            ///< количество найденных пропусков
+        quint64 missedKLines = 0;    ///< количество пропущенных свечей
+    };
+
+public:
+    explicit KLinesGapDetector(QObject* parent = nullptr);
+    ~KLinesGapDetector() override = default;
+
+    Metrics metrics() const;
+
+public slots:
+    void addKLines(const TradingCatCommon::StockExchangeID& stockExchangeId, const TradingCatCommon::PKLinesList& klines);
+
+    /*!
+        Назначает индексы IDInterner всему списку ID свечей биржи, чтобы поиск индексов
+            свечей в потоках потребителей не добавлял ID по одному
+    */
+    void addKLinesID(const TradingCatCommon::StockExchangeID& stockExchangeId, const TradingCatCommon::PKLinesIDList& klinesIdList);
+
+    /*!
+        Задает ожидаемое время следующей свечи по свечам, загруженным из архива. Пропуски
+            внутри архива не ищутся
+    */
+    void addArchiveKLines(const TradingCatCommon::StockExchangeID& stockExchangeId, const TradingCatCommon::PKLinesList& klines);
+
+    /*!
+        Сброс ожидаемых свечей при перезапуске коннектора биржи. Простой закрывает история,
+            которую новый коннектор загружает при запуске
+    */
+    void reset();
+
+signals:
+    /*!
+        Найден пропуск свечей
+        @param stockExchangeId - биржа
+        @param klineId - ID свечи
+        @param from - время открытия первой пропущенной свечи
+        @param to - время открытия последней пропущенной свечи
+    */
+    void gapDetected(const TradingCatCommon::StockExchangeID& stockExchangeId, const TradingCatCommon::KLineID& klineId, qint64 from, qint64 to);
+
+private:
+    Q_DISABLE_COPY_MOVE(KLinesGapDetector);
+
+    std::vector<qint64>& stockExchangeNextOpenTime(const TradingCatCommon::StockExchangeID& stockExchangeId, quint32& stockExchangeIndex);
+    static qint64& expectedOpenTime(std::vector<qint64>& nextOpenTime, quint32 stockExchangeIndex, const TradingCatCommon::KLineID& klineId);
+
+private:
+    std::vector<std::vector<qint64>> _nextOpenTime;   ///< по индексам IDInterner [биржа][KLineID]. 0 - свечей еще не было
+
+    std::atomic<quint64> _gaps = 0;
+    std::atomic<quint64> _missedKLines = 0;
+};
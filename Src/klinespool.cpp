@@ -0,0 +1,244 @@
+//STL
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <new>
+#include <cstddef>
+
+//Qt
+#include <QMutex>
+
+#include "klinespool.h"
+
+using namespace TradingCatCommon;
+
+static const std::size_t MAX_CACHED_NODES = 64 * 1024; // свободных узлов в пуле одного потока
+
+namespace
+{
+
+std::atomic<quint64> allocatedCount = 0;
+std::atomic<quint64> reusedCount = 0;
+std::atomic<quint64> returnedCount = 0;
+std::atomic<quint64> releasedCount = 0;
+
+struct alignas(std::max_align_t) NodeHeader
+{
+    void* owner = nullptr;        ///< пул, выделивший узел
+    NodeHeader* next = nullptr;   ///< следующий узел в списке возвращенных
+};
+
+/*!
+    Пул узлов одного размера. Свободные узлы своего потока берутся и кладутся без
+        блокировок. Другие потоки добавляют узлы в _returned через compare_exchange, владелец
+        забирает весь список одной операцией exchange, поэтому проблема ABA не возникает.
+        Пулы не удаляются: узел может быть освобожден после завершения потока владельца
+*/
+template <std::size_t Size>
+class NodePool final
+{
+public:
+    static void* allocate()
+    {
+        auto& pool = local();
+
+        if (pool._nodes.empty())
+        {
+            pool.collectReturned();
+        }
+
+        if (!pool._nodes.empty())
+        {
+            const auto header = pool._nodes.back();
+            pool._nodes.pop_back();
+
+            reusedCount.fetch_add(1, std::memory_order_relaxed);
+
+            return header + 1;
+        }
+
+        allocatedCount.fetch_add(1, std::memory_order_relaxed);
+
+        const auto header = static_cast<NodeHeader*>(::operator new(sizeof(NodeHeader) + Size));
+        header->owner = &pool;
+
+        return header + 1;
+    }
+
+    static void release(void* node)
+    {
+        const auto header = static_cast<NodeHeader*>(node) - 1;
+        const auto owner = static_cast<NodePool*>(header->owner);
+
+        if (owner == current().pool)
+        {
+            owner->push(header);
+
+            return;
+        }
+
+        // узел чужого потока - в список возвращенных пула владельца
+        header->next = owner->_returned.load(std::memory_order_relaxed);
+        while (!owner->_returned.compare_exchange_weak(header->next, header, std::memory_order_release, std::memory_order_relaxed))
+        {
+        }
+
+        returnedCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+private:
+    /*!
+        Пул текущего потока. При завершении потока пул переходит в список свободных пулов
+    */
+    struct LocalPool
+    {
+        NodePool* pool = nullptr;
+
+        ~LocalPool()
+        {
+            if (pool == nullptr)
+            {
+                return;
+            }
+
+            QMutexLocker locker(&orphansMutex());
+            orphans().push_back(pool);
+        }
+    };
+
+    NodePool() = default;
+    ~NodePool() = delete;
+
+    static LocalPool& current()
+    {
+        thread_local LocalPool localPool;
+
+        return localPool;
+    }
+
+    static NodePool& local()
+    {
+        auto& localPool = current();
+        if (localPool.pool != nullptr)
+        {
+            return *localPool.pool;
+        }
+
+        {
+            QMutexLocker locker(&orphansMutex());
+
+            auto& orphanList = orphans();
+            if (!orphanList.empty())
+            {
+                localPool.pool = orphanList.back();
+                orphanList.pop_back();
+            }
+        }
+
+        if (localPool.pool == nullptr)
+        {
+            localPool.pool = new NodePool;
+        }
+
+        return *localPool.pool;
+    }
+
+    static QMutex& orphansMutex()
+    {
+        static QMutex mutex;
+
+        return mutex;
+    }
+
+    static std::vector<NodePool*>& orphans()
+    {
+        static std::vector<NodePool*> orphanList;
+
+        return orphanList;
+    }
+
+    void collectReturned()
+    {
+        auto header = _returned.exchange(nullptr, std::memory_order_acquire);
+        while (header != nullptr)
+        {
+            const auto next = header->next;
+            push(header);
+            header = next;
+        }
+    }
+
+    void push(NodeHeader* header)
+    {
+        if (_nodes.size() >= MAX_CACHED_NODES)
+        {
+            ::operator delete(header);
+            releasedCount.fetch_add(1, std::memory_order_relaxed);
+
+            return;
+        }
+
+        _nodes.push_back(header);
+    }
+
+private:
+    std::vector<NodeHeader*> _nodes;                ///< свободные узлы, только поток владельца
+    std::atomic<NodeHeader*> _returned = nullptr;   ///< узлы, освобожденные другими потоками
+};
+
+template <typename T>
+class PoolAllocator
+{
+public:
+    using value_type = T;
+
+    PoolAllocator() = default;
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>&) noexcept
+    {
+    }
+
+    T* allocate(std::size_t count)
+    {
+        Q_ASSERT(count == 1);
+
+        return static_cast<T*>(NodePool<sizeof(T)>::allocate());
+    }
+
+    void deallocate(T* ptr, std::size_t count) noexcept
+    {
+        Q_ASSERT(count == 1);
+
+        NodePool<sizeof(T)>::release(ptr);
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>&) const noexcept
+    {
+        return true;
+    }
+};
+
+} // namespace
+
+TradingCatCommon::PKLine KLinesPool::make()
+{
+    return std::allocate_shared<KLine>(PoolAllocator<KLine>());
+}
+
+TradingCatCommon::PKLine KLinesPool::make(const TradingCatCommon::KLine &kline)
+{
+    return std::allocate_shared<KLine>(PoolAllocator<KLine>(), kline);
+}
+
+KLinesPool::Statistic KLinesPool::statistic()
+{
+    Statistic result;
+    result.allocated = allocatedCount.load(std::memory_order_relaxed);
+    result.reused = reusedCount.load(std::memory_order_relaxed);
+    result.returned = returnedCount.load(std::memory_order_relaxed);
+    result.released = releasedCount.load(std::memory_order_relaxed);
+
+    return result;
+}
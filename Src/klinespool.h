@@ -0,0 +1,40 @@
+#pragma once
+
+//Qt
+#include <QtGlobal>
+
+//My
+#include <TradingCatCommon/kline.h>
+
+///////////////////////////////////////////////////////////////////////////////
+///     The KLinesPool class - выделение памяти под свечи из пулов потоков. Объект
+///         KLine и блок управления shared_ptr размещаются в одном узле, узел помнит
+///         пул потока, который его выделил. Свечи создаются в потоках бирж, а
+///         освобождаются в потоках потребителей, поэтому освобожденный в чужом потоке
+///         узел возвращается в пул владельца через список без блокировок, и поток биржи
+///         забирает возвращенные узлы, когда его свободные узлы заканчиваются.
+///         Пул завершившегося потока передается следующему новому потоку
+///
+class KLinesPool final
+{
+public:
+    struct Statistic
+    {
+        quint64 allocated = 0;   ///< узлов получено у системы
+        quint64 reused = 0;      ///< узлов выдано повторно из пулов
+        quint64 returned = 0;    ///< узлов возвращено в пул владельца из других потоков
+        quint64 released = 0;    ///< узлов возвращено системе
+    };
+
+public:
+    static TradingCatCommon::PKLine make();
+    static TradingCatCommon::PKLine make(const TradingCatCommon::KLine& kline);
+
+    /*!
+        Счетчики по всем потокам
+    */
+    static Statistic statistic();
+
+private:
+    KLinesPool() = delete;
+};
@@ -0,0 +1,237 @@
+//STL
+#include <vector>
+#include <algorithm>
+
+//Qt
+#include <QMutexLocker>
+#include <QDateTime>
+
+#include "idinterner.h"
+#include "klinesqueue.h"
+
+using namespace TradingCatCommon;
+using namespace Common;
+
+static const qint64 COMPACT_LOG_INTERVAL = 60 * 1000; // минимальный интервал между сообщениями о сжатии очереди
+
+KLinesQueue::KLinesQueue(const QString& name, qsizetype maxKLines, QObject* parent /* = nullptr */)
+    : QObject{parent}
+    , _name(name)
+    , _maxKLines(maxKLines)
+{
+    Q_ASSERT(!_name.isEmpty());
+    Q_ASSERT(_maxKLines > 0);
+
+    qRegisterMetaType<TradingCatCommon::StockExchangeID>("TradingCatCommon::StockExchangeID");
+    qRegisterMetaType<TradingCatCommon::PKLinesList>("TradingCatCommon::PKLinesList");
+}
+
+const QString &KLinesQueue::name() const noexcept
+{
+    return _name;
+}
+
+KLinesQueue::Metrics KLinesQueue::metrics() const
+{
+    QMutexLocker<QMutex> locker(&_mutex);
+
+    return _metrics;
+}
+
+void KLinesQueue::setSkipOutdated(bool skip)
+{
+    QMutexLocker<QMutex> locker(&_mutex);
+
+    _isSkipOutdated = skip;
+}
+
+void KLinesQueue::push(const TradingCatCommon::StockExchangeID &stockExchangeId, const TradingCatCommon::PKLinesList &pushedKLines)
+{
+    Q_CHECK_PTR(pushedKLines);
+
+    if (pushedKLines->empty())
+    {
+        return;
+    }
+
+    QString warningMsg;
+
+    {
+        QMutexLocker<QMutex> locker(&_mutex);
+
+        ++_metrics.pushed;
+
+        const auto klines = _isSkipOutdated ? skipOutdated(pushedKLines, _newestOpenTimes[stockExchangeId]) : pushedKLines;
+        if (klines->empty())
+        {
+            return;
+        }
+
+        auto& pending = _pending[stockExchangeId];
+        if (!pending.klines)
+        {
+            // очередь пуста - пакет передаем без копирования
+            pending.klines = klines;
+        }
+        else
+        {
+            // потребитель еще не забрал предыдущий пакет - объединяем
+            if (pending.klines.use_count() > 1)
+            {
+                pending.klines = std::make_shared<KLinesList>(*pending.klines);
+            }
+            _metrics.depth -= static_cast<qsizetype>(pending.klines->size());
+
+            pending.klines->insert(pending.klines->end(), klines->begin(), klines->end());
+
+            ++_metrics.coalesced;
+
+            // потребитель отстает - оставляем только последние свечи. Промежуточные
+            // обновления и закрытые свечи, после которых пришла более новая свеча того же
+            // KLineID, потребитель не получит
+            if (static_cast<qsizetype>(pending.klines->size()) > _maxKLines)
+            {
+                const auto oldSize = pending.klines->size();
+                pending.klines = compact(IDInterner::stockExchange(stockExchangeId), pending.klines);
+
+                ++_metrics.compacted;
+                _metrics.dropped += oldSize - pending.klines->size();
+
+                // при устойчивом отставании сжатие происходит на каждом пакете - пишем в лог не чаще COMPACT_LOG_INTERVAL
+                const auto currentTime = QDateTime::currentMSecsSinceEpoch();
+                if (currentTime - _lastCompactLogTime >= COMPACT_LOG_INTERVAL)
+                {
+                    warningMsg = QString("Queue %1: consumer is behind. Stock exchange %2: %3 klines compacted to %4. Compactions since last message: %5, dropped klines: %6")
+                                     .arg(_name)
+                                     .arg(stockExchangeId.toString())
+                                     .arg(oldSize)
+                                     .arg(pending.klines->size())
+                                     .arg(_metrics.compacted - _lastCompactLogCompacted)
+                                     .arg(_metrics.dropped - _lastCompactLogDropped);
+
+                    _lastCompactLogTime = currentTime;
+                    _lastCompactLogCompacted = _metrics.compacted;
+                    _lastCompactLogDropped = _metrics.dropped;
+                }
+            }
+        }
+
+        _metrics.depth += static_cast<qsizetype>(pending.klines->size());
+        _metrics.maxDepth = std::max(_metrics.maxDepth, _metrics.depth);
+
+        if (!pending.isFlushScheduled)
+        {
+            pending.isFlushScheduled = true;
+
+            QMetaObject::invokeMethod(this,
+                [this, stockExchangeId]()
+                {
+                    flush(stockExchangeId);
+                }, Qt::QueuedConnection);
+        }
+    }
+
+    // сообщение отправляется без блокировки, чтобы обработчик лога не задерживал потоки бирж
+    if (!warningMsg.isEmpty())
+    {
+        emit sendLogMsg(MSG_CODE::WARNING_CODE, warningMsg);
+    }
+}
+
+void KLinesQueue::flush(const TradingCatCommon::StockExchangeID &stockExchangeId)
+{
+    PKLinesList klines;
+
+    {
+        QMutexLocker<QMutex> locker(&_mutex);
+
+        auto it_pending = _pending.find(stockExchangeId);
+        if (it_pending == _pending.end())
+        {
+            return;
+        }
+
+        klines = std::move(it_pending->second.klines);
+        _pending.erase(it_pending);
+
+        if (klines)
+        {
+            _metrics.depth -= static_cast<qsizetype>(klines->size());
+        }
+    }
+
+    if (!klines || klines->empty())
+    {
+        return;
+    }
+
+    emit getKLines(stockExchangeId, klines);
+}
+
+TradingCatCommon::PKLinesList KLinesQueue::skipOutdated(const TradingCatCommon::PKLinesList &klines, qint64 &newestOpenTime)
+{
+    Q_CHECK_PTR(klines);
+
+    for (const auto& kline: *klines)
+    {
+        newestOpenTime = std::max(newestOpenTime, kline->openTime);
+    }
+
+    // свеча устарела, если после ее закрытия прошло больше одного ее интервала
+    const auto isOutdated =
+        [newestOpenTime](const PKLine& kline)
+        {
+            return kline->closeTime + (kline->closeTime - kline->openTime + 1) < newestOpenTime;
+        };
+
+    if (std::none_of(klines->begin(), klines->end(), isOutdated))
+    {
+        return klines;
+    }
+
+    auto result = std::make_shared<KLinesList>();
+    for (const auto& kline: *klines)
+    {
+        if (isOutdated(kline))
+        {
+            ++_metrics.outdated;
+
+            continue;
+        }
+
+        result->push_back(kline);
+    }
+
+    return result;
+}
+
+TradingCatCommon::PKLinesList KLinesQueue::compact(quint32 stockExchangeIndex, const TradingCatCommon::PKLinesList &klines)
+{
+    Q_CHECK_PTR(klines);
+
+    std::unordered_map<quint32, PKLine> lastKLines;
+    lastKLines.reserve(klines->size());
+    std::vector<quint32> order;
+
+    for (const auto& kline: *klines)
+    {
+        const auto klineIndex = IDInterner::kline(stockExchangeIndex, kline->id);
+        auto [it_lastKLines, isNew] = lastKLines.try_emplace(klineIndex, kline);
+        if (isNew)
+        {
+            order.push_back(klineIndex);
+        }
+        else if (it_lastKLines->second->openTime <= kline->openTime)
+        {
+            it_lastKLines->second = kline;
+        }
+    }
+
+    auto result = std::make_shared<KLinesList>();
+    for (const auto& klineIndex: order)
+    {
+        result->push_back(lastKLines.at(klineIndex));
+    }
+
+    return result;
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+//STL
+#include <unordered_map>
+#include <atomic>
+
+//Qt
+#include <QObject>
+#include <QMutex>
+
+//My
+#include <Common/common.h>
+
+#include <TradingCatCommon/stockexchange.h>
+#include <TradingCatCommon/kline.h>
+
+///////////////////////////////////////////////////////////////////////////////
+///     The KLinesQueue class - ограниченная очередь свечей между потоками бирж
+///         и потребителем (TradingData или Detector). Объект должен жить в потоке
+///         потребителя. Пока потребитель занят, новые пакеты одной биржи объединяются
+///         в один, а при отставании от каждой свечи (symbol/interval) остается только
+///         самая свежая. Сжатие отбрасывает промежуточные свечи: если за время отставания
+///         закрылось несколько свечей одного KLineID, потребитель получит только последнюю.
+///         Очередь детектора может пропускать устаревшие свечи (дозагрузку и историю)
+///
+class KLinesQueue final
+    : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Metrics
+    {
+        qsizetype depth = 0;         ///< текущее количество свечей в очереди
+        qsizetype maxDepth = 0;      ///< максимальное количество свечей в очереди
+        quint64 pushed = 0;          ///< количество принятых пакетов
+        quint64 coalesced = 0;       ///< количество пакетов, объединенных с уже ожидающими
+        quint64 compacted = 0;       ///< количество сжатий очереди до последних свечей
+        quint64 dropped = 0;         ///< количество отброшенных устаревших свечей
+        quint64 outdated = 0;        ///< количество пропущенных свечей, закрытых раньше предыдущего интервала
+    };
+
+public:
+    /*!
+        Конструктор
+        @param name - имя очереди для логов
+        @param maxKLines - максимальное количество свечей одной биржи, после которого
+            очередь оставляет только последние свечи по каждому KLineID
+    */
+    explicit KLinesQueue(const QString& name, qsizetype maxKLines, QObject* parent = nullptr);
+    ~KLinesQueue() override = default;
+
+    const QString& name() const noexcept;
+    Metrics metrics() const;
+
+    /*!
+        Пропускать свечи, закрытые раньше, чем за интервал до самой новой свечи биржи.
+            Время отсчитывается по свечам биржи, поэтому воспроизведение записи работает так же.
+            Дозагруженные пропуски и история не порождают событий детектора. Вызывается до начала работы
+    */
+    void setSkipOutdated(bool skip);
+
+public slots:
+    /*!
+        Добавляет пакет в очередь. Потокобезопасен, вызывается через Qt::DirectConnection
+            из потока биржи
+    */
+    void push(const TradingCatCommon::StockExchangeID& stockExchangeId, const TradingCatCommon::PKLinesList& pushedKLines);
+
+signals:
+    /*!
+        Пакет свечей для потребителя. Генерируется в потоке потребителя
+    */
+    void getKLines(const TradingCatCommon::StockExchangeID& stockExchangeId, const TradingCatCommon::PKLinesList& klines);
+
+    /*!
+        Сообщение логеру
+        @param category - категория сообщения
+        @param msg - текст сообщения
+    */
+    void sendLogMsg(Common::MSG_CODE category, const QString& msg);
+
+private:
+    KLinesQueue() = delete;
+    Q_DISABLE_COPY_MOVE(KLinesQueue);
+
+    void flush(const TradingCatCommon::StockExchangeID& stockExchangeId);
+
+    static TradingCatCommon::PKLinesList compact(quint32 stockExchangeIndex, const TradingCatCommon::PKLinesList& klines);
+
+    /*!
+        Удаляет устаревшие свечи. Вызывается под блокировкой
+        @param newestOpenTime - время открытия самой новой свечи биржи, обновляется по пакету
+        @return исходный пакет, если устаревших свечей нет
+    */
+    TradingCatCommon::PKLinesList skipOutdated(const TradingCatCommon::PKLinesList& klines, qint64& newestOpenTime);
+
+private:
+    const QString _name;
+    const qsizetype _maxKLines = 0;
+
+    struct PendingData
+    {
+        TradingCatCommon::PKLinesList klines;
+        bool isFlushScheduled = false;
+    };
+
+    mutable QMutex _mutex;
+    std::unordered_map<TradingCatCommon::StockExchangeID, PendingData> _pending;
+    Metrics _metrics;
+
+    bool _isSkipOutdated = false;
+    std::unordered_map<TradingCatCommon::StockExchangeID, qint64> _newestOpenTimes; ///< время открытия самой новой свечи по бирже
+
+    qint64 _lastCompactLogTime = 0;       ///< время последнего сообщения о сжатии очереди
+    quint64 _lastCompactLogCompacted = 0; ///< значение _metrics.compacted на момент последнего сообщения
+    quint64 _lastCompactLogDropped = 0;   ///< значение _metrics.dropped на момент последнего сообщения
+};
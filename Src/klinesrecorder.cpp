@@ -0,0 +1,194 @@
+//STL
+#include <vector>
+
+//Qt
+#include <QDir>
+#include <QDateTime>
+
+#include "klinesstore.h"
+#include "klinesrecorder.h"
+
+using namespace TradingCatCommon;
+using namespace Common;
+
+static const qint64 FLUSH_INTERVAL = 10 * 1000;
+
+KLinesRecorder::KLinesRecorder(const TradingCatCommon::StockExchangeID& stockExchangeId, const QString& dirName, QObject* parent /* = nullptr */)
+    : QObject{parent}
+    , _stockExchangeId(stockExchangeId)
+    , _dirName(dirName)
+{
+    Q_ASSERT(!_dirName.isEmpty());
+
+    qRegisterMetaType<TradingCatCommon::StockExchangeID>("TradingCatCommon::StockExchangeID");
+    qRegisterMetaType<TradingCatCommon::PKLinesList>("TradingCatCommon::PKLinesList");
+    qRegisterMetaType<TradingCatCommon::PKLinesIDList>("TradingCatCommon::PKLinesIDList");
+    qRegisterMetaType<Common::MSG_CODE>("Common::MSG_CODE");
+}
+
+KLinesRecorder::~KLinesRecorder()
+{
+    stop();
+}
+
+bool KLinesRecorder::readHeader(QDataStream &stream, QString &stockExchangeName)
+{
+    stream.setVersion(QDataStream::Qt_6_0);
+
+    quint32 magic = 0;
+    quint16 version = 0;
+    stream >> magic >> version >> stockExchangeName;
+
+    return stream.status() == QDataStream::Ok && magic == MAGIC && version == VERSION && !stockExchangeName.isEmpty();
+}
+
+QString KLinesRecorder::stockExchangeName(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return QString();
+    }
+
+    QDataStream stream(&file);
+    QString result;
+    if (!readHeader(stream, result))
+    {
+        return QString();
+    }
+
+    return result;
+}
+
+void KLinesRecorder::start()
+{
+    Q_ASSERT(!_isStarted);
+
+    QDir dir(_dirName);
+    if (!dir.mkpath("."))
+    {
+        emit sendLogMsg(_stockExchangeId, MSG_CODE::WARNING_CODE, QString("Cannot create record directory %1. Recording disabled").arg(dir.absolutePath()));
+
+        return;
+    }
+
+    _file = std::make_unique<QFile>(dir.absoluteFilePath(QString("%1_%2.rec").arg(_stockExchangeId.name).arg(QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss"))));
+    if (!_file->open(QIODevice::WriteOnly))
+    {
+        emit sendLogMsg(_stockExchangeId, MSG_CODE::WARNING_CODE, QString("Cannot open record file %1: %2. Recording disabled").arg(_file->fileName()).arg(_file->errorString()));
+
+        _file.reset();
+
+        return;
+    }
+
+    _stream.setDevice(_file.get());
+    _stream.setVersion(QDataStream::Qt_6_0);
+    _stream << MAGIC << VERSION << _stockExchangeId.name;
+
+    _flushTimer = new QTimer(this);
+
+    connect(_flushTimer, SIGNAL(timeout()), SLOT(flushTimerTimeout()));
+
+    _flushTimer->start(FLUSH_INTERVAL);
+
+    emit sendLogMsg(_stockExchangeId, MSG_CODE::INFORMATION_CODE, QString("Record klines to %1").arg(_file->fileName()));
+
+    _isStarted = true;
+}
+
+void KLinesRecorder::stop()
+{
+    if (!_isStarted)
+    {
+        return;
+    }
+
+    delete _flushTimer;
+    _flushTimer = nullptr;
+
+    _stream.setDevice(nullptr);
+    _file->close();
+    _file.reset();
+
+    _symbols.clear();
+
+    _isStarted = false;
+}
+
+void KLinesRecorder::addKLinesID(const TradingCatCommon::StockExchangeID &stockExchangeId, const TradingCatCommon::PKLinesIDList &klinesIdList)
+{
+    Q_CHECK_PTR(klinesIdList);
+    Q_ASSERT(stockExchangeId == _stockExchangeId);
+
+    if (!_isStarted)
+    {
+        return;
+    }
+
+    // индексы новых инструментов записываются до пакета, который на них ссылается
+    std::vector<std::pair<quint32, qint64>> records;
+    records.reserve(klinesIdList->size());
+    for (const auto& klineId: *klinesIdList)
+    {
+        records.emplace_back(symbolIndex(klineId.symbol), KLinesStore::klineInterval(klineId.type));
+    }
+
+    _stream << static_cast<quint8>(RecordType::KLINES_ID) << QDateTime::currentMSecsSinceEpoch() << static_cast<quint32>(records.size());
+    for (const auto& [symbol, interval]: records)
+    {
+        _stream << symbol << interval;
+    }
+}
+
+void KLinesRecorder::addKLines(const TradingCatCommon::StockExchangeID &stockExchangeId, const TradingCatCommon::PKLinesList &klines)
+{
+    Q_CHECK_PTR(klines);
+    Q_ASSERT(stockExchangeId == _stockExchangeId);
+
+    if (!_isStarted)
+    {
+        return;
+    }
+
+    std::vector<quint32> symbols;
+    symbols.reserve(klines->size());
+    for (const auto& kline: *klines)
+    {
+        symbols.push_back(symbolIndex(kline->id.symbol));
+    }
+
+    _stream << static_cast<quint8>(RecordType::KLINES) << QDateTime::currentMSecsSinceEpoch() << static_cast<quint32>(klines->size());
+
+    auto it_symbol = symbols.begin();
+    for (const auto& kline: *klines)
+    {
+        _stream << *(it_symbol++) << KLinesStore::klineInterval(kline->id.type)
+                << kline->openTime << kline->closeTime
+                << kline->open << kline->high << kline->low << kline->close << kline->volume << kline->quoteAssetVolume;
+    }
+}
+
+void KLinesRecorder::flushTimerTimeout()
+{
+    if (!_file->flush() || _stream.status() != QDataStream::Ok)
+    {
+        emit sendLogMsg(_stockExchangeId, MSG_CODE::WARNING_CODE, QString("Cannot write record file %1: %2").arg(_file->fileName()).arg(_file->errorString()));
+    }
+}
+
+quint32 KLinesRecorder::symbolIndex(const QString &symbol)
+{
+    const auto it_symbols = _symbols.find(symbol);
+    if (it_symbols != _symbols.end())
+    {
+        return it_symbols->second;
+    }
+
+    const auto index = static_cast<quint32>(_symbols.size());
+    _symbols.emplace(symbol, index);
+
+    _stream << static_cast<quint8>(RecordType::SYMBOL) << index << symbol;
+
+    return index;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+//STL
+#include <memory>
+#include <unordered_map>
+
+//Qt
+#include <QObject>
+#include <QFile>
+#include <QDataStream>
+#include <QTimer>
+
+//My
+#include <Common/common.h>
+
+#include <TradingCatCommon/stockexchange.h>
+#include <TradingCatCommon/kline.h>
+
+///////////////////////////////////////////////////////////////////////////////
+///     The KLinesRecorder class - запись пакетов getKLinesID/getKLines биржи в двоичный
+///         файл для последующего воспроизведения KLinesReplay. Объект живет в потоке биржи
+///
+///     Формат файла (QDataStream):
+///         заголовок: quint32 MAGIC, quint16 VERSION, QString имя биржи
+///         SYMBOL:    quint8 тип, quint32 индекс, QString инструмент
+///         KLINES_ID: quint8 тип, qint64 время получения, quint32 N, N x (quint32 инструмент, qint64 интервал)
+///         KLINES:    quint8 тип, qint64 время получения, quint32 N, N x (quint32 инструмент, qint64 интервал,
+///                    qint64 openTime, qint64 closeTime, 6 x double open high low close volume quoteAssetVolume)
+///
+class KLinesRecorder final
+    : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr quint32 MAGIC = 0x54435243; // TCRC
+    static constexpr quint16 VERSION = 1;
+
+    enum class RecordType: quint8
+    {
+        SYMBOL = 0,
+        KLINES_ID = 1,
+        KLINES = 2
+    };
+
+public:
+    /*!
+        Конструктор
+        @param stockExchangeId - биржа
+        @param dirName - каталог записи. Имя файла - <биржа>_<время запуска>.rec
+    */
+    KLinesRecorder(const TradingCatCommon::StockExchangeID& stockExchangeId, const QString& dirName, QObject* parent = nullptr);
+    ~KLinesRecorder() override;
+
+    /*!
+        Читает заголовок файла записи
+        @param stream - поток файла записи
+        @param stockExchangeName[out] - имя записанной биржи
+        @return true - заголовок корректен
+    */
+    static bool readHeader(QDataStream& stream, QString& stockExchangeName);
+
+    /*!
+        Имя биржи из заголовка файла записи
+        @return пустая строка - файл не открывается или не является записью
+    */
+    static QString stockExchangeName(const QString& fileName);
+
+public slots:
+    void start();
+    void stop();
+
+    void addKLinesID(const TradingCatCommon::StockExchangeID& stockExchangeId, const TradingCatCommon::PKLinesIDList& klinesIdList);
+    void addKLines(const TradingCatCommon::StockExchangeID& stockExchangeId, const TradingCatCommon::PKLinesList& klines);
+
+signals:
+    void sendLogMsg(const TradingCatCommon::StockExchangeID& stockExchangeId, Common::MSG_CODE category, const QString& msg);
+
+private slots:
+    void flushTimerTimeout();
+
+private:
+    KLinesRecorder() = delete;
+    Q_DISABLE_COPY_MOVE(KLinesRecorder);
+
+    quint32 symbolIndex(const QString& symbol);
+
+private:
+    const TradingCatCommon::StockExchangeID _stockExchangeId;
+    const QString _dirName;
+
+    std::unique_ptr<QFile> _file;
+    QDataStream _stream;
+    QTimer* _flushTimer = nullptr;
+
+    std::unordered_map<QString, quint32> _symbols;   ///< индексы уже записанных инструментов
+
+    bool _isStarted = false;
+};
@@ -0,0 +1,230 @@
+//STL
+#include <algorithm>
+
+#include "klinespool.h"
+#include "klinesreplay.h"
+
+using namespace TradingCatCommon;
+using namespace Common;
+
+KLinesReplay::KLinesReplay(const TradingCatCommon::StockExchangeID& stockExchangeId, const QString& fileName, double speed, QObject* parent /* = nullptr */)
+    : QObject{parent}
+    , _stockExchangeId(stockExchangeId)
+    , _fileName(fileName)
+    , _speed(speed)
+{
+    Q_ASSERT(!_fileName.isEmpty());
+    Q_ASSERT(_speed >= 0.0);
+
+    qRegisterMetaType<TradingCatCommon::StockExchangeID>("TradingCatCommon::StockExchangeID");
+    qRegisterMetaType<TradingCatCommon::PKLinesList>("TradingCatCommon::PKLinesList");
+    qRegisterMetaType<TradingCatCommon::PKLinesIDList>("TradingCatCommon::PKLinesIDList");
+    qRegisterMetaType<Common::MSG_CODE>("Common::MSG_CODE");
+    qRegisterMetaType<Common::EXIT_CODE>("Common::EXIT_CODE");
+}
+
+KLinesReplay::~KLinesReplay()
+{
+    if (_isStarted)
+    {
+        stop();
+    }
+}
+
+void KLinesReplay::start()
+{
+    Q_ASSERT(!_isStarted);
+
+    _file = std::make_unique<QFile>(_fileName);
+    if (!_file->open(QIODevice::ReadOnly))
+    {
+        emit errorOccurred(_stockExchangeId, EXIT_CODE::LOAD_CONFIG_ERR, QString("Cannot open replay file %1: %2").arg(_fileName).arg(_file->errorString()));
+
+        return;
+    }
+
+    _stream.setDevice(_file.get());
+
+    QString stockExchangeName;
+    if (!KLinesRecorder::readHeader(_stream, stockExchangeName) || stockExchangeName != _stockExchangeId.name)
+    {
+        emit errorOccurred(_stockExchangeId, EXIT_CODE::LOAD_CONFIG_ERR, QString("File %1 is not a record of stock exchange %2").arg(_fileName).arg(_stockExchangeId.name));
+
+        return;
+    }
+
+    _replayTimer = new QTimer(this);
+    _replayTimer->setSingleShot(true);
+
+    connect(_replayTimer, SIGNAL(timeout()), SLOT(replayTimerTimeout()));
+
+    _isStarted = true;
+
+    emit sendLogMsg(_stockExchangeId, MSG_CODE::INFORMATION_CODE, QString("Replay klines from %1 with speed %2").arg(_fileName).arg(_speed > 0.0 ? QString::number(_speed) : QString("max")));
+
+    if (!readNext())
+    {
+        emit sendLogMsg(_stockExchangeId, MSG_CODE::WARNING_CODE, QString("Replay file %1 contains no klines").arg(_fileName));
+
+        return;
+    }
+
+    _firstTime = _nextTime;
+    _elapsedTimer.start();
+
+    schedule();
+}
+
+void KLinesReplay::stop()
+{
+    if (!_isStarted)
+    {
+        emit finished();
+
+        return;
+    }
+
+    delete _replayTimer;
+    _replayTimer = nullptr;
+
+    _stream.setDevice(nullptr);
+    _file.reset();
+
+    _symbols.clear();
+    _nextKLines.reset();
+    _nextKLinesId.reset();
+
+    _isStarted = false;
+
+    emit finished();
+}
+
+void KLinesReplay::replayTimerTimeout()
+{
+    if (_nextType == KLinesRecorder::RecordType::KLINES_ID)
+    {
+        emit getKLinesID(_stockExchangeId, _nextKLinesId);
+    }
+    else
+    {
+        _klines += _nextKLines->size();
+
+        emit getKLines(_stockExchangeId, _nextKLines);
+    }
+    ++_batches;
+
+    if (!readNext())
+    {
+        emit sendLogMsg(_stockExchangeId, MSG_CODE::INFORMATION_CODE, QString("Replay of %1 finished in %2 s: batches: %3 klines: %4")
+                                                                         .arg(_fileName)
+                                                                         .arg(_elapsedTimer.elapsed() / 1000.0, 0, 'f', 1)
+                                                                         .arg(_batches)
+                                                                         .arg(_klines));
+
+        return;
+    }
+
+    schedule();
+}
+
+bool KLinesReplay::readNext()
+{
+    _nextKLines.reset();
+    _nextKLinesId.reset();
+
+    while (!_stream.atEnd())
+    {
+        quint8 type = 0;
+        _stream >> type;
+
+        const auto recordType = static_cast<KLinesRecorder::RecordType>(type);
+        if (recordType == KLinesRecorder::RecordType::SYMBOL)
+        {
+            quint32 index = 0;
+            QString symbol;
+            _stream >> index >> symbol;
+
+            if (index != _symbols.size())
+            {
+                break;
+            }
+            _symbols.push_back(symbol);
+
+            continue;
+        }
+
+        if (recordType != KLinesRecorder::RecordType::KLINES_ID && recordType != KLinesRecorder::RecordType::KLINES)
+        {
+            break;
+        }
+
+        quint32 count = 0;
+        _stream >> _nextTime >> count;
+
+        if (recordType == KLinesRecorder::RecordType::KLINES_ID)
+        {
+            _nextKLinesId = std::make_shared<KLinesIDList>();
+            for (quint32 i = 0; i < count && _stream.status() == QDataStream::Ok; ++i)
+            {
+                quint32 symbol = 0;
+                qint64 interval = 0;
+                _stream >> symbol >> interval;
+
+                if (symbol < _symbols.size())
+                {
+                    _nextKLinesId->emplace(_symbols[symbol], static_cast<KLineType>(interval));
+                }
+            }
+        }
+        else
+        {
+            _nextKLines = std::make_shared<KLinesList>();
+            _nextKLines->reserve(count);
+            for (quint32 i = 0; i < count && _stream.status() == QDataStream::Ok; ++i)
+            {
+                quint32 symbol = 0;
+                qint64 interval = 0;
+                auto kline = KLinesPool::make();
+                _stream >> symbol >> interval
+                        >> kline->openTime >> kline->closeTime
+                        >> kline->open >> kline->high >> kline->low >> kline->close >> kline->volume >> kline->quoteAssetVolume;
+
+                if (symbol < _symbols.size())
+                {
+                    kline->id = KLineID(_symbols[symbol], static_cast<KLineType>(interval));
+                    _nextKLines->push_back(std::move(kline));
+                }
+            }
+        }
+
+        if (_stream.status() != QDataStream::Ok)
+        {
+            break;
+        }
+
+        _nextType = recordType;
+
+        return true;
+    }
+
+    if (_stream.status() != QDataStream::Ok || !_stream.atEnd())
+    {
+        emit sendLogMsg(_stockExchangeId, MSG_CODE::WARNING_CODE, QString("Replay file %1 is corrupted at position %2. Replay stopped").arg(_fileName).arg(_file->pos()));
+    }
+
+    return false;
+}
+
+void KLinesReplay::schedule()
+{
+    if (_speed <= 0.0)
+    {
+        _replayTimer->start(0);
+
+        return;
+    }
+
+    const auto delay = static_cast<qint64>(static_cast<double>(_nextTime - _firstTime) / _speed) - _elapsedTimer.elapsed();
+
+    _replayTimer->start(std::max<qint64>(delay, 0));
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+//STL
+#include <memory>
+#include <vector>
+
+//Qt
+#include <QObject>
+#include <QFile>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QTimer>
+
+//My
+#include <Common/common.h>
+
+#include <TradingCatCommon/stockexchange.h>
+#include <TradingCatCommon/kline.h>
+
+#include "klinesrecorder.h"
+
+///////////////////////////////////////////////////////////////////////////////
+///     The KLinesReplay class - коннектор биржи, воспроизводящий запись KLinesRecorder.
+///         Имеет те же сигналы и слоты, что и коннекторы StockExchange, и подключается
+///         в Core так же. Пакеты передаются с исходными интервалами, деленными на
+///         коэффициент скорости, или без пауз при скорости 0. Объект живет в потоке биржи
+///
+class KLinesReplay final
+    : public QObject
+{
+    Q_OBJECT
+
+public:
+    /*!
+        Конструктор
+        @param stockExchangeId - биржа, от имени которой передаются свечи
+        @param fileName - файл записи
+        @param speed - коэффициент скорости воспроизведения. 1 - исходная, 0 - максимальная
+    */
+    KLinesReplay(const TradingCatCommon::StockExchangeID& stockExchangeId, const QString& fileName, double speed, QObject* parent = nullptr);
+    ~KLinesReplay() override;
+
+public slots:
+    void start();
+    void stop();
+
+signals:
+    void getKLines(const TradingCatCommon::StockExchangeID& stockExchangeId, const TradingCatCommon::PKLinesList& klines);
+    void getKLinesID(const TradingCatCommon::StockExchangeID& stockExchangeId, const TradingCatCommon::PKLinesIDList& klinesIdList);
+
+    void errorOccurred(const TradingCatCommon::StockExchangeID& stockExchangeId, Common::EXIT_CODE errorCode, const QString& errorString);
+    void sendLogMsg(const TradingCatCommon::StockExchangeID& stockExchangeId, Common::MSG_CODE category, const QString& msg);
+
+    void finished();
+
+private slots:
+    void replayTimerTimeout();
+
+private:
+    KLinesReplay() = delete;
+    Q_DISABLE_COPY_MOVE(KLinesReplay);
+
+    /*!
+        Читает следующий пакет записи
+        @return false - записи закончились или файл поврежден
+    */
+    bool readNext();
+    void schedule();
+
+private:
+    const TradingCatCommon::StockExchangeID _stockExchangeId;
+    const QString _fileName;
+    const double _speed = 1.0;
+
+    std::unique_ptr<QFile> _file;
+    QDataStream _stream;
+    QTimer* _replayTimer = nullptr;
+    QElapsedTimer _elapsedTimer;
+
+    std::vector<QString> _symbols;                        ///< инструменты по индексу в записи
+
+    KLinesRecorder::RecordType _nextType = KLinesRecorder::RecordType::KLINES;
+    qint64 _nextTime = 0;                                 ///< время получения следующего пакета
+    qint64 _firstTime = 0;                                ///< время получения первого пакета
+    TradingCatCommon::PKLinesList _nextKLines;
+    TradingCatCommon::PKLinesIDList _nextKLinesId;
+
+    quint64 _batches = 0;
+    quint64 _klines = 0;
+
+    bool _isStarted = false;
+};
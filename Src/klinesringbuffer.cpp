@@ -0,0 +1,280 @@
+//STL
+#include <algorithm>
+
+#include "klinesringbuffer.h"
+
+using namespace TradingCatCommon;
+
+KLinesRingBuffer::KLinesRingBuffer(qsizetype capacity, qint64 interval)
+    : _capacity(capacity)
+    , _interval(interval)
+{
+    Q_ASSERT(_capacity > 0);
+    Q_ASSERT(_interval > 0);
+}
+
+bool KLinesRingBuffer::push(const TradingCatCommon::KLine &kline)
+{
+    qsizetype row = 0;
+
+    if (_size > 0 && kline.openTime <= _openTime[physical(_size - 1)])
+    {
+        // обновление уже сохраненной свечи
+        const auto index = lowerBound(kline.openTime);
+        if (index == 0 && _openTime[physical(0)] != kline.openTime)
+        {
+            return false;
+        }
+
+        if (_openTime[physical(index)] == kline.openTime)
+        {
+            row = physical(index);
+        }
+        else
+        {
+            // пропущенная свеча внутри буфера (дозагрузка пропуска)
+            row = insert(index);
+        }
+    }
+    else
+    {
+        const auto allocated = static_cast<qsizetype>(_openTime.size());
+        if (_size < allocated)
+        {
+            row = physical(_size);
+            ++_size;
+        }
+        else if (allocated < _capacity)
+        {
+            // массивы растут до емкости буфера по мере поступления свечей
+            if (_head != 0)
+            {
+                for (auto column: {&_open, &_high, &_low, &_close, &_volume, &_quoteAssetVolume})
+                {
+                    std::rotate(column->begin(), column->begin() + _head, column->end());
+                }
+                std::rotate(_openTime.begin(), _openTime.begin() + _head, _openTime.end());
+                _head = 0;
+            }
+
+            _openTime.push_back(0);
+            for (auto column: {&_open, &_high, &_low, &_close, &_volume, &_quoteAssetVolume})
+            {
+                column->push_back(0.0);
+            }
+
+            row = _size;
+            ++_size;
+        }
+        else
+        {
+            // буфер заполнен - перезаписываем самую старую свечу
+            row = _head;
+            _head = (_head + 1) % allocated;
+        }
+    }
+
+    _openTime[row] = kline.openTime;
+    _open[row] = kline.open;
+    _high[row] = kline.high;
+    _low[row] = kline.low;
+    _close[row] = kline.close;
+    _volume[row] = kline.volume;
+    _quoteAssetVolume[row] = kline.quoteAssetVolume;
+
+    return true;
+}
+
+bool KLinesRingBuffer::isEvicting(qint64 openTime) const
+{
+    if (_size < _capacity || openTime < _openTime[physical(0)])
+    {
+        return false;
+    }
+
+    const auto index = lowerBound(openTime);
+
+    return index == _size || _openTime[physical(index)] != openTime;
+}
+
+qsizetype KLinesRingBuffer::size() const noexcept
+{
+    return _size;
+}
+
+qsizetype KLinesRingBuffer::capacity() const noexcept
+{
+    return _capacity;
+}
+
+bool KLinesRingBuffer::empty() const noexcept
+{
+    return _size == 0;
+}
+
+qint64 KLinesRingBuffer::interval() const noexcept
+{
+    return _interval;
+}
+
+KLinesRingBuffer::KLineView KLinesRingBuffer::at(qsizetype index) const
+{
+    Q_ASSERT(index >= 0 && index < _size);
+
+    return view(physical(index));
+}
+
+KLinesRingBuffer::KLineView KLinesRingBuffer::back() const
+{
+    return at(_size - 1);
+}
+
+qsizetype KLinesRingBuffer::lowerBound(qint64 openTime) const
+{
+    qsizetype first = 0;
+    qsizetype count = _size;
+
+    while (count > 0)
+    {
+        const auto step = count / 2;
+        const auto index = first + step;
+        if (_openTime[physical(index)] < openTime)
+        {
+            first = index + 1;
+            count -= step + 1;
+        }
+        else
+        {
+            count = step;
+        }
+    }
+
+    return first;
+}
+
+void KLinesRingBuffer::popFront(qsizetype count)
+{
+    count = std::min(count, _size);
+    if (count <= 0)
+    {
+        return;
+    }
+
+    _head = (_head + count) % static_cast<qsizetype>(_openTime.size());
+    _size -= count;
+}
+
+void KLinesRingBuffer::setCapacity(qsizetype capacity)
+{
+    Q_ASSERT(capacity > 0);
+
+    if (capacity >= _capacity)
+    {
+        return;
+    }
+
+    const auto allocated = static_cast<qsizetype>(_openTime.size());
+    if (capacity >= allocated)
+    {
+        _capacity = capacity;
+
+        return;
+    }
+
+    // оставляем capacity самых новых свечей в начале массивов
+    const auto count = std::min(_size, capacity);
+    const auto first = (_head + _size - count) % allocated;
+
+    if (first != 0)
+    {
+        for (auto column: {&_open, &_high, &_low, &_close, &_volume, &_quoteAssetVolume})
+        {
+            std::rotate(column->begin(), column->begin() + first, column->end());
+        }
+        std::rotate(_openTime.begin(), _openTime.begin() + first, _openTime.end());
+    }
+
+    _openTime.resize(count);
+    _openTime.shrink_to_fit();
+    for (auto column: {&_open, &_high, &_low, &_close, &_volume, &_quoteAssetVolume})
+    {
+        column->resize(count);
+        column->shrink_to_fit();
+    }
+
+    _capacity = capacity;
+    _head = 0;
+    _size = count;
+}
+
+qsizetype KLinesRingBuffer::memoryUsage() const noexcept
+{
+    return static_cast<qsizetype>(sizeof(KLinesRingBuffer) + _openTime.capacity() * (sizeof(qint64) + 6 * sizeof(double)));
+}
+
+qsizetype KLinesRingBuffer::insert(qsizetype index)
+{
+    Q_ASSERT(index > 0 && index < _size);
+
+    // вставка выполняется в линейном представлении буфера
+    if (_head != 0)
+    {
+        for (auto column: {&_open, &_high, &_low, &_close, &_volume, &_quoteAssetVolume})
+        {
+            std::rotate(column->begin(), column->begin() + _head, column->end());
+        }
+        std::rotate(_openTime.begin(), _openTime.begin() + _head, _openTime.end());
+        _head = 0;
+    }
+
+    const auto allocated = static_cast<qsizetype>(_openTime.size());
+    if (_size == allocated && allocated == _capacity)
+    {
+        // буфер заполнен - самая старая свеча удаляется, более старые свечи сдвигаются к началу
+        std::move(_openTime.begin() + 1, _openTime.begin() + index, _openTime.begin());
+        for (auto column: {&_open, &_high, &_low, &_close, &_volume, &_quoteAssetVolume})
+        {
+            std::move(column->begin() + 1, column->begin() + index, column->begin());
+        }
+
+        return index - 1;
+    }
+
+    if (_size == allocated)
+    {
+        _openTime.push_back(0);
+        for (auto column: {&_open, &_high, &_low, &_close, &_volume, &_quoteAssetVolume})
+        {
+            column->push_back(0.0);
+        }
+    }
+
+    std::move_backward(_openTime.begin() + index, _openTime.begin() + _size, _openTime.begin() + _size + 1);
+    for (auto column: {&_open, &_high, &_low, &_close, &_volume, &_quoteAssetVolume})
+    {
+        std::move_backward(column->begin() + index, column->begin() + _size, column->begin() + _size + 1);
+    }
+    ++_size;
+
+    return index;
+}
+
+qsizetype KLinesRingBuffer::physical(qsizetype index) const noexcept
+{
+    return (_head + index) % static_cast<qsizetype>(_openTime.size());
+}
+
+KLinesRingBuffer::KLineView KLinesRingBuffer::view(qsizetype row) const
+{
+    KLineView result;
+    result.openTime = _openTime[row];
+    result.closeTime = _openTime[row] + _interval - 1;
+    result.open = _open[row];
+    result.high = _high[row];
+    result.low = _low[row];
+    result.close = _close[row];
+    result.volume = _volume[row];
+    result.quoteAssetVolume = _quoteAssetVolume[row];
+
+    return result;
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+//STL
+#include <vector>
+
+//Qt
+#include <QtGlobal>
+
+//My
+#include <TradingCatCommon/kline.h>
+
+///////////////////////////////////////////////////////////////////////////////
+///     The KLinesRingBuffer class - кольцевой буфер свечей одного KLineID фиксированной
+///         емкости. Время открытия и OHLCV хранятся в отдельных непрерывных массивах,
+///         свечи упорядочены по времени открытия. При заполнении буфера самые старые
+///         свечи перезаписываются
+///
+class KLinesRingBuffer final
+{
+public:
+    /*!
+        Представление одной свечи буфера без создания объекта KLine
+    */
+    struct KLineView
+    {
+        qint64 openTime = 0;
+        qint64 closeTime = 0;
+        double open = 0.0;
+        double high = 0.0;
+        double low = 0.0;
+        double close = 0.0;
+        double volume = 0.0;
+        double quoteAssetVolume = 0.0;
+    };
+
+public:
+    /*!
+        Конструктор
+        @param capacity - максимальное количество свечей
+        @param interval - интервал свечи в мс
+    */
+    KLinesRingBuffer(qsizetype capacity, qint64 interval);
+
+    KLinesRingBuffer(const KLinesRingBuffer&) = default;
+    KLinesRingBuffer& operator=(const KLinesRingBuffer&) = default;
+    KLinesRingBuffer(KLinesRingBuffer&&) = default;
+    KLinesRingBuffer& operator=(KLinesRingBuffer&&) = default;
+
+    /*!
+        Добавляет свечу. Свеча с тем же временем открытия, что и у уже сохраненной,
+            заменяет ее (обновление незакрытой свечи). Пропущенная свеча внутри буфера
+            вставляется на свое место. Свечи старше самой старой в буфере игнорируются
+        @return true - если свеча сохранена
+    */
+    bool push(const TradingCatCommon::KLine& kline);
+
+    /*!
+        Проверяет, вытеснит ли push() свечи с временем открытия openTime самую старую
+            свечу буфера: буфер заполнен и свечи с таким временем открытия в нем нет
+    */
+    bool isEvicting(qint64 openTime) const;
+
+    qsizetype size() const noexcept;
+    qsizetype capacity() const noexcept;
+    bool empty() const noexcept;
+    qint64 interval() const noexcept;
+
+    /*!
+        Свеча по индексу. 0 - самая старая
+    */
+    KLineView at(qsizetype index) const;
+    KLineView back() const;
+
+    /*!
+        Индекс первой свечи с временем открытия не меньше openTime. size() - если такой нет
+    */
+    qsizetype lowerBound(qint64 openTime) const;
+
+    /*!
+        Вызывает func(const KLineView&) для каждой свечи с временем открытия в [from, to]
+    */
+    template <typename Func>
+    void forEach(qint64 from, qint64 to, Func func) const
+    {
+        for (auto index = lowerBound(from); index < _size; ++index)
+        {
+            const auto row = physical(index);
+            if (_openTime[row] > to)
+            {
+                break;
+            }
+
+            func(view(row));
+        }
+    }
+
+    /*!
+        Удаляет count самых старых свечей
+    */
+    void popFront(qsizetype count);
+
+    /*!
+        Уменьшает емкость буфера. Сохраняются capacity самых новых свечей, память
+            освобождается. Значение больше текущей емкости игнорируется
+    */
+    void setCapacity(qsizetype capacity);
+
+    /*!
+        Размер данных буфера в байтах
+    */
+    qsizetype memoryUsage() const noexcept;
+
+private:
+    /*!
+        Освобождает место для свечи перед свечой с индексом index
+        @return физический индекс строки для новой свечи
+    */
+    qsizetype insert(qsizetype index);
+
+    qsizetype physical(qsizetype index) const noexcept;
+    KLineView view(qsizetype row) const;
+
+private:
+    qsizetype _capacity = 0;
+    qint64 _interval = 0;
+
+    qsizetype _head = 0;   ///< физический индекс самой старой свечи
+    qsizetype _size = 0;
+
+    std::vector<qint64> _openTime;
+    std::vector<double> _open;
+    std::vector<double> _high;
+    std::vector<double> _low;
+    std::vector<double> _close;
+    std::vector<double> _volume;
+    std::vector<double> _quoteAssetVolume;
+};
@@ -0,0 +1,355 @@
+//STL
+#include <algorithm>
+#include <queue>
+#include <functional>
+
+//Qt
+#include <QDateTime>
+
+//My
+#include "idinterner.h"
+#include "klinesstore.h"
+
+using namespace TradingCatCommon;
+using namespace Common;
+
+static const qsizetype BLOCK_KLINES = 128; // количество свечей в одном сжатом блоке
+static const qsizetype RECENT_KLINES = 2 * BLOCK_KLINES; // несжатых свечей одного KLineID: незакрытая свеча и один блок до сжатия
+static const qint64 EVICT_LOG_INTERVAL = 60 * 1000; // при постоянном превышении бюджета сообщение пишется в лог не чаще
+
+KLinesStore::KLinesSeries::KLinesSeries(quint32 stockExchangeIndex, qsizetype capacity, qint64 interval)
+    : stockExchangeIndex(stockExchangeIndex)
+    , recent(capacity, interval)
+{
+}
+
+qsizetype KLinesStore::KLinesSeries::memoryUsage() const noexcept
+{
+    return static_cast<qsizetype>(sizeof(KLinesSeries)) + recent.memoryUsage() + blocksMemory;
+}
+
+KLinesStore::KLinesStore(qsizetype capacity, QObject* parent /* = nullptr */)
+    : QObject{parent}
+    , _recentCapacity(std::min(capacity, RECENT_KLINES))
+    , _historyCapacity(capacity - _recentCapacity)
+{
+    Q_ASSERT(capacity > 0);
+}
+
+void KLinesStore::setMemoryBudget(qsizetype budget)
+{
+    Q_ASSERT(budget >= 0);
+
+    QWriteLocker locker(&_lock);
+
+    _memoryBudget = budget;
+}
+
+void KLinesStore::setMemoryBudget(const TradingCatCommon::StockExchangeID &stockExchangeId, qsizetype budget)
+{
+    Q_ASSERT(budget >= 0);
+
+    const auto stockExchangeIndex = IDInterner::stockExchange(stockExchangeId);
+
+    QWriteLocker locker(&_lock);
+
+    if (stockExchangeIndex >= _stockExchangesMemoryBudget.size())
+    {
+        _stockExchangesMemoryBudget.resize(stockExchangeIndex + 1, 0);
+    }
+    _stockExchangesMemoryBudget[stockExchangeIndex] = budget;
+}
+
+qint64 KLinesStore::klineInterval(TradingCatCommon::KLineType type) noexcept
+{
+    return static_cast<qint64>(type);
+}
+
+qsizetype KLinesStore::klinesCount() const
+{
+    QReadLocker locker(&_lock);
+
+    qsizetype result = 0;
+    for (const auto& stockExchange: _data)
+    {
+        for (const auto& series: stockExchange)
+        {
+            if (series)
+            {
+                result += series->recent.size() + series->blocksKLinesCount;
+            }
+        }
+    }
+
+    return result;
+}
+
+qsizetype KLinesStore::memoryUsage() const
+{
+    QReadLocker locker(&_lock);
+
+    return _memory;
+}
+
+quint64 KLinesStore::evictedKLines() const
+{
+    QReadLocker locker(&_lock);
+
+    return _evictedKLines;
+}
+
+bool KLinesStore::readRange(const TradingCatCommon::StockExchangeID& stockExchangeId, const TradingCatCommon::KLineID& klineId,
+                            qint64 from, qint64 to, qsizetype limit, std::vector<KLinesRingBuffer::KLineView>& result) const
+{
+    Q_ASSERT(limit > 0);
+
+    QReadLocker locker(&_lock);
+
+    const auto series = findSeries(stockExchangeId, klineId);
+    if (series == nullptr)
+    {
+        return false;
+    }
+
+    const auto addKLine =
+        [&result, limit](const KLinesRingBuffer::KLineView& kline)
+        {
+            if (static_cast<qsizetype>(result.size()) < limit)
+            {
+                result.push_back(kline);
+            }
+        };
+
+    // блоки, целиком лежащие раньше from, не распаковываются
+    auto it_block = std::lower_bound(series->blocks.begin(), series->blocks.end(), from,
+        [](const KLinesBlock& block, qint64 openTime)
+        {
+            return block.lastOpenTime() < openTime;
+        });
+
+    for (; it_block != series->blocks.end() && static_cast<qsizetype>(result.size()) < limit; ++it_block)
+    {
+        if (it_block->firstOpenTime() > to)
+        {
+            return true;
+        }
+
+        it_block->forEach(from, to, addKLine);
+    }
+
+    series->recent.forEach(from, to, addKLine);
+
+    return true;
+}
+
+void KLinesStore::addKLines(const TradingCatCommon::StockExchangeID &stockExchangeId, const TradingCatCommon::PKLinesList &klines)
+{
+    Q_CHECK_PTR(klines);
+
+    const auto stockExchangeIndex = IDInterner::stockExchange(stockExchangeId);
+
+    QWriteLocker locker(&_lock);
+
+    if (stockExchangeIndex >= _data.size())
+    {
+        _data.resize(stockExchangeIndex + 1);
+        _stockExchangesMemory.resize(stockExchangeIndex + 1, 0);
+        _stockExchangesEvictionExhausted.resize(stockExchangeIndex + 1, false);
+    }
+    auto& stockExchangeData = _data[stockExchangeIndex];
+
+    for (const auto& kline: *klines)
+    {
+        const auto klineIndex = IDInterner::kline(stockExchangeIndex, kline->id);
+        if (klineIndex >= stockExchangeData.size())
+        {
+            const auto oldCapacity = stockExchangeData.capacity();
+            stockExchangeData.resize(klineIndex + 1);
+
+            const auto delta = static_cast<qsizetype>((stockExchangeData.capacity() - oldCapacity) * sizeof(std::unique_ptr<KLinesSeries>));
+            _stockExchangesMemory[stockExchangeIndex] += delta;
+            _memory += delta;
+        }
+
+        auto& series = stockExchangeData[klineIndex];
+        if (!series)
+        {
+            series = std::make_unique<KLinesSeries>(stockExchangeIndex, _recentCapacity, klineInterval(kline->id.type));
+            account(*series, series->memoryUsage());
+        }
+
+        const auto oldMemory = series->memoryUsage();
+
+        // буфер заполнен и новая или дозагруженная свеча вытеснит самую старую - сжимаем старые свечи
+        if (_historyCapacity > 0 && series->recent.isEvicting(kline->openTime))
+        {
+            seal(*series);
+            resetEvictionExhausted(stockExchangeIndex);
+        }
+
+        series->recent.push(*kline);
+
+        account(*series, series->memoryUsage() - oldMemory);
+    }
+
+    const auto stockExchangeBudget = stockExchangeIndex < _stockExchangesMemoryBudget.size() ? _stockExchangesMemoryBudget[stockExchangeIndex] : 0;
+    if (stockExchangeBudget > 0 && _stockExchangesMemory[stockExchangeIndex] > stockExchangeBudget && !_stockExchangesEvictionExhausted[stockExchangeIndex])
+    {
+        _stockExchangesEvictionExhausted[stockExchangeIndex] = !evict(stockExchangeIndex, stockExchangeBudget - stockExchangeBudget / 10);
+    }
+
+    if (_memoryBudget > 0 && _memory > _memoryBudget && !_isEvictionExhausted)
+    {
+        _isEvictionExhausted = !evict(IDInterner::NO_INDEX, _memoryBudget - _memoryBudget / 10);
+    }
+}
+
+void KLinesStore::resetEvictionExhausted(quint32 stockExchangeIndex)
+{
+    _stockExchangesEvictionExhausted[stockExchangeIndex] = false;
+    _isEvictionExhausted = false;
+}
+
+const KLinesStore::KLinesSeries* KLinesStore::findSeries(const TradingCatCommon::StockExchangeID& stockExchangeId, const TradingCatCommon::KLineID& klineId) const
+{
+    const auto stockExchangeIndex = IDInterner::findStockExchange(stockExchangeId);
+    if (stockExchangeIndex >= _data.size())
+    {
+        return nullptr;
+    }
+
+    const auto& stockExchangeData = _data[stockExchangeIndex];
+
+    const auto klineIndex = IDInterner::findKLine(stockExchangeIndex, klineId);
+    if (klineIndex >= stockExchangeData.size())
+    {
+        return nullptr;
+    }
+
+    return stockExchangeData[klineIndex].get();
+}
+
+void KLinesStore::seal(KLinesSeries& series)
+{
+    auto& recent = series.recent;
+
+    // в буфере остается не меньше половины свечей, в том числе незакрытая
+    const auto count = std::max<qsizetype>(std::min(BLOCK_KLINES, recent.size() / 2), 1);
+
+    KLinesBlock block;
+    block.setInterval(recent.interval());
+    for (qsizetype index = 0; index < count; ++index)
+    {
+        block.append(recent.at(index));
+    }
+    block.shrink();
+
+    recent.popFront(count);
+
+    series.blocksKLinesCount += block.count();
+    series.blocksMemory += block.memoryUsage();
+    series.blocks.emplace_back(std::move(block));
+
+    while (series.blocksKLinesCount > _historyCapacity && !series.blocks.empty())
+    {
+        popFrontBlock(series);
+    }
+}
+
+void KLinesStore::popFrontBlock(KLinesSeries &series)
+{
+    Q_ASSERT(!series.blocks.empty());
+
+    const auto& block = series.blocks.front();
+    series.blocksKLinesCount -= block.count();
+    series.blocksMemory -= block.memoryUsage();
+    series.blocks.pop_front();
+}
+
+void KLinesStore::account(const KLinesSeries &series, qsizetype delta)
+{
+    _stockExchangesMemory[series.stockExchangeIndex] += delta;
+    _memory += delta;
+}
+
+bool KLinesStore::evict(quint32 stockExchangeIndex, qsizetype target)
+{
+    const auto memory =
+        [this, stockExchangeIndex]()
+        {
+            return stockExchangeIndex == IDInterner::NO_INDEX ? _memory : _stockExchangesMemory[stockExchangeIndex];
+        };
+
+    std::vector<KLinesSeries*> seriesList;
+    for (quint32 index = 0; index < _data.size(); ++index)
+    {
+        if (stockExchangeIndex != IDInterner::NO_INDEX && index != stockExchangeIndex)
+        {
+            continue;
+        }
+
+        for (const auto& series: _data[index])
+        {
+            if (series)
+            {
+                seriesList.push_back(series.get());
+            }
+        }
+    }
+
+    const auto oldMemory = memory();
+
+    // самые старые сжатые блоки по всем свечам
+    using OldestBlock = std::pair<qint64, KLinesSeries*>;
+    std::priority_queue<OldestBlock, std::vector<OldestBlock>, std::greater<OldestBlock>> oldestBlocks;
+    for (const auto series: seriesList)
+    {
+        if (!series->blocks.empty())
+        {
+            oldestBlocks.emplace(series->blocks.front().firstOpenTime(), series);
+        }
+    }
+
+    while (memory() > target && !oldestBlocks.empty())
+    {
+        const auto series = oldestBlocks.top().second;
+        oldestBlocks.pop();
+
+        const auto seriesMemory = series->memoryUsage();
+        _evictedKLines += series->blocks.front().count();
+        popFrontBlock(*series);
+        account(*series, series->memoryUsage() - seriesMemory);
+
+        if (!series->blocks.empty())
+        {
+            oldestBlocks.emplace(series->blocks.front().firstOpenTime(), series);
+        }
+    }
+
+    const auto isExhausted = memory() > target;
+
+    // при постоянном превышении бюджета вытеснение идет на каждом пакете - пишем в лог не чаще EVICT_LOG_INTERVAL
+    const auto currentTime = QDateTime::currentMSecsSinceEpoch();
+    if (isExhausted || currentTime - _lastEvictLogTime >= EVICT_LOG_INTERVAL)
+    {
+        const auto stockExchangeName = stockExchangeIndex == IDInterner::NO_INDEX ? QString("all stock exchanges") : IDInterner::stockExchangeId(stockExchangeIndex).toString();
+
+        emit sendLogMsg(MSG_CODE::WARNING_CODE, QString("Memory budget exceeded for %1. Memory reduced from %2 KB to %3 KB. Evicted klines: %4 since last message, %5 total")
+                                                    .arg(stockExchangeName)
+                                                    .arg(oldMemory / 1024)
+                                                    .arg(memory() / 1024)
+                                                    .arg(_evictedKLines - _lastEvictLogKLines)
+                                                    .arg(_evictedKLines));
+        if (isExhausted)
+        {
+            emit sendLogMsg(MSG_CODE::WARNING_CODE, QString("Memory budget for %1 cannot be reached: no compressed klines left, up to %2 uncompressed klines per KLineID are kept. Eviction is paused until new klines are compressed")
+                                                        .arg(stockExchangeName)
+                                                        .arg(_recentCapacity));
+        }
+
+        _lastEvictLogTime = currentTime;
+        _lastEvictLogKLines = _evictedKLines;
+    }
+
+    return !isExhausted;
+}
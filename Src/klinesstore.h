@@ -0,0 +1,134 @@
+#pragma once
+
+//STL
+#include <deque>
+#include <vector>
+#include <memory>
+
+//Qt
+#include <QObject>
+#include <QReadWriteLock>
+
+//My
+#include <Common/common.h>
+
+#include <TradingCatCommon/stockexchange.h>
+#include <TradingCatCommon/kline.h>
+
+#include "klinesringbuffer.h"
+#include "klinescodec.h"
+
+///////////////////////////////////////////////////////////////////////////////
+///     The KLinesStore class - хранилище истории свечей по биржам для запроса /data/klines.
+///         Последние свечи каждого KLineID хранятся без сжатия в небольшом кольцевом буфере
+///         KLinesRingBuffer (незакрытая свеча еще обновляется), более старые закрытые свечи
+///         сжимаются блоками KLinesBlock. Всего хранится до capacity свечей на KLineID.
+///         При превышении бюджета памяти (общего или биржи) удаляются самые старые сжатые
+///         блоки по всем свечам. Если удалять больше нечего, вытеснение не выполняется
+///         до появления новых блоков. Бюджет ограничивает только это хранилище: память
+///         TradingData и очередей свечей не ограничивается.
+///         Запись выполняется в потоке TradingData, чтение - из любого потока.
+///         Детектор читает свечи из TradingData, поэтому хранилище создается только
+///         при [SYSTEM]/StoreKLinesCount > 0
+///
+class KLinesStore final
+    : public QObject
+{
+    Q_OBJECT
+
+public:
+    /*!
+        Конструктор
+        @param capacity - максимальное количество свечей одного KLineID
+    */
+    explicit KLinesStore(qsizetype capacity, QObject* parent = nullptr);
+    ~KLinesStore() override = default;
+
+    /*!
+        Интервал свечи в мс. Значения KLineType соответствуют длительности интервала
+    */
+    static qint64 klineInterval(TradingCatCommon::KLineType type) noexcept;
+
+    /*!
+        Выбирает свечи с временем открытия в [from, to] из сжатых блоков и кольцевого буфера
+        @param limit - максимальное количество свечей в результате
+        @param result - свечи в порядке возрастания времени открытия
+        @return false - если свечей с таким ID нет
+    */
+    bool readRange(const TradingCatCommon::StockExchangeID& stockExchangeId, const TradingCatCommon::KLineID& klineId,
+                   qint64 from, qint64 to, qsizetype limit, std::vector<KLinesRingBuffer::KLineView>& result) const;
+
+    /*!
+        Бюджет памяти в байтах. 0 - без ограничения. Вызывается до начала работы
+    */
+    void setMemoryBudget(qsizetype budget);
+    void setMemoryBudget(const TradingCatCommon::StockExchangeID& stockExchangeId, qsizetype budget);
+
+    qsizetype klinesCount() const;
+    qsizetype memoryUsage() const;
+    quint64 evictedKLines() const;
+
+public slots:
+    void addKLines(const TradingCatCommon::StockExchangeID& stockExchangeId, const TradingCatCommon::PKLinesList& klines);
+
+signals:
+    /*!
+        Сообщение логеру
+        @param category - категория сообщения
+        @param msg - текст сообщения
+    */
+    void sendLogMsg(Common::MSG_CODE category, const QString& msg);
+
+private:
+    KLinesStore() = delete;
+    Q_DISABLE_COPY_MOVE(KLinesStore);
+
+private:
+    struct KLinesSeries
+    {
+        KLinesSeries(quint32 stockExchangeIndex, qsizetype capacity, qint64 interval);
+
+        qsizetype memoryUsage() const noexcept;
+
+        const quint32 stockExchangeIndex = 0;
+        KLinesRingBuffer recent;              ///< последние свечи, могут обновляться
+        std::deque<KLinesBlock> blocks;       ///< сжатые закрытые свечи в порядке времени
+        qsizetype blocksKLinesCount = 0;
+        qsizetype blocksMemory = 0;
+    };
+
+    const KLinesSeries* findSeries(const TradingCatCommon::StockExchangeID& stockExchangeId, const TradingCatCommon::KLineID& klineId) const;
+    void seal(KLinesSeries& series);
+    void popFrontBlock(KLinesSeries& series);
+    void account(const KLinesSeries& series, qsizetype delta);
+
+    /*!
+        Освобождает память до target байт
+        @param stockExchangeIndex - индекс биржи или IDInterner::NO_INDEX - все биржи
+        @return false - если освобождать больше нечего: сжатых блоков нет
+    */
+    bool evict(quint32 stockExchangeIndex, qsizetype target);
+
+    /*!
+        После добавления блока у биржи снова есть что вытеснять
+    */
+    void resetEvictionExhausted(quint32 stockExchangeIndex);
+
+private:
+    const qsizetype _recentCapacity = 0;   ///< несжатых свечей одного KLineID
+    const qsizetype _historyCapacity = 0;  ///< сжатых свечей одного KLineID
+
+    mutable QReadWriteLock _lock;
+    std::vector<std::vector<std::unique_ptr<KLinesSeries>>> _data; ///< свечи по индексам IDInterner [биржа][KLineID]
+
+    qsizetype _memoryBudget = 0;
+    std::vector<qsizetype> _stockExchangesMemoryBudget;  ///< по индексу биржи
+    std::vector<qsizetype> _stockExchangesMemory;        ///< по индексу биржи
+    qsizetype _memory = 0;
+    quint64 _evictedKLines = 0;
+
+    bool _isEvictionExhausted = false;                   ///< для общего бюджета
+    std::vector<bool> _stockExchangesEvictionExhausted;  ///< по индексу биржи
+    qint64 _lastEvictLogTime = 0;
+    quint64 _lastEvictLogKLines = 0;
+};
@@ -0,0 +1,676 @@
+//STL
+#include <algorithm>
+
+//Qt
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QStringEncoder>
+
+#include "klinespool.h"
+#include "klinesstore.h"
+#include "jsontokenizer.h"
+#include "klinesstream.h"
+
+using namespace TradingCatCommon;
+using namespace Common;
+
+static const qint64 RECONNECT_INTERVAL = 5 * 1000;
+static const qint64 SUBSCRIBE_INTERVAL = 250;     // не более 5 сообщений в секунду
+static const qint64 FLUSH_INTERVAL = 100;         // закрытые свечи всех инструментов приходят почти одновременно
+static const qsizetype SUBSCRIBE_BATCH = 200;     // потоков в одном сообщении SUBSCRIBE
+static const qsizetype MAX_STREAMS = 1024;        // потоков на одно подключение
+static const std::size_t CLOSED_KLINES_HISTORY = 16; // закрытых свечей инструмента, по которым отбрасываются повторы
+
+KLinesStream::KLinesStream(const TradingCatCommon::StockExchangeID& stockExchangeId, const QUrl& url, StreamProxyPool& streamProxyPool, QObject* parent /* = nullptr */)
+    : QObject{parent}
+    , _stockExchangeId(stockExchangeId)
+    , _url(url)
+    , _streamProxyPool(streamProxyPool)
+{
+    Q_ASSERT(_url.isValid());
+
+    qRegisterMetaType<TradingCatCommon::StockExchangeID>("TradingCatCommon::StockExchangeID");
+    qRegisterMetaType<TradingCatCommon::PKLinesList>("TradingCatCommon::PKLinesList");
+    qRegisterMetaType<TradingCatCommon::PKLinesIDList>("TradingCatCommon::PKLinesIDList");
+    qRegisterMetaType<Common::MSG_CODE>("Common::MSG_CODE");
+}
+
+KLinesStream::~KLinesStream()
+{
+    stop();
+}
+
+QString KLinesStream::streamName(const TradingCatCommon::KLineID &klineId)
+{
+    // интервалы потоков kline Binance
+    static const QHash<qint64, QString> INTERVAL_NAMES =
+        {
+            {60 * 1000, "1m"}, {3 * 60 * 1000, "3m"}, {5 * 60 * 1000, "5m"}, {15 * 60 * 1000, "15m"}, {30 * 60 * 1000, "30m"},
+            {60 * 60 * 1000, "1h"}, {2 * 60 * 60 * 1000, "2h"}, {4 * 60 * 60 * 1000, "4h"}, {6 * 60 * 60 * 1000, "6h"},
+            {8 * 60 * 60 * 1000, "8h"}, {12 * 60 * 60 * 1000, "12h"},
+            {24 * 60 * 60 * 1000, "1d"}, {3 * 24 * 60 * 60 * 1000, "3d"}, {7 * 24 * 60 * 60 * 1000, "1w"}
+        };
+
+    const auto it_intervalNames = INTERVAL_NAMES.constFind(KLinesStore::klineInterval(klineId.type));
+    if (it_intervalNames == INTERVAL_NAMES.constEnd())
+    {
+        return QString();
+    }
+
+    return QString("%1@kline_%2").arg(klineId.symbol.toLower()).arg(it_intervalNames.value());
+}
+
+void KLinesStream::start()
+{
+    Q_ASSERT(!_isStarted);
+
+    _webSocket = new QWebSocket(QString(), QWebSocketProtocol::VersionLatest, this);
+
+    connect(_webSocket, SIGNAL(connected()), SLOT(connected()));
+    connect(_webSocket, SIGNAL(disconnected()), SLOT(disconnected()));
+    connect(_webSocket, SIGNAL(textMessageReceived(const QString&)), SLOT(textMessageReceived(const QString&)));
+    connect(_webSocket, SIGNAL(binaryMessageReceived(const QByteArray&)), SLOT(binaryMessageReceived(const QByteArray&)));
+
+    _reconnectTimer = new QTimer(this);
+    _reconnectTimer->setSingleShot(true);
+
+    connect(_reconnectTimer, SIGNAL(timeout()), SLOT(reconnectTimerTimeout()));
+
+    _subscribeTimer = new QTimer(this);
+
+    connect(_subscribeTimer, SIGNAL(timeout()), SLOT(subscribeTimerTimeout()));
+
+    _flushTimer = new QTimer(this);
+    _flushTimer->setSingleShot(true);
+
+    connect(_flushTimer, SIGNAL(timeout()), SLOT(flushTimerTimeout()));
+
+    _klines = std::make_shared<KLinesList>();
+
+    _isStarted = true;
+
+    open();
+}
+
+void KLinesStream::stop()
+{
+    if (!_isStarted)
+    {
+        return;
+    }
+
+    _isStarted = false;
+    _isConnected = false;
+
+    delete _reconnectTimer;
+    _reconnectTimer = nullptr;
+
+    delete _subscribeTimer;
+    _subscribeTimer = nullptr;
+
+    delete _flushTimer;
+    _flushTimer = nullptr;
+
+    _webSocket->disconnect(this);
+    _webSocket->abort();
+    delete _webSocket;
+    _webSocket = nullptr;
+
+    _subscribed.clear();
+    _pendingSubscribe.clear();
+    _pendingUnsubscribe.clear();
+    _klines.reset();
+}
+
+void KLinesStream::reset()
+{
+    if (!_isStarted)
+    {
+        return;
+    }
+
+    stop();
+
+    _streams.clear();
+    _skipped = 0;
+    _restOnly = 0;
+
+    start();
+}
+
+void KLinesStream::addKLinesID(const TradingCatCommon::StockExchangeID &stockExchangeId, const TradingCatCommon::PKLinesIDList &klinesIdList)
+{
+    Q_CHECK_PTR(klinesIdList);
+    Q_ASSERT(stockExchangeId == _stockExchangeId);
+
+    // список полный - свечи, которых в нем нет, больше не торгуются
+    _streams.clear();
+
+    qsizetype restOnly = 0;
+    for (const auto& klineId: *klinesIdList)
+    {
+        const auto name = streamName(klineId);
+        if (name.isEmpty())
+        {
+            ++restOnly;
+
+            continue;
+        }
+
+        _streams.insert(name, klineId);
+    }
+
+    if (restOnly > 0 && restOnly != _restOnly)
+    {
+        emit sendLogMsg(_stockExchangeId, MSG_CODE::INFORMATION_CODE, QString("KLines stream: %1 klines have an interval without a stream and will be updated by REST only")
+                                                                         .arg(restOnly));
+    }
+    _restOnly = restOnly;
+
+    updateSubscriptions();
+}
+
+void KLinesStream::addKLines(const TradingCatCommon::StockExchangeID &stockExchangeId, const TradingCatCommon::PKLinesList &klines)
+{
+    Q_CHECK_PTR(klines);
+    Q_ASSERT(stockExchangeId == _stockExchangeId);
+
+    const auto currentDateTime = QDateTime::currentMSecsSinceEpoch();
+
+    auto result = std::make_shared<KLinesList>();
+    for (const auto& kline: *klines)
+    {
+        // незакрытые свечи потоком не передаются
+        if (kline->closeTime >= currentDateTime)
+        {
+            result->push_back(kline);
+
+            continue;
+        }
+
+        if (!isNewClosedKLine(*kline))
+        {
+            continue;
+        }
+
+        result->push_back(kline);
+    }
+
+    if (result->empty())
+    {
+        return;
+    }
+
+    emit getKLines(_stockExchangeId, result->size() == klines->size() ? klines : result);
+}
+
+void KLinesStream::setDemanded(bool isDemanded)
+{
+    if (_isDemanded == isDemanded)
+    {
+        return;
+    }
+
+    _isDemanded = isDemanded;
+
+    if (!_isConnected)
+    {
+        return;
+    }
+
+    emit sendLogMsg(_stockExchangeId, MSG_CODE::INFORMATION_CODE, _isDemanded ? QString("KLines stream: users with filters are online. Subscribe to klines")
+                                                                              : QString("KLines stream: no users with filters are online. Unsubscribe from %1 streams, klines will be updated by REST only")
+                                                                                    .arg(_subscribed.size()));
+
+    updateSubscriptions();
+}
+
+void KLinesStream::updateSubscriptions()
+{
+    if (!_isConnected)
+    {
+        return;
+    }
+
+    for (auto it_subscribed = _subscribed.begin(); it_subscribed != _subscribed.end(); )
+    {
+        if (_isDemanded && _streams.contains(*it_subscribed))
+        {
+            ++it_subscribed;
+
+            continue;
+        }
+
+        const auto it_pendingSubscribe = std::find(_pendingSubscribe.begin(), _pendingSubscribe.end(), *it_subscribed);
+        if (it_pendingSubscribe != _pendingSubscribe.end())
+        {
+            _pendingSubscribe.erase(it_pendingSubscribe);
+        }
+        else
+        {
+            _pendingUnsubscribe.push_back(*it_subscribed);
+        }
+
+        it_subscribed = _subscribed.erase(it_subscribed);
+    }
+
+    if (!_isDemanded)
+    {
+        if (!_pendingUnsubscribe.empty() && !_subscribeTimer->isActive())
+        {
+            _subscribeTimer->start(SUBSCRIBE_INTERVAL);
+        }
+
+        return;
+    }
+
+    qsizetype skipped = 0;
+    for (auto it_streams = _streams.constBegin(); it_streams != _streams.constEnd(); ++it_streams)
+    {
+        const auto& name = it_streams.key();
+        if (_subscribed.contains(name))
+        {
+            continue;
+        }
+
+        if (_subscribed.size() >= MAX_STREAMS)
+        {
+            ++skipped;
+
+            continue;
+        }
+
+        _subscribed.insert(name);
+        _pendingSubscribe.push_back(name);
+    }
+
+    if (skipped > 0 && skipped != _skipped)
+    {
+        emit sendLogMsg(_stockExchangeId, MSG_CODE::WARNING_CODE, QString("KLines stream: the limit of %1 streams per connection has been reached. %2 klines will be updated by REST only")
+                                                                     .arg(MAX_STREAMS)
+                                                                     .arg(skipped));
+    }
+    _skipped = skipped;
+
+    if ((!_pendingSubscribe.empty() || !_pendingUnsubscribe.empty()) && !_subscribeTimer->isActive())
+    {
+        _subscribeTimer->start(SUBSCRIBE_INTERVAL);
+    }
+}
+
+void KLinesStream::connected()
+{
+    _isConnected = true;
+
+    _streamProxyPool.reportSuccess(_proxyIndex, _stockExchangeId, QDateTime::currentMSecsSinceEpoch() - _openTime);
+
+    // после переподключения подписка восстанавливается полностью
+    _subscribed.clear();
+    _pendingSubscribe.clear();
+    _pendingUnsubscribe.clear();
+
+    updateSubscriptions();
+
+    emit sendLogMsg(_stockExchangeId, MSG_CODE::INFORMATION_CODE, QString("KLines stream: connected to %1. Subscribe to %2 of %3 streams")
+                                                                     .arg(_url.toString())
+                                                                     .arg(_subscribed.size())
+                                                                     .arg(_streams.size()));
+}
+
+void KLinesStream::disconnected()
+{
+    if (!_isStarted)
+    {
+        return;
+    }
+
+    // не удалось подключиться или соединение разорвано не биржей - прокси получает ошибку
+    if (!_isConnected || _webSocket->closeCode() != QWebSocketProtocol::CloseCodeNormal)
+    {
+        _streamProxyPool.reportError(_proxyIndex, _stockExchangeId);
+    }
+    _isConnected = false;
+
+    emit sendLogMsg(_stockExchangeId, MSG_CODE::WARNING_CODE, QString("KLines stream: disconnected from %1: %2. Reconnect after %3 s")
+                                                                 .arg(_url.toString())
+                                                                 .arg(_webSocket->errorString())
+                                                                 .arg(RECONNECT_INTERVAL / 1000));
+
+    _subscribeTimer->stop();
+    _subscribed.clear();
+    _pendingSubscribe.clear();
+    _pendingUnsubscribe.clear();
+
+    _reconnectTimer->start(RECONNECT_INTERVAL);
+}
+
+void KLinesStream::textMessageReceived(const QString &message)
+{
+    // QWebSocket передает текстовые сообщения только как QString. UTF-8 кодируется в буфер,
+    // который переиспользуется между сообщениями, чтобы не выделять память на каждое сообщение
+    QStringEncoder encoder(QStringEncoder::Utf8, QStringConverter::Flag::Stateless);
+    _messageBuffer.resize(encoder.requiredSpace(message.size()));
+    const auto end = encoder.appendToBuffer(_messageBuffer.data(), message);
+
+    parseMessage(QByteArrayView(_messageBuffer.constData(), end - _messageBuffer.constData()));
+}
+
+void KLinesStream::binaryMessageReceived(const QByteArray &message)
+{
+    parseMessage(message);
+}
+
+void KLinesStream::parseMessage(QByteArrayView message)
+{
+    // свечи - почти весь поток, остальные сообщения разбираются через QJsonDocument
+    if (parseKLineMessage(message))
+    {
+        return;
+    }
+
+    QJsonParseError error;
+    const auto json = QJsonDocument::fromJson(message.toByteArray(), &error);
+    if (error.error != QJsonParseError::NoError || !json.isObject())
+    {
+        emit sendLogMsg(_stockExchangeId, MSG_CODE::WARNING_CODE, QString("KLines stream: incorrect message: %1").arg(error.errorString()));
+
+        return;
+    }
+
+    auto messageJson = json.object();
+
+    // ответ на SUBSCRIBE
+    if (messageJson.contains("id"))
+    {
+        if (messageJson.contains("error"))
+        {
+            emit sendLogMsg(_stockExchangeId, MSG_CODE::WARNING_CODE, QString("KLines stream: subscribe error: %1")
+                                                                         .arg(QString(QJsonDocument(messageJson.value("error").toObject()).toJson(QJsonDocument::Compact))));
+        }
+
+        return;
+    }
+
+    // сообщение комбинированного потока: {"stream": ..., "data": {...}}
+    if (messageJson.contains("data"))
+    {
+        messageJson = messageJson.value("data").toObject();
+    }
+
+    if (messageJson.value("e").toString() != "kline")
+    {
+        return;
+    }
+
+    parseKLine(messageJson.value("k").toObject());
+}
+
+void KLinesStream::reconnectTimerTimeout()
+{
+    open();
+}
+
+void KLinesStream::subscribeTimerTimeout()
+{
+    // одно сообщение за интервал. Отписка освобождает места лимита подключения для новых подписок
+    if (!_pendingUnsubscribe.empty())
+    {
+        sendRequest("UNSUBSCRIBE", _pendingUnsubscribe);
+    }
+    else
+    {
+        sendRequest("SUBSCRIBE", _pendingSubscribe);
+    }
+
+    if (_pendingSubscribe.empty() && _pendingUnsubscribe.empty())
+    {
+        _subscribeTimer->stop();
+    }
+}
+
+void KLinesStream::flushTimerTimeout()
+{
+    if (_klines->empty())
+    {
+        return;
+    }
+
+    emit getKLines(_stockExchangeId, _klines);
+
+    _klines = std::make_shared<KLinesList>();
+}
+
+void KLinesStream::open()
+{
+    _proxyIndex = _streamProxyPool.choose(_stockExchangeId);
+    _webSocket->setProxy(_proxyIndex != StreamProxyPool::NO_PROXY ? _streamProxyPool.proxy(_proxyIndex) : QNetworkProxy(QNetworkProxy::DefaultProxy));
+
+    _openTime = QDateTime::currentMSecsSinceEpoch();
+
+    _webSocket->open(_url);
+}
+
+void KLinesStream::sendRequest(const QString &method, std::deque<QString> &streams)
+{
+    QJsonArray params;
+    while (!streams.empty() && params.size() < SUBSCRIBE_BATCH)
+    {
+        params.push_back(streams.front());
+        streams.pop_front();
+    }
+
+    if (params.isEmpty())
+    {
+        return;
+    }
+
+    QJsonObject request;
+    request.insert("method", method);
+    request.insert("params", params);
+    request.insert("id", static_cast<qint64>(++_requestId));
+
+    _webSocket->sendTextMessage(QJsonDocument(request).toJson(QJsonDocument::Compact));
+}
+
+void KLinesStream::parseKLine(const QJsonObject &klineJson)
+{
+    // передаются только закрытые свечи, незакрытые обновляются REST-опросом
+    if (!klineJson.value("x").toBool())
+    {
+        return;
+    }
+
+    const auto name = QString("%1@kline_%2").arg(klineJson.value("s").toString().toLower()).arg(klineJson.value("i").toString());
+    const auto it_streams = _streams.constFind(name);
+    if (it_streams == _streams.constEnd())
+    {
+        return;
+    }
+
+    auto kline = KLinesPool::make();
+    kline->id = it_streams.value();
+    kline->openTime = klineJson.value("t").toInteger();
+    kline->closeTime = klineJson.value("T").toInteger();
+    kline->open = klineJson.value("o").toString().toDouble();
+    kline->high = klineJson.value("h").toString().toDouble();
+    kline->low = klineJson.value("l").toString().toDouble();
+    kline->close = klineJson.value("c").toString().toDouble();
+    kline->volume = klineJson.value("v").toString().toDouble();
+    kline->quoteAssetVolume = klineJson.value("q").toString().toDouble();
+
+    appendKLine(std::move(kline));
+}
+
+bool KLinesStream::parseKLineMessage(QByteArrayView message)
+{
+    using Token = JsonTokenizer::Token;
+
+    JsonTokenizer tokenizer(message);
+    if (tokenizer.next() != Token::BEGIN_OBJECT)
+    {
+        return false;
+    }
+
+    bool isKLineEvent = false;
+    bool hasKLine = false;
+    bool isClosed = false;
+    QByteArrayView symbol;
+    QByteArrayView interval;
+    qint64 openTime = 0;
+    qint64 closeTime = 0;
+    double values[6] = {};   // o h l c v q
+
+    auto token = tokenizer.next();
+    for (; token == Token::KEY || token == Token::END_OBJECT; token = tokenizer.next())
+    {
+        if (token == Token::END_OBJECT)
+        {
+            continue;
+        }
+
+        const auto key = tokenizer.text();
+        if (key == "data")
+        {
+            // сообщение комбинированного потока: поля события читаются из вложенного объекта
+            if (tokenizer.next() != Token::BEGIN_OBJECT)
+            {
+                return false;
+            }
+        }
+        else if (key == "e")
+        {
+            if (tokenizer.next() != Token::STRING)
+            {
+                return false;
+            }
+            isKLineEvent = tokenizer.text() == "kline";
+        }
+        else if (key == "k")
+        {
+            if (tokenizer.next() != Token::BEGIN_OBJECT)
+            {
+                return false;
+            }
+
+            for (token = tokenizer.next(); token == Token::KEY; token = tokenizer.next())
+            {
+                const auto field = tokenizer.text();
+                const auto valueIndex = field.size() == 1 ? QByteArrayView("ohlcvq").indexOf(field.front()) : -1;
+
+                bool ok = true;
+                if (valueIndex >= 0)
+                {
+                    ok = tokenizer.next() == Token::STRING && tokenizer.toDouble(values[valueIndex]);
+                }
+                else if (field == "t" || field == "T")
+                {
+                    ok = tokenizer.next() == Token::NUMBER && tokenizer.toInt64(field == "t" ? openTime : closeTime);
+                }
+                else if (field == "s" || field == "i")
+                {
+                    ok = tokenizer.next() == Token::STRING && !tokenizer.isEscaped();
+                    (field == "s" ? symbol : interval) = tokenizer.text();
+                }
+                else if (field == "x")
+                {
+                    token = tokenizer.next();
+                    ok = token == Token::TRUE_VALUE || token == Token::FALSE_VALUE;
+                    isClosed = token == Token::TRUE_VALUE;
+                }
+                else
+                {
+                    ok = tokenizer.skipValue();
+                }
+
+                if (!ok)
+                {
+                    return false;
+                }
+            }
+
+            if (token != Token::END_OBJECT)
+            {
+                return false;
+            }
+
+            hasKLine = true;
+        }
+        else if (key == "id" || key == "error")
+        {
+            // ответ на SUBSCRIBE
+            return false;
+        }
+        else if (!tokenizer.skipValue())
+        {
+            return false;
+        }
+    }
+
+    if (token != Token::END || !isKLineEvent || !hasKLine)
+    {
+        return false;
+    }
+
+    // передаются только закрытые свечи, незакрытые обновляются REST-опросом
+    if (!isClosed)
+    {
+        return true;
+    }
+
+    const auto name = QString("%1@kline_%2").arg(QString::fromUtf8(symbol).toLower()).arg(QString::fromUtf8(interval));
+    const auto it_streams = _streams.constFind(name);
+    if (it_streams == _streams.constEnd())
+    {
+        return true;
+    }
+
+    auto kline = KLinesPool::make();
+    kline->id = it_streams.value();
+    kline->openTime = openTime;
+    kline->closeTime = closeTime;
+    kline->open = values[0];
+    kline->high = values[1];
+    kline->low = values[2];
+    kline->close = values[3];
+    kline->volume = values[4];
+    kline->quoteAssetVolume = values[5];
+
+    appendKLine(std::move(kline));
+
+    return true;
+}
+
+bool KLinesStream::isNewClosedKLine(const TradingCatCommon::KLine &kline)
+{
+    auto& openTimes = _closedOpenTimes[kline.id];
+    if (std::find(openTimes.begin(), openTimes.end(), kline.openTime) != openTimes.end())
+    {
+        return false;
+    }
+
+    openTimes.push_back(kline.openTime);
+    if (openTimes.size() > CLOSED_KLINES_HISTORY)
+    {
+        openTimes.pop_front();
+    }
+
+    return true;
+}
+
+void KLinesStream::appendKLine(TradingCatCommon::PKLine &&kline)
+{
+    // свеча уже получена REST-опросом
+    if (!isNewClosedKLine(*kline))
+    {
+        return;
+    }
+
+    _klines->push_back(std::move(kline));
+
+    if (!_flushTimer->isActive())
+    {
+        _flushTimer->start(FLUSH_INTERVAL);
+    }
+}
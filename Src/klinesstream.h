@@ -0,0 +1,157 @@
+#pragma once
+
+//STL
+#include <memory>
+#include <deque>
+#include <unordered_map>
+
+//Qt
+#include <QObject>
+#include <QUrl>
+#include <QHash>
+#include <QSet>
+#include <QTimer>
+#include <QJsonObject>
+#include <QByteArrayView>
+#include <QWebSocket>
+
+//My
+#include <Common/common.h>
+
+#include <TradingCatCommon/stockexchange.h>
+#include <TradingCatCommon/kline.h>
+
+#include "streamproxypool.h"
+
+///////////////////////////////////////////////////////////////////////////////
+///     The KLinesStream class - получение закрытых свечей по WebSocket-потоку биржи
+///         (протокол потоков kline Binance: SUBSCRIBE <symbol>@kline_<interval>).
+///         Объект живет в потоке биржи и дополняет ее REST-опрос: список KLineID
+///         берется из getKLinesID биржи, свечи REST-опроса проходят через addKLines.
+///         Закрытая свеча передается дальше один раз - из того источника, который
+///         получил ее первым. Интервалы, которых нет у потоков Binance, обновляются
+///         только REST-опросом. Пропуски после переподключения дозагружаются через REST
+///         по сигналу KLinesGapDetector. Адрес потока задается в конфигурации, что
+///         позволяет работать с локальным тестовым сервером. Без спроса (setDemanded)
+///         подписки снимаются и свечи обновляются только REST-опросом
+///
+class KLinesStream final
+    : public QObject
+{
+    Q_OBJECT
+
+public:
+    /*!
+        Конструктор
+        @param stockExchangeId - биржа
+        @param url - адрес WebSocket-потока
+        @param streamProxyPool - пул прокси. Прокси выбирается при каждом подключении
+    */
+    KLinesStream(const TradingCatCommon::StockExchangeID& stockExchangeId, const QUrl& url, StreamProxyPool& streamProxyPool, QObject* parent = nullptr);
+    ~KLinesStream() override;
+
+    /*!
+        Имя потока свечи. Например, btcusdt@kline_1m
+        @return пустая строка - у Binance нет потока с интервалом свечи
+    */
+    static QString streamName(const TradingCatCommon::KLineID& klineId);
+
+public slots:
+    void start();
+    void stop();
+
+    /*!
+        Переподключение при перезапуске коннектора биржи: подписки строятся заново по списку
+            свечей нового коннектора. Уже переданные закрытые свечи по-прежнему отбрасываются
+    */
+    void reset();
+
+    /*!
+        Список свечей биржи. Подписка на свечи из списка, на которые еще нет подписки, и
+            отписка от свечей, которых в списке больше нет
+    */
+    void addKLinesID(const TradingCatCommon::StockExchangeID& stockExchangeId, const TradingCatCommon::PKLinesIDList& klinesIdList);
+
+    /*!
+        Свечи REST-опроса биржи. Закрытые свечи, уже переданные потоком, отбрасываются
+    */
+    void addKLines(const TradingCatCommon::StockExchangeID& stockExchangeId, const TradingCatCommon::PKLinesList& klines);
+
+    /*!
+        Есть ли сессии, фильтры которых могут сработать (DemandTracker). Без спроса все
+            подписки снимаются, при появлении спроса восстанавливаются. Может вызываться до start()
+    */
+    void setDemanded(bool isDemanded);
+
+signals:
+    void getKLines(const TradingCatCommon::StockExchangeID& stockExchangeId, const TradingCatCommon::PKLinesList& klines);
+    void sendLogMsg(const TradingCatCommon::StockExchangeID& stockExchangeId, Common::MSG_CODE category, const QString& msg);
+
+private slots:
+    void connected();
+    void disconnected();
+    void textMessageReceived(const QString& message);
+    void binaryMessageReceived(const QByteArray& message);
+
+    void reconnectTimerTimeout();
+    void subscribeTimerTimeout();
+    void flushTimerTimeout();
+
+private:
+    KLinesStream() = delete;
+    Q_DISABLE_COPY_MOVE(KLinesStream);
+
+    void open();
+
+    /*!
+        Ставит в очередь UNSUBSCRIBE потоки, которых нет в списке свечей или на которые нет
+            спроса, и SUBSCRIBE потоки, на которые еще нет подписки
+    */
+    void updateSubscriptions();
+    void sendRequest(const QString& method, std::deque<QString>& streams);
+    void parseMessage(QByteArrayView message);
+    void parseKLine(const QJsonObject& klineJson);
+
+    /*!
+        Разбор сообщения со свечой без построения QJsonDocument
+        @return false - сообщение не является свечой или не может быть разобрано быстро и
+            должно быть разобрано через QJsonDocument
+    */
+    bool parseKLineMessage(QByteArrayView message);
+
+    /*!
+        Запоминает закрытую свечу
+        @return false - свеча уже была передана
+    */
+    bool isNewClosedKLine(const TradingCatCommon::KLine& kline);
+    void appendKLine(TradingCatCommon::PKLine&& kline);
+
+private:
+    const TradingCatCommon::StockExchangeID _stockExchangeId;
+    const QUrl _url;
+    StreamProxyPool& _streamProxyPool;
+
+    QWebSocket* _webSocket = nullptr;
+    QTimer* _reconnectTimer = nullptr;
+    QTimer* _subscribeTimer = nullptr;
+    QTimer* _flushTimer = nullptr;
+
+    qsizetype _proxyIndex = StreamProxyPool::NO_PROXY;    ///< прокси текущего подключения
+    qint64 _openTime = 0;                                 ///< время начала подключения
+    bool _isConnected = false;
+
+    QHash<QString, TradingCatCommon::KLineID> _streams;   ///< все свечи биржи по имени потока
+    QSet<QString> _subscribed;                            ///< потоки с подпиской в текущем подключении
+    std::deque<QString> _pendingSubscribe;                ///< потоки, ожидающие отправки SUBSCRIBE
+    std::deque<QString> _pendingUnsubscribe;              ///< потоки, ожидающие отправки UNSUBSCRIBE. Отправляются раньше SUBSCRIBE
+    bool _isDemanded = true;                              ///< есть сессии, фильтры которых могут сработать
+    qsizetype _skipped = 0;                               ///< потоков сверх лимита подключения
+    qsizetype _restOnly = 0;                              ///< свечей с интервалом, для которого нет потока
+    quint64 _requestId = 0;
+    QByteArray _messageBuffer;                            ///< сообщение в UTF-8 для разбора
+
+    TradingCatCommon::PKLinesList _klines;                ///< закрытые свечи до отправки по таймеру
+    std::unordered_map<TradingCatCommon::KLineID, std::deque<qint64>> _closedOpenTimes; ///< время открытия последних переданных закрытых свечей
+
+    bool _isStarted = false;
+};
@@ -0,0 +1,247 @@
+//STL
+#include <algorithm>
+#include <cmath>
+
+//Qt
+#include <QMutexLocker>
+#include <QDateTime>
+
+#include "idinterner.h"
+#include "latencytracer.h"
+
+using namespace TradingCatCommon;
+
+qint64 LatencyTracer::Histogram::percentile(double percentile) const noexcept
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    const auto rank = static_cast<quint64>(std::max(1.0, std::ceil(percentile * static_cast<double>(count))));
+
+    quint64 total = 0;
+    for (qsizetype bucket = 0; bucket < BUCKETS_COUNT - 1; ++bucket)
+    {
+        total += counts[bucket];
+        if (total >= rank)
+        {
+            return std::min(BUCKETS[bucket], max);
+        }
+    }
+
+    return max;
+}
+
+qint64 LatencyTracer::Histogram::average() const noexcept
+{
+    return count > 0 ? sum / static_cast<qint64>(count) : 0;
+}
+
+void LatencyTracer::Histogram::add(qint64 latency) noexcept
+{
+    const auto bucket = static_cast<qsizetype>(std::distance(BUCKETS.begin(), std::lower_bound(BUCKETS.begin(), BUCKETS.end(), latency)));
+
+    ++counts[bucket];
+    ++count;
+    sum += latency;
+    max = std::max(max, latency);
+}
+
+LatencyTracer::LatencyTracer(const TradingCatCommon::StockExchangesIDList& stockExchangesIdList, QObject* parent /* = nullptr */)
+    : QObject{parent}
+{
+    qRegisterMetaType<TradingCatCommon::StockExchangeID>("TradingCatCommon::StockExchangeID");
+    qRegisterMetaType<TradingCatCommon::PKLinesList>("TradingCatCommon::PKLinesList");
+
+    for (const auto& stockExchangeId: stockExchangesIdList)
+    {
+        const auto index = IDInterner::stockExchange(stockExchangeId);
+        if (index >= _stockExchanges.size())
+        {
+            _stockExchanges.resize(index + 1);
+        }
+
+        _stockExchanges[index] = std::make_unique<StockExchangeTrace>();
+        _stockExchanges[index]->stockExchangeIndex = index;
+    }
+}
+
+QString LatencyTracer::hopName(Hop hop)
+{
+    switch (hop)
+    {
+    case Hop::RECEIVE: return "Receive";
+    case Hop::TRADING_DATA: return "TradingData";
+    case Hop::DETECTOR: return "Detector";
+    case Hop::DETECT: return "Detect";
+    case Hop::DELIVERY: return "Delivery";
+    }
+
+    return QString();
+}
+
+void LatencyTracer::addKLines(Hop hop, const TradingCatCommon::StockExchangeID &stockExchangeId, const TradingCatCommon::KLinesList &klines)
+{
+    auto stockExchangeTrace = this->stockExchangeTrace(stockExchangeId);
+    if (!stockExchangeTrace)
+    {
+        return;
+    }
+
+    // время, номер пакета и этап определяются один раз на пакет
+    const auto currentTime = QDateTime::currentMSecsSinceEpoch();
+    const auto stockExchangeIndex = stockExchangeTrace->stockExchangeIndex;
+    auto& hopTrace = stockExchangeTrace->hops[static_cast<qsizetype>(hop)];
+
+    QMutexLocker<QMutex> locker(&hopTrace.mutex);
+
+    const auto batch = ++hopTrace.batch;
+
+    for (const auto& kline: klines)
+    {
+        // незакрытая свеча нужна только для времени получения
+        const auto isClosed = kline->closeTime <= currentTime;
+        if (!isClosed && hop != Hop::RECEIVE)
+        {
+            continue;
+        }
+
+        const auto klineIndex = IDInterner::kline(stockExchangeIndex, kline->id);
+        if (klineIndex >= hopTrace.klines.size())
+        {
+            hopTrace.klines.resize(klineIndex + 1);
+        }
+
+        auto& klineTrace = hopTrace.klines[klineIndex];
+        if (hop == Hop::RECEIVE)
+        {
+            klineTrace.receivedTime = currentTime;
+        }
+
+        if (!isClosed)
+        {
+            continue;
+        }
+
+        // первый пакет по свече - история, от нее отсчитываются следующие свечи
+        if (klineTrace.firstBatch == 0 || klineTrace.firstBatch == batch)
+        {
+            klineTrace.firstBatch = batch;
+            klineTrace.lastOpenTime = std::max(klineTrace.lastOpenTime, kline->openTime);
+
+            continue;
+        }
+
+        // повторное получение или дозагрузка пропуска
+        if (kline->openTime <= klineTrace.lastOpenTime)
+        {
+            continue;
+        }
+
+        klineTrace.lastOpenTime = kline->openTime;
+        hopTrace.histogram.add(currentTime - kline->closeTime);
+    }
+}
+
+void LatencyTracer::addDetect(Hop hop, const TradingCatCommon::Detector::KLineDetectData &detectData)
+{
+    Q_CHECK_PTR(detectData.history);
+
+    if (detectData.history->empty())
+    {
+        return;
+    }
+
+    auto stockExchangeTrace = this->stockExchangeTrace(detectData.stockExchangeId);
+    if (!stockExchangeTrace)
+    {
+        return;
+    }
+
+    const auto currentTime = QDateTime::currentMSecsSinceEpoch();
+    const auto& kline = *detectData.history->back();
+
+    auto startTime = kline.closeTime;
+    if (startTime > currentTime)
+    {
+        const auto klineIndex = IDInterner::findKLine(stockExchangeTrace->stockExchangeIndex, kline.id);
+
+        const auto& receiveTrace = stockExchangeTrace->hops[static_cast<qsizetype>(Hop::RECEIVE)];
+
+        QMutexLocker<QMutex> locker(&receiveTrace.mutex);
+
+        if (klineIndex >= receiveTrace.klines.size() || receiveTrace.klines[klineIndex].receivedTime == 0)
+        {
+            return;
+        }
+
+        startTime = receiveTrace.klines[klineIndex].receivedTime;
+    }
+
+    auto& hopTrace = stockExchangeTrace->hops[static_cast<qsizetype>(hop)];
+
+    QMutexLocker<QMutex> locker(&hopTrace.mutex);
+
+    hopTrace.histogram.add(currentTime - startTime);
+}
+
+LatencyTracer::StatisticList LatencyTracer::statistic() const
+{
+    StatisticList result;
+
+    for (const auto& stockExchangeTrace: _stockExchanges)
+    {
+        if (!stockExchangeTrace)
+        {
+            continue;
+        }
+
+        std::array<Histogram, HOPS_COUNT> hops;
+        for (qsizetype hop = 0; hop < HOPS_COUNT; ++hop)
+        {
+            const auto& hopTrace = stockExchangeTrace->hops[hop];
+
+            QMutexLocker<QMutex> locker(&hopTrace.mutex);
+
+            hops[hop] = hopTrace.histogram;
+        }
+
+        if (std::all_of(hops.begin(), hops.end(), [](const Histogram& histogram) { return histogram.count == 0; }))
+        {
+            continue;
+        }
+
+        result.push_back({IDInterner::stockExchangeId(stockExchangeTrace->stockExchangeIndex), hops});
+    }
+
+    return result;
+}
+
+void LatencyTracer::receivedKLines(const TradingCatCommon::StockExchangeID &stockExchangeId, const TradingCatCommon::PKLinesList &klines)
+{
+    Q_CHECK_PTR(klines);
+
+    addKLines(Hop::RECEIVE, stockExchangeId, *klines);
+}
+
+void LatencyTracer::tradingDataKLines(const TradingCatCommon::StockExchangeID &stockExchangeId, const TradingCatCommon::PKLinesList &klines)
+{
+    Q_CHECK_PTR(klines);
+
+    addKLines(Hop::TRADING_DATA, stockExchangeId, *klines);
+}
+
+void LatencyTracer::detectorKLines(const TradingCatCommon::StockExchangeID &stockExchangeId, const TradingCatCommon::PKLinesList &klines)
+{
+    Q_CHECK_PTR(klines);
+
+    addKLines(Hop::DETECTOR, stockExchangeId, *klines);
+}
+
+LatencyTracer::StockExchangeTrace* LatencyTracer::stockExchangeTrace(const TradingCatCommon::StockExchangeID &stockExchangeId) const
+{
+    const auto index = IDInterner::findStockExchange(stockExchangeId);
+
+    return index < _stockExchanges.size() ? _stockExchanges[index].get() : nullptr;
+}
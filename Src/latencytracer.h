@@ -0,0 +1,132 @@
+#pragma once
+
+//STL
+#include <array>
+#include <vector>
+#include <memory>
+
+//Qt
+#include <QObject>
+#include <QMutex>
+
+//My
+#include <TradingCatCommon/stockexchange.h>
+#include <TradingCatCommon/kline.h>
+#include <TradingCatCommon/detector.h>
+
+///////////////////////////////////////////////////////////////////////////////
+///     The LatencyTracer class - гистограммы задержки от закрытия свечи до каждого
+///         этапа обработки по каждой бирже. На каждом этапе закрытая свеча учитывается
+///         один раз - при первом появлении (KLineID, openTime). Первый пакет по свече
+///         (история при запуске) и дозагрузка свечей старше уже учтенных в гистограммы
+///         не попадают. Событие детектора по незакрытой свече отсчитывается от
+///         получения этой свечи от биржи. Разница между этапами показывает, где
+///         теряется время: опрос биржи, очереди TradingData/Detector или интервал
+///         опроса клиента. Биржи задаются при создании. Каждый этап биржи хранит свои
+///         гистограмму и трассы свечей под своей блокировкой: этап пишет один поток,
+///         поэтому биржи и этапы не ждут друг друга. Потокобезопасен
+///
+class LatencyTracer final
+    : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class Hop: quint8
+    {
+        RECEIVE = 0,       ///< пакет получен от биржи
+        TRADING_DATA = 1,  ///< пакет передан в TradingData::addKLines
+        DETECTOR = 2,      ///< пакет передан в Detector::addKLines
+        DETECT = 3,        ///< событие детектора получено UsersCore::klineDetect
+        DELIVERY = 4       ///< событие отдано клиенту в ответе UsersCore::detect
+    };
+
+    static constexpr qsizetype HOPS_COUNT = 5;
+    static constexpr qsizetype BUCKETS_COUNT = 12;
+
+    /*!
+        Верхние границы интервалов гистограммы, мс. Последний интервал не ограничен
+    */
+    static constexpr std::array<qint64, BUCKETS_COUNT - 1> BUCKETS = {100, 250, 500, 1000, 2500, 5000, 10000, 30000, 60000, 120000, 300000};
+
+    struct Histogram
+    {
+        std::array<quint64, BUCKETS_COUNT> counts = {};
+        quint64 count = 0;
+        qint64 sum = 0;   ///< мс
+        qint64 max = 0;   ///< мс
+
+        /*!
+            Оценка перцентиля по верхней границе интервала
+            @param percentile - (0, 1]
+            @return мс. 0 - нет данных
+        */
+        qint64 percentile(double percentile) const noexcept;
+        qint64 average() const noexcept;
+
+        void add(qint64 latency) noexcept;
+    };
+
+    struct StockExchangeStatistic
+    {
+        TradingCatCommon::StockExchangeID stockExchangeId;
+        std::array<Histogram, HOPS_COUNT> hops;
+    };
+    using StatisticList = std::vector<StockExchangeStatistic>;
+
+public:
+    /*!
+        Конструктор
+        @param stockExchangesIdList - биржи, задержку которых нужно учитывать. Пакеты остальных бирж пропускаются
+    */
+    explicit LatencyTracer(const TradingCatCommon::StockExchangesIDList& stockExchangesIdList, QObject* parent = nullptr);
+    ~LatencyTracer() override = default;
+
+    static QString hopName(Hop hop);
+
+    void addKLines(Hop hop, const TradingCatCommon::StockExchangeID& stockExchangeId, const TradingCatCommon::KLinesList& klines);
+    void addDetect(Hop hop, const TradingCatCommon::Detector::KLineDetectData& detectData);
+
+    /*!
+        Гистограммы с момента запуска по всем биржам, от которых были данные
+    */
+    StatisticList statistic() const;
+
+public slots:
+    /*!
+        Точки трассировки пакетов свечей. Подключаются через Qt::DirectConnection и
+            выполняются в потоке отправителя
+    */
+    void receivedKLines(const TradingCatCommon::StockExchangeID& stockExchangeId, const TradingCatCommon::PKLinesList& klines);
+    void tradingDataKLines(const TradingCatCommon::StockExchangeID& stockExchangeId, const TradingCatCommon::PKLinesList& klines);
+    void detectorKLines(const TradingCatCommon::StockExchangeID& stockExchangeId, const TradingCatCommon::PKLinesList& klines);
+
+private:
+    Q_DISABLE_COPY_MOVE(LatencyTracer);
+
+    struct KLineTrace
+    {
+        qint64 lastOpenTime = 0;  ///< время открытия последней учтенной закрытой свечи
+        quint64 firstBatch = 0;   ///< номер пакета, в котором свеча появилась на этапе впервые
+        qint64 receivedTime = 0;  ///< время получения последнего пакета со свечой от биржи. Только для Hop::RECEIVE
+    };
+
+    struct HopTrace
+    {
+        mutable QMutex mutex;
+        Histogram histogram;
+        std::vector<KLineTrace> klines;  ///< по индексу свечи в IDInterner
+        quint64 batch = 0;               ///< номер последнего пакета свечей этапа
+    };
+
+    struct StockExchangeTrace
+    {
+        quint32 stockExchangeIndex = 0;
+        std::array<HopTrace, HOPS_COUNT> hops;
+    };
+
+    StockExchangeTrace* stockExchangeTrace(const TradingCatCommon::StockExchangeID& stockExchangeId) const;
+
+private:
+    std::vector<std::unique_ptr<StockExchangeTrace>> _stockExchanges;   ///< по индексу биржи в IDInterner. Не изменяется после создания
+};
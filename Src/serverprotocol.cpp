@@ -0,0 +1,562 @@
+//Qt
+#include <QJsonDocument>
+#include <QDateTime>
+
+#include "serverprotocol.h"
+
+using namespace TradingCatCommon;
+
+Q_GLOBAL_STATIC_WITH_ARGS(const QString, DETECT_HISTORY_PATH, ("/data/history"));
+Q_GLOBAL_STATIC_WITH_ARGS(const QString, KLINES_RANGE_PATH, ("/data/klines"));
+Q_GLOBAL_STATIC_WITH_ARGS(const QString, USERS_ONLINE_PATH, ("/admin/users"));
+Q_GLOBAL_STATIC_WITH_ARGS(const QString, LATENCY_PATH, ("/admin/latency"));
+Q_GLOBAL_STATIC_WITH_ARGS(const QString, MONITOR_PATH, ("/admin/monitor"));
+
+template <typename TKLine>
+static QJsonObject klineFieldsToJson(const TKLine& kline)
+{
+    QJsonObject result;
+    result.insert("OpenTime", kline.openTime);
+    result.insert("Open", kline.open);
+    result.insert("High", kline.high);
+    result.insert("Low", kline.low);
+    result.insert("Close", kline.close);
+    result.insert("Volume", kline.volume);
+    result.insert("QuoteAssetVolume", kline.quoteAssetVolume);
+    result.insert("CloseTime", kline.closeTime);
+
+    return result;
+}
+
+QJsonObject klineToJson(const TradingCatCommon::KLine& kline)
+{
+    return klineFieldsToJson(kline);
+}
+
+QJsonObject klineToJson(const KLinesRingBuffer::KLineView& kline)
+{
+    return klineFieldsToJson(kline);
+}
+
+QJsonArray klinesToJson(const TradingCatCommon::KLinesList& klines)
+{
+    QJsonArray result;
+    for (const auto& kline: klines)
+    {
+        result.push_back(klineToJson(*kline));
+    }
+
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///     The IServerQuery class - базовый класс запросов сервера
+///
+IServerQuery::IServerQuery(const QUrlQuery& query, bool isSessionRequired /* = true */)
+{
+    if (!isSessionRequired)
+    {
+        return;
+    }
+
+    bool ok = false;
+    _sessionId = query.queryItemValue("sessionId").toLongLong(&ok);
+    if (!ok || _sessionId == 0)
+    {
+        _errorString = "Value sessionId is empty or is not number";
+    }
+}
+
+qint64 IServerQuery::sessionId() const noexcept
+{
+    return _sessionId;
+}
+
+bool IServerQuery::isError() const noexcept
+{
+    return !_errorString.isEmpty();
+}
+
+const QString& IServerQuery::errorString() const noexcept
+{
+    return _errorString;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///     The DetectHistoryQuery class - запрос истории события по его идентификатору
+///
+const QString& DetectHistoryQuery::path()
+{
+    return *DETECT_HISTORY_PATH;
+}
+
+DetectHistoryQuery::DetectHistoryQuery(const QUrlQuery& query)
+    : IServerQuery(query)
+{
+    if (isError())
+    {
+        return;
+    }
+
+    bool ok = false;
+    _handle = query.queryItemValue("handle").toULongLong(&ok);
+    if (!ok || _handle == 0)
+    {
+        _errorString = "Value handle is empty or is not number";
+    }
+}
+
+quint64 DetectHistoryQuery::handle() const noexcept
+{
+    return _handle;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///     The KLinesRangeQuery class - запрос свечей за интервал времени
+///
+const QString& KLinesRangeQuery::path()
+{
+    return *KLINES_RANGE_PATH;
+}
+
+KLinesRangeQuery::KLinesRangeQuery(const QUrlQuery& query)
+    : IServerQuery(query)
+{
+    if (isError())
+    {
+        return;
+    }
+
+    _stockExchange = query.queryItemValue("stockExchange");
+    if (_stockExchange.isEmpty())
+    {
+        _errorString = "Value stockExchange cannot be empty";
+
+        return;
+    }
+
+    const auto symbol = query.queryItemValue("id");
+    if (symbol.isEmpty())
+    {
+        _errorString = "Value id cannot be empty";
+
+        return;
+    }
+
+    const auto type_str = query.hasQueryItem("type") ? query.queryItemValue("type") : QString("1m");
+    const auto types = stringToKLineTypes(type_str);
+    if (types.size() != 1)
+    {
+        _errorString = QString("Value type must be one kline interval. Value: %1").arg(type_str);
+
+        return;
+    }
+    _klineId = KLineID(symbol, *types.begin());
+
+    bool ok = true;
+    _from = query.hasQueryItem("from") ? query.queryItemValue("from").toLongLong(&ok) : 0;
+    if (!ok || _from < 0)
+    {
+        _errorString = "Value from must be non-negative number";
+
+        return;
+    }
+
+    _to = query.hasQueryItem("to") ? query.queryItemValue("to").toLongLong(&ok) : QDateTime::currentMSecsSinceEpoch();
+    if (!ok || _to < _from)
+    {
+        _errorString = "Value to must be number not less than from";
+
+        return;
+    }
+
+    _limit = query.hasQueryItem("limit") ? query.queryItemValue("limit").toLongLong(&ok) : MAX_LIMIT;
+    if (!ok || _limit <= 0 || _limit > MAX_LIMIT)
+    {
+        _errorString = QString("Value limit must be number from 1 to %1").arg(MAX_LIMIT);
+
+        return;
+    }
+}
+
+const QString& KLinesRangeQuery::stockExchange() const noexcept
+{
+    return _stockExchange;
+}
+
+const TradingCatCommon::KLineID& KLinesRangeQuery::klineId() const noexcept
+{
+    return _klineId;
+}
+
+qint64 KLinesRangeQuery::from() const noexcept
+{
+    return _from;
+}
+
+qint64 KLinesRangeQuery::to() const noexcept
+{
+    return _to;
+}
+
+qsizetype KLinesRangeQuery::limit() const noexcept
+{
+    return _limit;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///     The KLinesRangeAnswer class - свечи за интервал времени
+///
+KLinesRangeAnswer::KLinesRangeAnswer(const TradingCatCommon::StockExchangeID& stockExchangeId, const KLinesRangeQuery& query, const KLineViewsList& klines)
+{
+    QJsonArray klinesJson;
+    for (const auto& kline: klines)
+    {
+        klinesJson.push_back(klineToJson(kline));
+    }
+
+    _data.insert("StockExchange", stockExchangeId.toString());
+    _data.insert("KLineID", query.klineId().toString());
+    _data.insert("From", query.from());
+    _data.insert("To", query.to());
+    _data.insert("KLines", klinesJson);
+
+    if (static_cast<qsizetype>(klines.size()) >= query.limit() && klines.back().openTime < query.to())
+    {
+        _data.insert("Next", klines.back().openTime + 1);
+    }
+}
+
+QJsonObject KLinesRangeAnswer::toJson() const
+{
+    return _data;
+}
+
+TradingCatCommon::PackageType KLinesRangeAnswer::type() const
+{
+    return PackageType::UNDEFINED;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///     The UsersOnlineQuery class - служебный запрос списка пользователей онлайн
+///
+const QString& UsersOnlineQuery::path()
+{
+    return *USERS_ONLINE_PATH;
+}
+
+UsersOnlineQuery::UsersOnlineQuery(const QUrlQuery& query)
+    : IServerQuery(query, false)
+{
+    _token = query.queryItemValue("token");
+    if (_token.isEmpty())
+    {
+        _errorString = "Value token cannot be empty";
+
+        return;
+    }
+
+    bool ok = true;
+    _offset = query.hasQueryItem("offset") ? query.queryItemValue("offset").toLongLong(&ok) : 0;
+    if (!ok || _offset < 0)
+    {
+        _errorString = "Value offset must be non-negative number";
+
+        return;
+    }
+
+    _limit = query.hasQueryItem("limit") ? query.queryItemValue("limit").toLongLong(&ok) : MAX_LIMIT;
+    if (!ok || _limit <= 0 || _limit > MAX_LIMIT)
+    {
+        _errorString = QString("Value limit must be number from 1 to %1").arg(MAX_LIMIT);
+
+        return;
+    }
+}
+
+const QString& UsersOnlineQuery::token() const noexcept
+{
+    return _token;
+}
+
+qsizetype UsersOnlineQuery::offset() const noexcept
+{
+    return _offset;
+}
+
+qsizetype UsersOnlineQuery::limit() const noexcept
+{
+    return _limit;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///     The UsersOnlineAnswer class - страница списка пользователей онлайн
+///
+UsersOnlineAnswer::UsersOnlineAnswer(const QStringList& users, qsizetype offset, qsizetype total)
+{
+    _data.insert("Total", total);
+    _data.insert("Offset", offset);
+    _data.insert("Users", QJsonArray::fromStringList(users));
+}
+
+QJsonObject UsersOnlineAnswer::toJson() const
+{
+    return _data;
+}
+
+TradingCatCommon::PackageType UsersOnlineAnswer::type() const
+{
+    return PackageType::UNDEFINED;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///     The LatencyQuery class - служебный запрос гистограмм задержки
+///
+const QString& LatencyQuery::path()
+{
+    return *LATENCY_PATH;
+}
+
+LatencyQuery::LatencyQuery(const QUrlQuery& query)
+    : IServerQuery(query, false)
+{
+    _token = query.queryItemValue("token");
+    if (_token.isEmpty())
+    {
+        _errorString = "Value token cannot be empty";
+
+        return;
+    }
+}
+
+const QString& LatencyQuery::token() const noexcept
+{
+    return _token;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///     The LatencyAnswer class - гистограммы задержки
+///
+LatencyAnswer::LatencyAnswer(const LatencyTracer::StatisticList& statistic)
+{
+    QJsonArray buckets;
+    for (const auto bucket: LatencyTracer::BUCKETS)
+    {
+        buckets.push_back(bucket);
+    }
+
+    QJsonArray stockExchanges;
+    for (const auto& stockExchangeStatistic: statistic)
+    {
+        QJsonObject hops;
+        for (qsizetype hop = 0; hop < LatencyTracer::HOPS_COUNT; ++hop)
+        {
+            const auto& histogram = stockExchangeStatistic.hops[hop];
+
+            QJsonArray counts;
+            for (const auto count: histogram.counts)
+            {
+                counts.push_back(static_cast<qint64>(count));
+            }
+
+            QJsonObject hopJson;
+            hopJson.insert("Count", static_cast<qint64>(histogram.count));
+            hopJson.insert("Average", histogram.average());
+            hopJson.insert("P50", histogram.percentile(0.5));
+            hopJson.insert("P90", histogram.percentile(0.9));
+            hopJson.insert("P99", histogram.percentile(0.99));
+            hopJson.insert("Max", histogram.max);
+            hopJson.insert("Counts", counts);
+
+            hops.insert(LatencyTracer::hopName(static_cast<LatencyTracer::Hop>(hop)), hopJson);
+        }
+
+        QJsonObject stockExchangeJson;
+        stockExchangeJson.insert("StockExchange", stockExchangeStatistic.stockExchangeId.toString());
+        stockExchangeJson.insert("Hops", hops);
+
+        stockExchanges.push_back(stockExchangeJson);
+    }
+
+    _data.insert("Buckets", buckets);
+    _data.insert("StockExchanges", stockExchanges);
+}
+
+QJsonObject LatencyAnswer::toJson() const
+{
+    return _data;
+}
+
+TradingCatCommon::PackageType LatencyAnswer::type() const
+{
+    return PackageType::UNDEFINED;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///     The MonitorQuery class - служебный запрос счетчиков бирж
+///
+const QString& MonitorQuery::path()
+{
+    return *MONITOR_PATH;
+}
+
+MonitorQuery::MonitorQuery(const QUrlQuery& query)
+    : IServerQuery(query, false)
+{
+    _token = query.queryItemValue("token");
+    if (_token.isEmpty())
+    {
+        _errorString = "Value token cannot be empty";
+
+        return;
+    }
+}
+
+const QString& MonitorQuery::token() const noexcept
+{
+    return _token;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///     The MonitorAnswer class - счетчики бирж
+///
+MonitorAnswer::MonitorAnswer(const StockExchangeMonitor::CountersList& countersList)
+{
+    const auto currentTime = QDateTime::currentMSecsSinceEpoch();
+
+    QJsonArray stockExchanges;
+    for (const auto& counters: countersList)
+    {
+        QJsonObject countersJson;
+        countersJson.insert("StockExchange", counters.stockExchangeId.toString());
+        countersJson.insert("Running", counters.isRunning);
+        countersJson.insert("Batches", static_cast<qint64>(counters.batches));
+        countersJson.insert("KLines", static_cast<qint64>(counters.klines));
+        countersJson.insert("KLinesIDUpdates", static_cast<qint64>(counters.klinesIdUpdates));
+        countersJson.insert("KLinesIDCount", counters.klinesIdCount);
+        countersJson.insert("Warnings", static_cast<qint64>(counters.warnings));
+        countersJson.insert("Errors", static_cast<qint64>(counters.errors));
+        countersJson.insert("Restarts", static_cast<qint64>(counters.restarts));
+        countersJson.insert("LastDataTime", counters.lastDataTime);
+        countersJson.insert("LastKLineTime", counters.lastKLineTime);
+        countersJson.insert("Lag", counters.lag(currentTime));
+        countersJson.insert("LastErrorTime", counters.lastErrorTime);
+        countersJson.insert("LastError", counters.lastError);
+
+        stockExchanges.push_back(countersJson);
+    }
+
+    _data.insert("StockExchanges", stockExchanges);
+}
+
+QJsonObject MonitorAnswer::toJson() const
+{
+    return _data;
+}
+
+TradingCatCommon::PackageType MonitorAnswer::type() const
+{
+    return PackageType::UNDEFINED;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///     The ReadinessStatusAnswer class - ответ /status с состоянием готовности бирж
+///
+ReadinessStatusAnswer::ReadinessStatusAnswer(const TradingCatCommon::ServerStatusAnswer& status, qsizetype usersOnlineCount, const TradingCatCommon::StockExchangesIDList& stockExchangesIdList,
+                                             const TradingCatCommon::StockExchangesIDList& readyStockExchangesIdList)
+    : _data(status.toJson())
+    , _type(status.type())
+{
+    _data.insert("UsersOnlineCount", static_cast<qint64>(usersOnlineCount));
+
+    bool isReady = true;
+    QJsonObject stockExchanges;
+    for (const auto& stockExchangeId: stockExchangesIdList)
+    {
+        const auto isStockExchangeReady = readyStockExchangesIdList.contains(stockExchangeId);
+        stockExchanges.insert(stockExchangeId.toString(), isStockExchangeReady);
+        isReady &= isStockExchangeReady;
+    }
+
+    QJsonObject readiness;
+    readiness.insert("Ready", isReady);
+    readiness.insert("StockExchanges", stockExchanges);
+
+    _data.insert("Readiness", readiness);
+}
+
+QJsonObject ReadinessStatusAnswer::toJson() const
+{
+    return _data;
+}
+
+TradingCatCommon::PackageType ReadinessStatusAnswer::type() const
+{
+    return _type;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///     The DetectHeadersAnswer class - события детектора без истории свечей
+///
+DetectHeadersAnswer::DetectHeadersAnswer(const TradingCatCommon::Detector::KLinesDetectedList& klinesDetectedList, const HandleList& handles, const QString& message)
+{
+    Q_ASSERT(klinesDetectedList.detected.size() == handles.size());
+
+    QJsonArray detected;
+    auto it_handle = handles.begin();
+    for (const auto& detectData: klinesDetectedList.detected)
+    {
+        Q_CHECK_PTR(detectData->history);
+        Q_ASSERT(!detectData->history->empty());
+
+        const auto& lastKLine = *detectData->history->back();
+
+        QJsonObject header;
+        header.insert("Handle", QString::number(*it_handle++));
+        header.insert("StockExchange", detectData->stockExchangeId.toString());
+        header.insert("KLineID", lastKLine.id.toString());
+        header.insert("FilterActivate", static_cast<qint64>(detectData->filterActivate));
+        header.insert("KLine", klineToJson(lastKLine));
+
+        detected.push_back(header);
+    }
+
+    _data.insert("Message", message);
+    _data.insert("IsFull", klinesDetectedList.isFull);
+    _data.insert("Detected", detected);
+}
+
+QJsonObject DetectHeadersAnswer::toJson() const
+{
+    return _data;
+}
+
+TradingCatCommon::PackageType DetectHeadersAnswer::type() const
+{
+    return PackageType::UNDEFINED;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///     The DetectHistoryAnswer class - история свечей события детектора
+///
+DetectHistoryAnswer::DetectHistoryAnswer(quint64 handle, const TradingCatCommon::Detector::KLineDetectData& detectData, const QString& message)
+{
+    Q_CHECK_PTR(detectData.history);
+    Q_CHECK_PTR(detectData.reviewHistory);
+
+    _data.insert("Message", message);
+    _data.insert("Handle", QString::number(handle));
+    _data.insert("StockExchange", detectData.stockExchangeId.toString());
+    _data.insert("History", klinesToJson(*detectData.history));
+    _data.insert("ReviewHistory", klinesToJson(*detectData.reviewHistory));
+}
+
+QJsonObject DetectHistoryAnswer::toJson() const
+{
+    return _data;
+}
+
+TradingCatCommon::PackageType DetectHistoryAnswer::type() const
+{
+    return PackageType::UNDEFINED;
+}
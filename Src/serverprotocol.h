@@ -0,0 +1,312 @@
+#pragma once
+
+//STL
+#include <vector>
+
+//Qt
+#include <QString>
+#include <QStringList>
+#include <QUrlQuery>
+#include <QJsonObject>
+#include <QJsonArray>
+
+//My
+#include <TradingCatCommon/stockexchange.h>
+#include <TradingCatCommon/kline.h>
+#include <TradingCatCommon/detector.h>
+#include <TradingCatCommon/transmitdata.h>
+#include <TradingCatCommon/appserverprotocol.h>
+
+#include "klinesringbuffer.h"
+#include "latencytracer.h"
+#include "stockexchangemonitor.h"
+
+///////////////////////////////////////////////////////////////////////////////
+///     Запросы и ответы сервера, не входящие в протокол TradingCatCommon. Идентификаторы
+///         запросов выдает TradingCatCommon::IQuery, ответы упаковываются TradingCatCommon::Package.
+///         Типы этих ответов не входят в TradingCatCommon::PackageType - клиент определяет
+///         ответ по пути запроса
+///
+
+/*!
+    Сериализует свечу
+*/
+QJsonObject klineToJson(const TradingCatCommon::KLine& kline);
+QJsonObject klineToJson(const KLinesRingBuffer::KLineView& kline);
+QJsonArray klinesToJson(const TradingCatCommon::KLinesList& klines);
+
+///////////////////////////////////////////////////////////////////////////////
+///     The IServerQuery class - базовый класс запросов сервера
+///
+class IServerQuery
+    : public TradingCatCommon::IQuery
+{
+public:
+    /*!
+        Конструктор
+        @param isSessionRequired - false для служебных запросов без сессии пользователя
+    */
+    explicit IServerQuery(const QUrlQuery& query, bool isSessionRequired = true);
+    virtual ~IServerQuery() = default;
+
+    qint64 sessionId() const noexcept;
+
+    bool isError() const noexcept;
+    const QString& errorString() const noexcept;
+
+protected:
+    IServerQuery() = default;
+
+    QString _errorString;
+    qint64 _sessionId = 0;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+///     The DetectHistoryQuery class - запрос истории события по его идентификатору
+///         /data/history?sessionId=<id>&handle=<handle>
+///
+class DetectHistoryQuery final
+    : public IServerQuery
+{
+public:
+    static const QString& path();
+
+public:
+    DetectHistoryQuery() = default;
+    explicit DetectHistoryQuery(const QUrlQuery& query);
+
+    quint64 handle() const noexcept;
+
+private:
+    quint64 _handle = 0;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+///     The KLinesRangeQuery class - запрос свечей за интервал времени
+///         /data/klines?sessionId=<id>&stockExchange=<name>&id=<symbol>&type=<type>&from=<ms>&to=<ms>&limit=<count>
+///         type по умолчанию 1m, from - 0, to - текущее время, limit - MAX_LIMIT
+///
+class KLinesRangeQuery final
+    : public IServerQuery
+{
+public:
+    static constexpr qsizetype MAX_LIMIT = 1000;
+
+    static const QString& path();
+
+public:
+    KLinesRangeQuery() = default;
+    explicit KLinesRangeQuery(const QUrlQuery& query);
+
+    const QString& stockExchange() const noexcept;
+    const TradingCatCommon::KLineID& klineId() const noexcept;
+    qint64 from() const noexcept;
+    qint64 to() const noexcept;
+    qsizetype limit() const noexcept;
+
+private:
+    QString _stockExchange;
+    TradingCatCommon::KLineID _klineId;
+    qint64 _from = 0;
+    qint64 _to = 0;
+    qsizetype _limit = MAX_LIMIT;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+///     The KLinesRangeAnswer class - свечи за интервал времени. Большие интервалы
+///         передаются частями: если выбрано limit свечей, в ответ добавляется Next -
+///         значение from для запроса следующей части
+///
+class KLinesRangeAnswer final
+    : public TradingCatCommon::IAnswerData
+{
+public:
+    using KLineViewsList = std::vector<KLinesRingBuffer::KLineView>;
+
+public:
+    KLinesRangeAnswer(const TradingCatCommon::StockExchangeID& stockExchangeId, const KLinesRangeQuery& query, const KLineViewsList& klines);
+
+    QJsonObject toJson() const override;
+    TradingCatCommon::PackageType type() const override;
+
+private:
+    QJsonObject _data;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+///     The UsersOnlineQuery class - служебный запрос списка пользователей онлайн
+///         /admin/users?token=<admin token>&offset=<count>&limit=<count>
+///
+class UsersOnlineQuery final
+    : public IServerQuery
+{
+public:
+    static constexpr qsizetype MAX_LIMIT = 1000;
+
+    static const QString& path();
+
+public:
+    UsersOnlineQuery() = default;
+    explicit UsersOnlineQuery(const QUrlQuery& query);
+
+    const QString& token() const noexcept;
+    qsizetype offset() const noexcept;
+    qsizetype limit() const noexcept;
+
+private:
+    QString _token;
+    qsizetype _offset = 0;
+    qsizetype _limit = MAX_LIMIT;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+///     The UsersOnlineAnswer class - страница списка пользователей онлайн
+///
+class UsersOnlineAnswer final
+    : public TradingCatCommon::IAnswerData
+{
+public:
+    UsersOnlineAnswer(const QStringList& users, qsizetype offset, qsizetype total);
+
+    QJsonObject toJson() const override;
+    TradingCatCommon::PackageType type() const override;
+
+private:
+    QJsonObject _data;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+///     The LatencyQuery class - служебный запрос гистограмм задержки обработки свечей
+///         /admin/latency?token=<admin token>
+///
+class LatencyQuery final
+    : public IServerQuery
+{
+public:
+    static const QString& path();
+
+public:
+    LatencyQuery() = default;
+    explicit LatencyQuery(const QUrlQuery& query);
+
+    const QString& token() const noexcept;
+
+private:
+    QString _token;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+///     The LatencyAnswer class - гистограммы задержки от закрытия свечи по этапам и биржам
+///
+class LatencyAnswer final
+    : public TradingCatCommon::IAnswerData
+{
+public:
+    explicit LatencyAnswer(const LatencyTracer::StatisticList& statistic);
+
+    QJsonObject toJson() const override;
+    TradingCatCommon::PackageType type() const override;
+
+private:
+    QJsonObject _data;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+///     The MonitorQuery class - служебный запрос счетчиков поступления данных бирж
+///         /admin/monitor?token=<admin token>
+///
+class MonitorQuery final
+    : public IServerQuery
+{
+public:
+    static const QString& path();
+
+public:
+    MonitorQuery() = default;
+    explicit MonitorQuery(const QUrlQuery& query);
+
+    const QString& token() const noexcept;
+
+private:
+    QString _token;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+///     The MonitorAnswer class - счетчики поступления данных по биржам
+///
+class MonitorAnswer final
+    : public TradingCatCommon::IAnswerData
+{
+public:
+    explicit MonitorAnswer(const StockExchangeMonitor::CountersList& countersList);
+
+    QJsonObject toJson() const override;
+    TradingCatCommon::PackageType type() const override;
+
+private:
+    QJsonObject _data;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+///     The ReadinessStatusAnswer class - ответ /status с состоянием готовности бирж:
+///         Data.Readiness = {"Ready": все биржи конфигурации готовы, "StockExchanges": {<биржа>: готова}}.
+///         Сервер запускается до получения списков ID свечей всех бирж. Вместо списка пользователей
+///         онлайн передается только их количество Data.UsersOnlineCount
+///
+class ReadinessStatusAnswer final
+    : public TradingCatCommon::IAnswerData
+{
+public:
+    /*!
+        Конструктор
+        @param status - ответ /status
+        @param usersOnlineCount - количество пользователей онлайн
+        @param stockExchangesIdList - биржи конфигурации
+        @param readyStockExchangesIdList - биржи, от которых получен список ID свечей
+    */
+    ReadinessStatusAnswer(const TradingCatCommon::ServerStatusAnswer& status, qsizetype usersOnlineCount, const TradingCatCommon::StockExchangesIDList& stockExchangesIdList,
+                          const TradingCatCommon::StockExchangesIDList& readyStockExchangesIdList);
+
+    QJsonObject toJson() const override;
+    TradingCatCommon::PackageType type() const override;
+
+private:
+    QJsonObject _data;
+    TradingCatCommon::PackageType _type = TradingCatCommon::PackageType::UNDEFINED;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+///     The DetectHeadersAnswer class - события детектора без истории свечей.
+///         История запрашивается отдельно через DetectHistoryQuery
+///
+class DetectHeadersAnswer final
+    : public TradingCatCommon::IAnswerData
+{
+public:
+    using HandleList = std::vector<quint64>;
+
+public:
+    DetectHeadersAnswer(const TradingCatCommon::Detector::KLinesDetectedList& klinesDetectedList, const HandleList& handles, const QString& message);
+
+    QJsonObject toJson() const override;
+    TradingCatCommon::PackageType type() const override;
+
+private:
+    QJsonObject _data;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+///     The DetectHistoryAnswer class - история свечей события детектора
+///
+class DetectHistoryAnswer final
+    : public TradingCatCommon::IAnswerData
+{
+public:
+    DetectHistoryAnswer(quint64 handle, const TradingCatCommon::Detector::KLineDetectData& detectData, const QString& message);
+
+    QJsonObject toJson() const override;
+    TradingCatCommon::PackageType type() const override;
+
+private:
+    QJsonObject _data;
+};
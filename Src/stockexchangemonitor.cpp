@@ -0,0 +1,128 @@
+//STL
+#include <algorithm>
+
+//Qt
+#include <QMutexLocker>
+#include <QDateTime>
+
+#include "stockexchangemonitor.h"
+
+using namespace TradingCatCommon;
+using namespace Common;
+
+qint64 StockExchangeMonitor::Counters::lag(qint64 currentTime) const noexcept
+{
+    return lastKLineTime > 0 ? std::max<qint64>(currentTime - lastKLineTime, 0) : -1;
+}
+
+StockExchangeMonitor::StockExchangeMonitor(const TradingCatCommon::StockExchangesIDList& stockExchangesIdList, QObject* parent /* = nullptr */)
+    : QObject{parent}
+{
+    qRegisterMetaType<TradingCatCommon::StockExchangeID>("TradingCatCommon::StockExchangeID");
+    qRegisterMetaType<TradingCatCommon::PKLinesList>("TradingCatCommon::PKLinesList");
+    qRegisterMetaType<TradingCatCommon::PKLinesIDList>("TradingCatCommon::PKLinesIDList");
+    qRegisterMetaType<Common::MSG_CODE>("Common::MSG_CODE");
+
+    for (const auto& stockExchangeId: stockExchangesIdList)
+    {
+        _counters[stockExchangeId].stockExchangeId = stockExchangeId;
+    }
+}
+
+void StockExchangeMonitor::errorOccurred(const TradingCatCommon::StockExchangeID &stockExchangeId, const QString &errorString)
+{
+    QMutexLocker<QMutex> locker(&_mutex);
+
+    auto& counters = _counters[stockExchangeId];
+    counters.stockExchangeId = stockExchangeId;
+    ++counters.errors;
+    counters.lastErrorTime = QDateTime::currentMSecsSinceEpoch();
+    counters.lastError = errorString;
+    counters.isRunning = false;
+}
+
+void StockExchangeMonitor::restarted(const TradingCatCommon::StockExchangeID &stockExchangeId)
+{
+    QMutexLocker<QMutex> locker(&_mutex);
+
+    auto& counters = _counters[stockExchangeId];
+    counters.stockExchangeId = stockExchangeId;
+    ++counters.restarts;
+    counters.isRunning = true;
+}
+
+StockExchangeMonitor::CountersList StockExchangeMonitor::counters() const
+{
+    CountersList result;
+
+    {
+        QMutexLocker<QMutex> locker(&_mutex);
+
+        result.reserve(_counters.size());
+        for (const auto& [stockExchangeId, counters]: _counters)
+        {
+            result.push_back(counters);
+        }
+    }
+
+    std::sort(result.begin(), result.end(),
+        [](const Counters& left, const Counters& right)
+        {
+            return left.stockExchangeId.toString() < right.stockExchangeId.toString();
+        });
+
+    return result;
+}
+
+void StockExchangeMonitor::getKLines(const TradingCatCommon::StockExchangeID &stockExchangeId, const TradingCatCommon::PKLinesList &klines)
+{
+    Q_CHECK_PTR(klines);
+
+    const auto currentTime = QDateTime::currentMSecsSinceEpoch();
+
+    qint64 lastKLineTime = 0;
+    for (const auto& kline: *klines)
+    {
+        if (kline->closeTime <= currentTime)
+        {
+            lastKLineTime = std::max(lastKLineTime, kline->closeTime);
+        }
+    }
+
+    QMutexLocker<QMutex> locker(&_mutex);
+
+    auto& counters = _counters[stockExchangeId];
+    counters.stockExchangeId = stockExchangeId;
+    ++counters.batches;
+    counters.klines += klines->size();
+    counters.lastDataTime = currentTime;
+    counters.lastKLineTime = std::max(counters.lastKLineTime, lastKLineTime);
+}
+
+void StockExchangeMonitor::getKLinesID(const TradingCatCommon::StockExchangeID &stockExchangeId, const TradingCatCommon::PKLinesIDList &klinesIdList)
+{
+    Q_CHECK_PTR(klinesIdList);
+
+    QMutexLocker<QMutex> locker(&_mutex);
+
+    auto& counters = _counters[stockExchangeId];
+    counters.stockExchangeId = stockExchangeId;
+    ++counters.klinesIdUpdates;
+    counters.klinesIdCount = static_cast<qsizetype>(klinesIdList->size());
+}
+
+void StockExchangeMonitor::sendLogMsg(const TradingCatCommon::StockExchangeID &stockExchangeId, Common::MSG_CODE category, const QString &msg)
+{
+    Q_UNUSED(msg);
+
+    if (category != MSG_CODE::WARNING_CODE && category != MSG_CODE::CRITICAL_CODE)
+    {
+        return;
+    }
+
+    QMutexLocker<QMutex> locker(&_mutex);
+
+    auto& counters = _counters[stockExchangeId];
+    counters.stockExchangeId = stockExchangeId;
+    ++counters.warnings;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+//STL
+#include <unordered_map>
+#include <vector>
+
+//Qt
+#include <QObject>
+#include <QMutex>
+
+//My
+#include <Common/common.h>
+
+#include <TradingCatCommon/stockexchange.h>
+#include <TradingCatCommon/kline.h>
+
+///////////////////////////////////////////////////////////////////////////////
+///     The StockExchangeMonitor class - счетчики поступления данных от каждой биржи:
+///         пакеты и свечи, предупреждения и ошибки коннектора, перезапуски, время
+///         последней закрытой свечи и отставание от текущего времени. Данные собираются
+///         по сигналам коннекторов через Qt::DirectConnection в потоках бирж.
+///         Потокобезопасен
+///
+class StockExchangeMonitor final
+    : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Counters
+    {
+        TradingCatCommon::StockExchangeID stockExchangeId;
+        quint64 batches = 0;          ///< получено пакетов свечей
+        quint64 klines = 0;           ///< получено свечей
+        quint64 klinesIdUpdates = 0;  ///< получено списков ID свечей
+        qsizetype klinesIdCount = 0;  ///< размер последнего списка ID свечей
+        quint64 warnings = 0;         ///< предупреждений коннектора
+        quint64 errors = 0;           ///< критических ошибок коннектора
+        quint64 restarts = 0;
+        qint64 lastDataTime = 0;      ///< время получения последнего пакета, мс. 0 - данных не было
+        qint64 lastKLineTime = 0;     ///< время закрытия последней закрытой свечи, мс. 0 - данных не было
+        qint64 lastErrorTime = 0;
+        QString lastError;
+        bool isRunning = true;        ///< false - биржа остановлена и ожидает перезапуска
+
+        /*!
+            Отставание последней закрытой свечи от текущего времени, мс. -1 - данных не было
+        */
+        qint64 lag(qint64 currentTime) const noexcept;
+    };
+    using CountersList = std::vector<Counters>;
+
+public:
+    explicit StockExchangeMonitor(const TradingCatCommon::StockExchangesIDList& stockExchangesIdList, QObject* parent = nullptr);
+    ~StockExchangeMonitor() override = default;
+
+    void errorOccurred(const TradingCatCommon::StockExchangeID& stockExchangeId, const QString& errorString);
+    void restarted(const TradingCatCommon::StockExchangeID& stockExchangeId);
+
+    CountersList counters() const;
+
+public slots:
+    void getKLines(const TradingCatCommon::StockExchangeID& stockExchangeId, const TradingCatCommon::PKLinesList& klines);
+    void getKLinesID(const TradingCatCommon::StockExchangeID& stockExchangeId, const TradingCatCommon::PKLinesIDList& klinesIdList);
+    void sendLogMsg(const TradingCatCommon::StockExchangeID& stockExchangeId, Common::MSG_CODE category, const QString& msg);
+
+private:
+    StockExchangeMonitor() = delete;
+    Q_DISABLE_COPY_MOVE(StockExchangeMonitor);
+
+private:
+    mutable QMutex _mutex;
+    std::unordered_map<TradingCatCommon::StockExchangeID, Counters> _counters;
+};
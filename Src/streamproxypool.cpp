@@ -0,0 +1,183 @@
+//STL
+#include <algorithm>
+
+//Qt
+#include <QMutexLocker>
+#include <QDateTime>
+#include <QRandomGenerator>
+
+#include "idinterner.h"
+#include "streamproxypool.h"
+
+using namespace TradingCatCommon;
+
+static const double EWMA_WEIGHT = 0.2;                 // вес нового измерения в скользящих средних
+static const double ERROR_PENALTY = 10.0;              // во сколько раз ошибки ухудшают оценку задержки
+static const quint32 EJECT_ERRORS = 3;                 // ошибок подряд до исключения прокси
+static const qint64 MIN_EJECT_INTERVAL = 30 * 1000;
+static const qint64 MAX_EJECT_INTERVAL = 10 * 60 * 1000;
+
+StreamProxyPool::StreamProxyPool(const Common::ProxyList& proxyList)
+    : _proxyList(proxyList)
+{
+}
+
+bool StreamProxyPool::isEmpty() const noexcept
+{
+    return _proxyList.empty();
+}
+
+qsizetype StreamProxyPool::choose(const TradingCatCommon::StockExchangeID &stockExchangeId)
+{
+    if (_proxyList.empty())
+    {
+        return NO_PROXY;
+    }
+
+    const auto currentDateTime = QDateTime::currentMSecsSinceEpoch();
+
+    QMutexLocker<QMutex> locker(&_mutex);
+
+    const auto& health = stockExchangeHealth(stockExchangeId);
+
+    std::vector<qsizetype> candidates;
+    candidates.reserve(health.size());
+    for (qsizetype index = 0; index < static_cast<qsizetype>(health.size()); ++index)
+    {
+        if (health[index].ejectedUntil <= currentDateTime)
+        {
+            candidates.push_back(index);
+        }
+    }
+
+    // исключены все прокси - используем тот, который вернется в пул раньше остальных
+    if (candidates.empty())
+    {
+        const auto it_health = std::min_element(health.begin(), health.end(),
+            [](const Health& left, const Health& right)
+            {
+                return left.ejectedUntil < right.ejectedUntil;
+            });
+
+        return static_cast<qsizetype>(std::distance(health.begin(), it_health));
+    }
+
+    if (candidates.size() == 1)
+    {
+        return candidates.front();
+    }
+
+    auto generator = QRandomGenerator::global();
+    const auto first = generator->bounded(static_cast<quint32>(candidates.size()));
+    auto second = generator->bounded(static_cast<quint32>(candidates.size() - 1));
+    if (second >= first)
+    {
+        ++second;
+    }
+
+    const auto firstIndex = candidates[first];
+    const auto secondIndex = candidates[second];
+
+    return score(health[firstIndex]) <= score(health[secondIndex]) ? firstIndex : secondIndex;
+}
+
+QNetworkProxy StreamProxyPool::proxy(qsizetype index) const
+{
+    Q_ASSERT(index >= 0 && index < static_cast<qsizetype>(_proxyList.size()));
+
+    return _proxyList[index];
+}
+
+void StreamProxyPool::reportSuccess(qsizetype index, const TradingCatCommon::StockExchangeID &stockExchangeId, qint64 latency)
+{
+    if (index == NO_PROXY)
+    {
+        return;
+    }
+
+    QMutexLocker<QMutex> locker(&_mutex);
+
+    auto& health = stockExchangeHealth(stockExchangeId)[index];
+
+    health.latency = health.requests == 0 ? static_cast<double>(latency) : health.latency + EWMA_WEIGHT * (static_cast<double>(latency) - health.latency);
+    health.errorRate -= EWMA_WEIGHT * health.errorRate;
+    health.consecutiveErrors = 0;
+    health.ejectInterval = 0;
+    ++health.requests;
+}
+
+void StreamProxyPool::reportError(qsizetype index, const TradingCatCommon::StockExchangeID &stockExchangeId)
+{
+    if (index == NO_PROXY)
+    {
+        return;
+    }
+
+    QMutexLocker<QMutex> locker(&_mutex);
+
+    auto& health = stockExchangeHealth(stockExchangeId)[index];
+
+    health.errorRate += EWMA_WEIGHT * (1.0 - health.errorRate);
+    ++health.consecutiveErrors;
+    ++health.requests;
+    ++health.errors;
+
+    if (health.consecutiveErrors >= EJECT_ERRORS)
+    {
+        health.ejectInterval = health.ejectInterval == 0 ? MIN_EJECT_INTERVAL : std::min(health.ejectInterval * 2, MAX_EJECT_INTERVAL);
+        health.ejectedUntil = QDateTime::currentMSecsSinceEpoch() + health.ejectInterval;
+        health.consecutiveErrors = 0;
+    }
+}
+
+StreamProxyPool::ProxyStatisticList StreamProxyPool::statistic(const TradingCatCommon::StockExchangeID &stockExchangeId)
+{
+    const auto currentDateTime = QDateTime::currentMSecsSinceEpoch();
+
+    QMutexLocker<QMutex> locker(&_mutex);
+
+    const auto& health = stockExchangeHealth(stockExchangeId);
+
+    ProxyStatisticList result;
+    result.reserve(health.size());
+    for (qsizetype index = 0; index < static_cast<qsizetype>(health.size()); ++index)
+    {
+        const auto& proxy = _proxyList[index];
+        const auto& proxyHealth = health[index];
+
+        ProxyStatistic tmp;
+        tmp.proxy = QString("%1:%2").arg(proxy.hostName()).arg(proxy.port());
+        tmp.latency = proxyHealth.latency;
+        tmp.errorRate = proxyHealth.errorRate;
+        tmp.requests = proxyHealth.requests;
+        tmp.errors = proxyHealth.errors;
+        tmp.isEjected = proxyHealth.ejectedUntil > currentDateTime;
+
+        result.emplace_back(std::move(tmp));
+    }
+
+    return result;
+}
+
+std::vector<StreamProxyPool::Health> &StreamProxyPool::stockExchangeHealth(const TradingCatCommon::StockExchangeID &stockExchangeId)
+{
+    const auto stockExchangeIndex = IDInterner::stockExchange(stockExchangeId);
+    if (stockExchangeIndex >= _health.size())
+    {
+        _health.resize(stockExchangeIndex + 1);
+    }
+
+    auto& health = _health[stockExchangeIndex];
+    if (health.empty())
+    {
+        health.resize(_proxyList.size());
+    }
+
+    return health;
+}
+
+double StreamProxyPool::score(const Health &health) noexcept
+{
+    // прокси без измерений получают лучшую оценку, чтобы попасть в выборку
+    return (health.latency + 1.0) * (1.0 + ERROR_PENALTY * health.errorRate);
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+//STL
+#include <vector>
+
+//Qt
+#include <QMutex>
+#include <QNetworkProxy>
+
+//My
+#include <Common/httpsslquery.h>
+
+#include <TradingCatCommon/stockexchange.h>
+
+///////////////////////////////////////////////////////////////////////////////
+///     The StreamProxyPool class - выбор прокси для подключений WebSocket-потоков свечей
+///         с оценкой качества каждой пары (прокси, биржа). Для пары хранится скользящее
+///         среднее задержки и доли ошибок. Прокси выбирается из двух случайных исправных
+///         прокси по лучшей оценке (power of two choices). После нескольких ошибок подряд
+///         прокси исключается для биржи на время, которое удваивается при повторных
+///         исключениях. REST-коннекторы бирж пул не используют: они получают весь список
+///         прокси из конфигурации и не сообщают, через какой прокси выполнен запрос.
+///         Потокобезопасен
+///
+class StreamProxyPool final
+{
+public:
+    static constexpr qsizetype NO_PROXY = -1;
+
+    struct ProxyStatistic
+    {
+        QString proxy;            ///< host:port
+        double latency = 0.0;     ///< средняя задержка, мс. 0 - нет данных
+        double errorRate = 0.0;   ///< скользящая доля ошибок [0, 1]
+        quint64 requests = 0;
+        quint64 errors = 0;
+        bool isEjected = false;
+    };
+    using ProxyStatisticList = std::vector<ProxyStatistic>;
+
+public:
+    explicit StreamProxyPool(const Common::ProxyList& proxyList);
+
+    bool isEmpty() const noexcept;
+
+    /*!
+        Выбор прокси для запроса к бирже
+        @return индекс прокси или NO_PROXY, если пул пуст
+    */
+    qsizetype choose(const TradingCatCommon::StockExchangeID& stockExchangeId);
+
+    QNetworkProxy proxy(qsizetype index) const;
+
+    /*!
+        Результат запроса через прокси
+        @param latency - время выполнения запроса, мс
+    */
+    void reportSuccess(qsizetype index, const TradingCatCommon::StockExchangeID& stockExchangeId, qint64 latency);
+    void reportError(qsizetype index, const TradingCatCommon::StockExchangeID& stockExchangeId);
+
+    ProxyStatisticList statistic(const TradingCatCommon::StockExchangeID& stockExchangeId);
+
+private:
+    StreamProxyPool() = delete;
+    Q_DISABLE_COPY_MOVE(StreamProxyPool);
+
+    struct Health
+    {
+        double latency = 0.0;
+        double errorRate = 0.0;
+        quint32 consecutiveErrors = 0;
+        qint64 ejectedUntil = 0;
+        qint64 ejectInterval = 0;
+        quint64 requests = 0;
+        quint64 errors = 0;
+    };
+
+    std::vector<Health>& stockExchangeHealth(const TradingCatCommon::StockExchangeID& stockExchangeId);
+    static double score(const Health& health) noexcept;
+
+private:
+    const Common::ProxyList _proxyList;
+
+    mutable QMutex _mutex;
+    std::vector<std::vector<Health>> _health;   ///< по индексу биржи в IDInterner и индексу прокси
+};
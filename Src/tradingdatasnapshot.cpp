@@ -0,0 +1,69 @@
+#include "tradingdatasnapshot.h"
+
+using namespace TradingCatCommon;
+
+static const qint64 REFRESH_INTERVAL = 1000;
+
+TradingDataSnapshot::TradingDataSnapshot(const TradingCatCommon::TradingData& tradingData, QObject* parent /* = nullptr */)
+    : QObject{parent}
+    , _tradingData(tradingData)
+    , _snapshot(std::make_shared<const Snapshot>())
+{
+}
+
+TradingDataSnapshot::PSnapshot TradingDataSnapshot::snapshot() const
+{
+    return _snapshot.load(std::memory_order_acquire);
+}
+
+TradingCatCommon::PKLinesIDList TradingDataSnapshot::getKLinesIDList(const TradingCatCommon::StockExchangeID &stockExchangeId) const
+{
+    const auto currentSnapshot = snapshot();
+
+    const auto it_klinesIdList = currentSnapshot->klinesIdList.find(stockExchangeId);
+    if (it_klinesIdList == currentSnapshot->klinesIdList.end() || !it_klinesIdList->second)
+    {
+        return std::make_shared<KLinesIDList>();
+    }
+
+    return it_klinesIdList->second;
+}
+
+void TradingDataSnapshot::start()
+{
+    refresh();
+
+    _refreshTimer = new QTimer(this);
+
+    connect(_refreshTimer, SIGNAL(timeout()), SLOT(refresh()));
+
+    _refreshTimer->start(REFRESH_INTERVAL);
+}
+
+void TradingDataSnapshot::stop()
+{
+    delete _refreshTimer;
+    _refreshTimer = nullptr;
+}
+
+void TradingDataSnapshot::refresh()
+{
+    auto newSnapshot = std::make_shared<Snapshot>();
+
+    newSnapshot->version = snapshot()->version + 1;
+    newSnapshot->stockExchangesIdList = _tradingData.stockExcangesIdList();
+    for (const auto& stockExchangeId: newSnapshot->stockExchangesIdList)
+    {
+        // TradingData может изменять свой список после публикации снимка - храним копию
+        const auto klinesIdList = _tradingData.getKLinesIDList(stockExchangeId);
+        auto klinesIdListCopy = klinesIdList ? std::make_shared<KLinesIDList>(*klinesIdList) : std::make_shared<KLinesIDList>();
+        if (!klinesIdListCopy->empty())
+        {
+            newSnapshot->readyStockExchangesIdList.emplace(stockExchangeId);
+        }
+        newSnapshot->klinesIdList.emplace(stockExchangeId, std::move(klinesIdListCopy));
+    }
+    newSnapshot->moneyCount = _tradingData.moneyCount();
+
+    _snapshot.store(std::move(newSnapshot), std::memory_order_release);
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+//STL
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+
+//Qt
+#include <QObject>
+#include <QTimer>
+
+//My
+#include <TradingCatCommon/stockexchange.h>
+#include <TradingCatCommon/kline.h>
+#include <TradingCatCommon/tradingdata.h>
+
+///////////////////////////////////////////////////////////////////////////////
+///     The TradingDataSnapshot class - неизменяемые снимки данных TradingData для
+///         потоков обработки запросов. Снимок строится в потоке TradingData из копий
+///         списков TradingData и публикуется заменой указателя через std::atomic<std::shared_ptr>.
+///         Читатели не обращаются к TradingData, но сама замена указателя в libstdc++
+///         выполняется под внутренней блокировкой
+///
+class TradingDataSnapshot final
+    : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Snapshot
+    {
+        quint64 version = 0;
+        TradingCatCommon::StockExchangesIDList stockExchangesIdList;
+        std::unordered_map<TradingCatCommon::StockExchangeID, TradingCatCommon::PKLinesIDList> klinesIdList;
+        TradingCatCommon::StockExchangesIDList readyStockExchangesIdList;   ///< биржи, от которых уже получен список ID свечей
+        quint64 moneyCount = 0;
+    };
+
+    using PSnapshot = std::shared_ptr<const Snapshot>;
+
+public:
+    explicit TradingDataSnapshot(const TradingCatCommon::TradingData& tradingData, QObject* parent = nullptr);
+    ~TradingDataSnapshot() override = default;
+
+    /*!
+        Текущий снимок. Потокобезопасен, TradingData не блокирует
+    */
+    PSnapshot snapshot() const;
+
+    /*!
+        Список ID свечей биржи из текущего снимка. Пустой список, если биржа неизвестна
+    */
+    TradingCatCommon::PKLinesIDList getKLinesIDList(const TradingCatCommon::StockExchangeID& stockExchangeId) const;
+
+public slots:
+    void start();
+    void stop();
+
+    /*!
+        Перестраивает снимок. Вызывается в потоке TradingData
+    */
+    void refresh();
+
+private:
+    TradingDataSnapshot() = delete;
+    Q_DISABLE_COPY_MOVE(TradingDataSnapshot);
+
+private:
+    const TradingCatCommon::TradingData& _tradingData;
+
+    std::atomic<PSnapshot> _snapshot;
+
+    QTimer* _refreshTimer = nullptr;
+};
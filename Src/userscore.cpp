@@ -1,5 +1,7 @@
 //STL
 #include <limits>
+#include <algorithm>
+#include <vector>
 
 //Qt
 #include <QJsonObject>
@@ -19,14 +21,15 @@
 using namespace Common;
 
 static const qint64 CONNECTION_TIMEOUT = 60 * 1000;
-static const qsizetype MAX_DETECT_EVENT = 5;
+static const size_t MAX_HISTORY_HANDLES = 100;
+static const qsizetype MAX_HISTORY_KLINES = 20000; // свечей в истории неотданных событий одной сессии (~2 МБ)
 
 Q_GLOBAL_STATIC(QMutex, onlineMutex);
 Q_GLOBAL_STATIC(QMutex, userDataMutex);
 
 using namespace TradingCatCommon;
 
-UsersCore::UsersCore(const Common::DBConnectionInfo &dbConnectionInfo, const TradingCatCommon::TradingData& tradingData, QObject *parent /* = nullptr*/)
+UsersCore::UsersCore(const Common::DBConnectionInfo &dbConnectionInfo, const TradingDataSnapshot& tradingData, QObject *parent /* = nullptr*/)
     : QObject{parent}
     , _dbConnectionInfo(dbConnectionInfo)
     , _tradingData(tradingData)
@@ -104,9 +107,11 @@ QString UsersCore::logout(const TradingCatCommon::LogoutQuery &query)
         userName = it_onlineUsers->second.user;
 
         _onlineUsers.erase(it_onlineUsers);
+
+        // userOnline/userOffline генерируются под onlineMutex - детектор получает их в порядке изменения _onlineUsers
+        emit userOffline(sessionId);
     }
 
-    emit userOffline(sessionId);
     emit sendLogMsg(MSG_CODE::INFORMATION_CODE, QString("%1 User logout. User: %1 SessionID: %2").arg(query.id()). arg(userName).arg(sessionId));
 
     return Package(LogoutAnswer(*OK_ANSWER_TEXT)).toJson();
@@ -129,7 +134,6 @@ QString UsersCore::config(const TradingCatCommon::ConfigQuery &query)
     auto& sessionData = it_onlineUsers->second;
     const auto& userName = sessionData.user;
     sessionData.lastData = QDateTime::currentDateTime();
-    sessionData.klinesDetectedList.clear();
 
     Q_ASSERT(!userName.isEmpty());
 
@@ -137,15 +141,52 @@ QString UsersCore::config(const TradingCatCommon::ConfigQuery &query)
 
     auto& user = _users->user(userName);
 
+    const auto filterDiff = diffFilters(user.config(), query.config());
+    if (filterDiff.added == 0 && filterDiff.removed == 0 && user.config().toJson() == query.config().toJson())
+    {
+        emit sendLogMsg(MSG_CODE::INFORMATION_CODE, QString("%1 User config not changed. User: %2 SessionID: %3").arg(query.id()).arg(userName).arg(sessionId));
+
+        return Package(ConfigAnswer(*OK_ANSWER_TEXT)).toJson();
+    }
+
+    // событие детектора не указывает, какой фильтр сработал, поэтому по удаленному фильтру его не найти.
+    // Неотданные события сбрасываются, только если не осталось ни одного прежнего фильтра. Время отдачи
+    // событий (cooldown) относится к уже отданным событиям и сохраняется
+    if (filterDiff.removed > 0 && filterDiff.kept == 0)
+    {
+        sessionData.detectEvents.clearPending();
+    }
+
     user.setConfig(query.config());
 
     emit userOnline(sessionId, user.config());
-    emit sendLogMsg(MSG_CODE::INFORMATION_CODE, QString("%1 User update config successfully. User: %2 SessionID: %3").arg(query.id()).arg(userName).arg(sessionId));
+    emit sendLogMsg(MSG_CODE::INFORMATION_CODE, QString("%1 User update config successfully. Filters added: %2 removed: %3 kept: %4. User: %5 SessionID: %6")
+                                                    .arg(query.id())
+                                                    .arg(filterDiff.added)
+                                                    .arg(filterDiff.removed)
+                                                    .arg(filterDiff.kept)
+                                                    .arg(userName)
+                                                    .arg(sessionId));
 
     return Package(ConfigAnswer(*OK_ANSWER_TEXT)).toJson();
 }
 
-QString UsersCore::detect(const TradingCatCommon::DetectQuery &query)
+void UsersCore::setLatencyTracer(LatencyTracer *latencyTracer)
+{
+    Q_ASSERT(!_isStarted);
+
+    _latencyTracer = latencyTracer;
+}
+
+void UsersCore::setDetectCooldown(qint64 detectCooldown)
+{
+    Q_ASSERT(!_isStarted);
+    Q_ASSERT(detectCooldown >= 0);
+
+    _detectCooldown = detectCooldown;
+}
+
+QString UsersCore::detect(const TradingCatCommon::DetectQuery &query, bool isLazyHistory /* = false */)
 {
     const auto sessionId = query.sessionId();
 
@@ -161,13 +202,52 @@ QString UsersCore::detect(const TradingCatCommon::DetectQuery &query)
 
     auto& sessionData = it_onlineUsers->second;
     sessionData.lastData = QDateTime::currentDateTime();
-    auto& klinesDetectedList = sessionData.klinesDetectedList;
+    const auto& klinesDetectedList = sessionData.detectEvents.klinesDetectedList();
 
     const auto eventsCount = klinesDetectedList.detected.size();
 
-    const auto result = Package(DetectAnswer(klinesDetectedList, *OK_ANSWER_TEXT)).toJson();
+    QString result;
+    if (isLazyHistory)
+    {
+        // история свечей остается на сервере и отдается по запросу
+        auto& detectHistory = sessionData.detectHistory;
+
+        DetectHeadersAnswer::HandleList handles;
+        handles.reserve(eventsCount);
+        for (const auto& detectData: klinesDetectedList.detected)
+        {
+            const auto handle = ++_lastHistoryHandle;
+            detectHistory.emplace(handle, detectData);
+            handles.push_back(handle);
+
+            sessionData.detectHistoryKLines += historyKLinesCount(*detectData);
+        }
+
+        // истории событий хранят полные векторы свечей - ограничиваем и количество событий, и объем
+        while (!detectHistory.empty() && (detectHistory.size() > MAX_HISTORY_HANDLES || sessionData.detectHistoryKLines > MAX_HISTORY_KLINES))
+        {
+            sessionData.detectHistoryKLines -= historyKLinesCount(*detectHistory.begin()->second);
+            detectHistory.erase(detectHistory.begin());
+        }
+
+        result = Package(DetectHeadersAnswer(klinesDetectedList, handles, *OK_ANSWER_TEXT)).toJson();
+    }
+    else
+    {
+        result = Package(DetectAnswer(klinesDetectedList, *OK_ANSWER_TEXT)).toJson();
+    }
+
+    // интервал подавления повторных событий отсчитывается от отдачи события клиенту
+    const auto currentTime = QDateTime::currentMSecsSinceEpoch();
+    if (_latencyTracer)
+    {
+        for (const auto& detectData: klinesDetectedList.detected)
+        {
+            _latencyTracer->addDetect(LatencyTracer::Hop::DELIVERY, *detectData);
+        }
+    }
 
-    klinesDetectedList.clear();
+    sessionData.detectEvents.delivered(currentTime);
 
     onlineLocker.unlock();
 
@@ -176,6 +256,40 @@ QString UsersCore::detect(const TradingCatCommon::DetectQuery &query)
     return result;
 }
 
+QString UsersCore::detectHistory(const DetectHistoryQuery &query)
+{
+    const auto sessionId = query.sessionId();
+
+    QMutexLocker<QMutex> onlineLocker(onlineMutex);
+
+    const auto it_onlineUsers = _onlineUsers.find(sessionId);
+    if (it_onlineUsers == _onlineUsers.end())
+    {
+        emit sendLogMsg(MSG_CODE::WARNING_CODE, QString("%1 User not login. SessionID: %2. Skip").arg(query.id()).arg(sessionId));
+
+        return Package(StatusAnswer::ErrorCode::UNAUTHORIZED).toJson();
+    }
+
+    auto& sessionData = it_onlineUsers->second;
+    sessionData.lastData = QDateTime::currentDateTime();
+
+    const auto it_detectHistory = sessionData.detectHistory.find(query.handle());
+    if (it_detectHistory == sessionData.detectHistory.end())
+    {
+        emit sendLogMsg(MSG_CODE::WARNING_CODE, QString("%1 Detect history not found. Handle: %2 SessionID: %3").arg(query.id()).arg(query.handle()).arg(sessionId));
+
+        return Package(StatusAnswer::ErrorCode::NOT_FOUND, "History not found or expired").toJson();
+    }
+
+    const auto detectData = it_detectHistory->second;
+
+    onlineLocker.unlock();
+
+    emit sendLogMsg(MSG_CODE::INFORMATION_CODE, QString("%1 Send detect history. Handle: %2 SessionID: %3").arg(query.id()).arg(query.handle()).arg(sessionId));
+
+    return Package(DetectHistoryAnswer(query.handle(), *detectData, *OK_ANSWER_TEXT)).toJson();
+}
+
 bool UsersCore::isOnline(int sessionId) const
 {
     QMutexLocker<QMutex> locker(onlineMutex);
@@ -200,9 +314,11 @@ QString UsersCore::stockExchange(const TradingCatCommon::StockExchangesQuery &qu
     auto& sessionData = it_onlineUsers->second;
     sessionData.lastData = QDateTime::currentDateTime();
 
+    onlineLocker.unlock();
+
     emit sendLogMsg(MSG_CODE::INFORMATION_CODE, QString("%1 Successfully finished. Send answer").arg(query.id()));
 
-    return Package(StockExchangesAnswer(_tradingData.stockExcangesIdList(), *OK_ANSWER_TEXT)).toJson();
+    return Package(StockExchangesAnswer(_tradingData.snapshot()->stockExchangesIdList, *OK_ANSWER_TEXT)).toJson();
 }
 
 QString UsersCore::klinesIdList(const TradingCatCommon::KLinesIDListQuery &query)
@@ -222,18 +338,47 @@ QString UsersCore::klinesIdList(const TradingCatCommon::KLinesIDListQuery &query
     auto& sessionData = it_onlineUsers->second;
     sessionData.lastData = QDateTime::currentDateTime();
 
+    onlineLocker.unlock();
+
     return Package(KLinesIDListAnswer(query.stockExchangeId(), _tradingData.getKLinesIDList(query.stockExchangeId()), *OK_ANSWER_TEXT)).toJson();
 }
 
-QStringList UsersCore::usersOnline() const
+qsizetype UsersCore::usersOnlineCount() const
 {
+    QMutexLocker<QMutex> locker(onlineMutex);
+
+    return static_cast<qsizetype>(_onlineUsers.size());
+}
+
+QStringList UsersCore::usersOnline(qsizetype offset, qsizetype limit, qsizetype& total) const
+{
+    Q_ASSERT(offset >= 0);
+    Q_ASSERT(limit > 0);
+
     QStringList result;
 
     QMutexLocker<QMutex> locker(onlineMutex);
 
+    total = static_cast<qsizetype>(_onlineUsers.size());
+    if (offset >= total)
+    {
+        return result;
+    }
+
+    std::vector<qint64> sessionsId;
+    sessionsId.reserve(_onlineUsers.size());
     for (const auto& user: _onlineUsers)
     {
-        result.push_back(QString("%1(%2)").arg(user.second.user).arg(user.first));
+        sessionsId.push_back(user.first);
+    }
+
+    const auto last = std::min(offset + limit, total);
+    std::partial_sort(sessionsId.begin(), sessionsId.begin() + last, sessionsId.end());
+
+    for (auto index = offset; index < last; ++index)
+    {
+        const auto sessionId = sessionsId[index];
+        result.push_back(QString("%1(%2)").arg(_onlineUsers.at(sessionId).user).arg(sessionId));
     }
 
     return result;
@@ -295,6 +440,56 @@ void UsersCore::errorOccurredUsers(Common::EXIT_CODE errorCode, const QString &e
     emit errorOccurred(errorCode, QString("Users data: %1").arg(errorString));
 }
 
+UsersCore::FilterDiff UsersCore::diffFilters(const TradingCatCommon::UserConfig &oldConfig, const TradingCatCommon::UserConfig &newConfig)
+{
+    const auto filters =
+        [](const UserConfig& config)
+        {
+            const auto json = QJsonDocument::fromJson(config.toJson().toUtf8()).object();
+
+            std::vector<QJsonObject> result;
+            for (const auto& filter: json.value("Filter").toObject().value("Filters").toArray())
+            {
+                result.push_back(filter.toObject());
+            }
+
+            return result;
+        };
+
+    auto oldFilters = filters(oldConfig);
+    auto newFilters = filters(newConfig);
+
+    // фильтр определяется всеми условиями и порогами: измененный фильтр - удален и добавлен
+    FilterDiff result;
+    std::erase_if(newFilters,
+        [&oldFilters, &result](const QJsonObject& filter)
+        {
+            const auto it_oldFilters = std::find(oldFilters.begin(), oldFilters.end(), filter);
+            if (it_oldFilters == oldFilters.end())
+            {
+                return false;
+            }
+
+            oldFilters.erase(it_oldFilters);
+            ++result.kept;
+
+            return true;
+        });
+
+    result.added = static_cast<qsizetype>(newFilters.size());
+    result.removed = static_cast<qsizetype>(oldFilters.size());
+
+    return result;
+}
+
+qsizetype UsersCore::historyKLinesCount(const TradingCatCommon::Detector::KLineDetectData &detectData)
+{
+    Q_CHECK_PTR(detectData.history);
+    Q_CHECK_PTR(detectData.reviewHistory);
+
+    return static_cast<qsizetype>(detectData.history->size() + detectData.reviewHistory->size());
+}
+
 qint64 UsersCore::getId()
 {
 #ifndef QT_DEBUG
@@ -310,9 +505,14 @@ void UsersCore::connectionTimeout()
 {
     QMutexLocker<QMutex> locker(onlineMutex);
 
+    const auto currentTime = QDateTime::currentMSecsSinceEpoch();
+
     for (auto it_onlineUser = _onlineUsers.begin(); it_onlineUser != _onlineUsers.end();)
     {
         auto& sessionData = it_onlineUser->second;
+
+        sessionData.detectEvents.expire(_detectCooldown, currentTime);
+
         if (sessionData.lastData.msecsTo(QDateTime::currentDateTime()) > CONNECTION_TIMEOUT)
         {
             emit userOffline(it_onlineUser->first);
@@ -340,22 +540,18 @@ void UsersCore::klineDetect(qint64 sessionId, const TradingCatCommon::Detector::
     Q_ASSERT(!detectData->reviewHistory->empty());
     Q_ASSERT(detectData->filterActivate != Filter::FilterType::UNDETECT);
 
-    QMutexLocker<QMutex> locker(onlineMutex);
-
-    auto it_onlineUser = _onlineUsers.find(sessionId);
-    if (it_onlineUser == _onlineUsers.end())
+    if (_latencyTracer)
     {
-        return;
+        _latencyTracer->addDetect(LatencyTracer::Hop::DETECT, *detectData);
     }
 
-    auto& klinesDetectedList = it_onlineUser->second.klinesDetectedList;
+    QMutexLocker<QMutex> locker(onlineMutex);
 
-    if (klinesDetectedList.detected.size() > MAX_DETECT_EVENT)
+    auto it_onlineUser = _onlineUsers.find(sessionId);
+    if (it_onlineUser == _onlineUsers.end())
     {
-        klinesDetectedList.isFull = true;
-
         return;
     }
 
-    klinesDetectedList.detected.emplace_back(detectData);
+    it_onlineUser->second.detectEvents.add(detectData, _detectCooldown, QDateTime::currentMSecsSinceEpoch());
 }
@@ -3,6 +3,7 @@
 //STL
 #include <memory>
 #include <unordered_map>
+#include <map>
 
 //Qt
 #include <QObject>
@@ -21,6 +22,10 @@
 #include <TradingCatCommon/tradingdata.h>
 #include <TradingCatCommon/detector.h>
 
+#include "serverprotocol.h"
+#include "tradingdatasnapshot.h"
+#include "latencytracer.h"
+#include "detectevents.h"
 #include "usersdata.h"
 
 class UsersCore
@@ -29,19 +34,40 @@ class UsersCore
     Q_OBJECT
 
 public:
-    explicit UsersCore(const Common::DBConnectionInfo& dbConnectionInfo, const TradingCatCommon::TradingData& tradingData, QObject *parent = nullptr);
+    explicit UsersCore(const Common::DBConnectionInfo& dbConnectionInfo, const TradingDataSnapshot& tradingData, QObject *parent = nullptr);
     ~UsersCore() override;
 
+    /*!
+        Трассировка задержки событий детектора. Вызывается до запуска
+        @param latencyTracer - nullptr - трассировка отключена
+    */
+    void setLatencyTracer(LatencyTracer* latencyTracer);
+
+    /*!
+        Минимальный интервал между отдачей клиенту событий одной свечи и фильтра. Вызывается до запуска
+        @param detectCooldown - интервал в мс. 0 - события не подавляются
+    */
+    void setDetectCooldown(qint64 detectCooldown);
+
     QString login(const TradingCatCommon::LoginQuery& query);
     QString logout(const TradingCatCommon::LogoutQuery& query);
     QString config(const TradingCatCommon::ConfigQuery& query);
     QString stockExchange(const TradingCatCommon::StockExchangesQuery& query);
     QString klinesIdList(const TradingCatCommon::KLinesIDListQuery& query);
-    QString detect(const TradingCatCommon::DetectQuery& query);
+    QString detect(const TradingCatCommon::DetectQuery& query, bool isLazyHistory = false);
+    QString detectHistory(const DetectHistoryQuery& query);
 
     bool isOnline(int sessionId) const;
 
-    QStringList usersOnline() const;
+    qsizetype usersOnlineCount() const;
+
+    /*!
+        Страница списка пользователей онлайн в порядке SessionID
+        @param offset - количество пропускаемых сессий
+        @param limit - максимальное количество сессий в результате
+        @param total - общее количество сессий
+    */
+    QStringList usersOnline(qsizetype offset, qsizetype limit, qsizetype& total) const;
 
 signals:
     /*!
@@ -90,23 +116,39 @@ private:
     UsersCore() = delete;
     Q_DISABLE_COPY_MOVE(UsersCore);
 
+    struct FilterDiff
+    {
+        qsizetype added = 0;
+        qsizetype removed = 0;
+        qsizetype kept = 0;     ///< фильтры без изменений
+    };
+
+    static FilterDiff diffFilters(const TradingCatCommon::UserConfig& oldConfig, const TradingCatCommon::UserConfig& newConfig);
+
     static qint64 getId();
+    static qsizetype historyKLinesCount(const TradingCatCommon::Detector::KLineDetectData& detectData);
 
 private:
     struct SessionData
     {
         QString user;
         QDateTime lastData = QDateTime::currentDateTime();        
-        TradingCatCommon::Detector::KLinesDetectedList klinesDetectedList;
+        DetectEvents detectEvents;  ///< неотданные события и время отдачи событий клиенту
+        std::map<quint64, TradingCatCommon::Detector::PKLineDetectData> detectHistory; ///< отданные без истории события по идентификатору
+        qsizetype detectHistoryKLines = 0; ///< количество свечей в detectHistory
     };
 
 private:
     const Common::DBConnectionInfo& _dbConnectionInfo;
-    const TradingCatCommon::TradingData& _tradingData;
+    const TradingDataSnapshot& _tradingData;
 
     Users* _users = nullptr; //данные пользователей
 
     std::unordered_map<qint64, SessionData> _onlineUsers;
+    quint64 _lastHistoryHandle = 0;
+
+    LatencyTracer* _latencyTracer = nullptr;
+    qint64 _detectCooldown = 0;
 
     QTimer* _connetionTimeoutTimer = nullptr;
 
@@ -0,0 +1,98 @@
+//Qt
+#include <QTest>
+#include <QSignalSpy>
+#include <QDateTime>
+#include <QElapsedTimer>
+
+//My
+#include "backfillpacer.h"
+#include "backfillpacertest.h"
+
+using namespace TradingCatCommon;
+
+static const qint64 MINUTE = 60 * 1000;
+static const qint64 START_TIME = 1700000100000; // давний пропуск
+static const QString SYMBOL = "BTCUSDT";
+static const StockExchangeID STOCK_EXCHANGE_ID("TEST");
+static const int WAIT_TIMEOUT = 5000;
+
+void BackfillPacerTest::adjacentRangesMerged()
+{
+    BackfillPacer pacer(STOCK_EXCHANGE_ID, 0);
+    QSignalSpy loadSpy(&pacer, &BackfillPacer::loadKLines);
+
+    const KLineID klineId(SYMBOL, KLineType::MIN1);
+    pacer.loadKLinesRequest(klineId, START_TIME, START_TIME + MINUTE);
+    pacer.loadKLinesRequest(klineId, START_TIME + 2 * MINUTE, START_TIME + 3 * MINUTE);
+    pacer.loadKLinesRequest(klineId, START_TIME + MINUTE, START_TIME + MINUTE);
+
+    QCOMPARE(pacer.metrics().pending, qsizetype(1));
+    QCOMPARE(pacer.metrics().merged, quint64(2));
+
+    pacer.start();
+
+    QTRY_COMPARE_WITH_TIMEOUT(loadSpy.count(), 1, WAIT_TIMEOUT);
+    QCOMPARE(loadSpy.first().at(1).toLongLong(), START_TIME);
+    QCOMPARE(loadSpy.first().at(2).toLongLong(), START_TIME + 3 * MINUTE);
+}
+
+void BackfillPacerTest::disjointRangesKeptSeparate()
+{
+    BackfillPacer pacer(STOCK_EXCHANGE_ID, 0);
+    QSignalSpy loadSpy(&pacer, &BackfillPacer::loadKLines);
+
+    const KLineID klineId(SYMBOL, KLineType::MIN1);
+    pacer.loadKLinesRequest(klineId, START_TIME, START_TIME);
+    pacer.loadKLinesRequest(klineId, START_TIME + 100 * MINUTE, START_TIME + 100 * MINUTE);
+
+    QCOMPARE(pacer.metrics().pending, qsizetype(2));
+    QCOMPARE(pacer.metrics().merged, quint64(0));
+
+    pacer.start();
+
+    QTRY_COMPARE_WITH_TIMEOUT(loadSpy.count(), 2, WAIT_TIMEOUT);
+
+    // более свежий пропуск - первым
+    QCOMPARE(loadSpy.at(0).at(1).toLongLong(), START_TIME + 100 * MINUTE);
+    QCOMPARE(loadSpy.at(0).at(2).toLongLong(), START_TIME + 100 * MINUTE);
+    QCOMPARE(loadSpy.at(1).at(1).toLongLong(), START_TIME);
+    QCOMPARE(loadSpy.at(1).at(2).toLongLong(), START_TIME);
+    QCOMPARE(pacer.metrics().sent, quint64(2));
+}
+
+void BackfillPacerTest::recentKLinesFirst()
+{
+    BackfillPacer pacer(STOCK_EXCHANGE_ID, 0);
+    QSignalSpy loadSpy(&pacer, &BackfillPacer::loadKLines);
+
+    // давний пропуск минутной свечи и только что закрытая 5-минутная свеча
+    const auto recentOpenTime = QDateTime::currentMSecsSinceEpoch() / (5 * MINUTE) * (5 * MINUTE) - 5 * MINUTE;
+    pacer.loadKLinesRequest(KLineID(SYMBOL, KLineType::MIN1), START_TIME, START_TIME);
+    pacer.loadKLinesRequest(KLineID(SYMBOL, KLineType::MIN5), recentOpenTime, recentOpenTime);
+
+    pacer.start();
+
+    QTRY_COMPARE_WITH_TIMEOUT(loadSpy.count(), 2, WAIT_TIMEOUT);
+    QCOMPARE(loadSpy.at(0).at(0).value<KLineID>(), KLineID(SYMBOL, KLineType::MIN5));
+    QCOMPARE(loadSpy.at(1).at(0).value<KLineID>(), KLineID(SYMBOL, KLineType::MIN1));
+}
+
+void BackfillPacerTest::requestsSpreadByLimit()
+{
+    // 600 запросов в минуту - один запрос в 100 мс
+    BackfillPacer pacer(STOCK_EXCHANGE_ID, 600);
+    QSignalSpy loadSpy(&pacer, &BackfillPacer::loadKLines);
+
+    for (qint64 i = 0; i < 3; ++i)
+    {
+        pacer.loadKLinesRequest(KLineID(SYMBOL, KLineType::MIN1), START_TIME + i * 100 * MINUTE, START_TIME + i * 100 * MINUTE);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    pacer.start();
+
+    QTRY_COMPARE_WITH_TIMEOUT(loadSpy.count(), 3, WAIT_TIMEOUT);
+    QVERIFY(timer.elapsed() >= 250); // с учетом погрешности таймера
+}
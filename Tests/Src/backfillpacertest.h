@@ -0,0 +1,20 @@
+#pragma once
+
+//Qt
+#include <QObject>
+
+///////////////////////////////////////////////////////////////////////////////
+///     The BackfillPacerTest class - тесты темпа запросов дозагрузки
+///
+class BackfillPacerTest final
+    : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void adjacentRangesMerged();
+    void disjointRangesKeptSeparate();
+    void recentKLinesFirst();
+    void requestsSpreadByLimit();
+
+};
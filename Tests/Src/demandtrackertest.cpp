@@ -0,0 +1,51 @@
+//Qt
+#include <QTest>
+#include <QSignalSpy>
+
+//My
+#include "demandtracker.h"
+#include "demandtrackertest.h"
+
+using namespace TradingCatCommon;
+
+static const QString FILTER_CONFIG = R"({"Filter":{"Filters":[{"Delta":500,"Volume":500}]}})";
+static const QString EMPTY_CONFIG = R"({"Filter":{"Filters":[]}})";
+
+void DemandTrackerTest::filtersCounted()
+{
+    QCOMPARE(DemandTracker::filtersCount(UserConfig(FILTER_CONFIG)), qsizetype(1));
+    QCOMPARE(DemandTracker::filtersCount(UserConfig(R"({"Filter":{"Filters":[{"Delta":500,"Volume":500},{"Delta":100,"Volume":100}]}})")), qsizetype(2));
+    QCOMPARE(DemandTracker::filtersCount(UserConfig(EMPTY_CONFIG)), qsizetype(0));
+}
+
+void DemandTrackerTest::demandFollowsSessionsWithFilters()
+{
+    DemandTracker tracker;
+    QSignalSpy demandSpy(&tracker, &DemandTracker::demandChanged);
+
+    QVERIFY(!tracker.isDemanded());
+
+    // сессия без фильтров спроса не создает
+    tracker.userOnline(1, UserConfig(EMPTY_CONFIG));
+    QCOMPARE(demandSpy.count(), 0);
+
+    tracker.userOnline(2, UserConfig(FILTER_CONFIG));
+    QCOMPARE(demandSpy.count(), 1);
+    QCOMPARE(demandSpy.last().at(0).toBool(), true);
+    QVERIFY(tracker.isDemanded());
+
+    // спрос меняется только при переходе через ноль сессий с фильтрами
+    tracker.userOnline(3, UserConfig(FILTER_CONFIG));
+    tracker.userOffline(2);
+    QCOMPARE(demandSpy.count(), 1);
+
+    // последняя сессия с фильтрами удалила их из конфигурации
+    tracker.userOnline(3, UserConfig(EMPTY_CONFIG));
+    QCOMPARE(demandSpy.count(), 2);
+    QCOMPARE(demandSpy.last().at(0).toBool(), false);
+
+    tracker.userOffline(1);
+    tracker.userOffline(3);
+    QCOMPARE(demandSpy.count(), 2);
+    QVERIFY(!tracker.isDemanded());
+}
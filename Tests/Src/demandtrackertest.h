@@ -0,0 +1,18 @@
+#pragma once
+
+//Qt
+#include <QObject>
+
+///////////////////////////////////////////////////////////////////////////////
+///     The DemandTrackerTest class - тесты спроса на свечи по сессиям онлайн
+///
+class DemandTrackerTest final
+    : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void filtersCounted();
+    void demandFollowsSessionsWithFilters();
+
+};
@@ -0,0 +1,98 @@
+//Qt
+#include <QTest>
+
+//My
+#include <TradingCatCommon/filter.h>
+
+#include "detectevents.h"
+#include "detecteventstest.h"
+
+using namespace TradingCatCommon;
+
+static const qint64 MINUTE = 60 * 1000;
+static const qint64 START_TIME = 1700000100000;
+static const qint64 COOLDOWN = 5 * MINUTE;
+static const StockExchangeID STOCK_EXCHANGE_ID("TEST");
+static const Filter::FilterType FILTER_TYPE = static_cast<Filter::FilterType>(1);
+
+static Detector::PKLineDetectData makeDetect(const QString& symbol, double close = 100.0)
+{
+    auto kline = std::make_shared<KLine>();
+    kline->id = KLineID(symbol, KLineType::MIN1);
+    kline->openTime = START_TIME;
+    kline->closeTime = START_TIME + MINUTE - 1;
+    kline->open = 100.0;
+    kline->high = close;
+    kline->low = 100.0;
+    kline->close = close;
+    kline->volume = 1.0;
+    kline->quoteAssetVolume = close;
+
+    auto result = std::make_shared<Detector::KLineDetectData>();
+    result->stockExchangeId = STOCK_EXCHANGE_ID;
+    result->history = std::make_shared<KLinesList>();
+    result->history->push_back(kline);
+    result->reviewHistory = std::make_shared<KLinesList>();
+    result->reviewHistory->push_back(kline);
+    result->filterActivate = FILTER_TYPE;
+
+    return result;
+}
+
+void DetectEventsTest::replacedBeforeDelivery()
+{
+    DetectEvents events;
+
+    QCOMPARE(events.add(makeDetect("BTCUSDT"), COOLDOWN, START_TIME), DetectEvents::AddResult::ADDED);
+
+    const auto fresh = makeDetect("BTCUSDT", 110.0);
+    QCOMPARE(events.add(fresh, COOLDOWN, START_TIME + 1000), DetectEvents::AddResult::REPLACED);
+
+    QCOMPARE(events.klinesDetectedList().detected.size(), std::size_t(1));
+    QCOMPARE(events.klinesDetectedList().detected.front(), fresh);
+
+    QCOMPARE(events.add(makeDetect("ETHUSDT"), COOLDOWN, START_TIME + 1000), DetectEvents::AddResult::ADDED);
+    QCOMPARE(events.klinesDetectedList().detected.size(), std::size_t(2));
+}
+
+void DetectEventsTest::suppressedWithinCooldown()
+{
+    DetectEvents events;
+
+    QCOMPARE(events.add(makeDetect("BTCUSDT"), COOLDOWN, START_TIME), DetectEvents::AddResult::ADDED);
+    events.delivered(START_TIME);
+    QVERIFY(events.klinesDetectedList().detected.empty());
+
+    // cooldown отсчитывается от отдачи события клиенту
+    QCOMPARE(events.add(makeDetect("BTCUSDT"), COOLDOWN, START_TIME + COOLDOWN - 1), DetectEvents::AddResult::SUPPRESSED);
+    QCOMPARE(events.add(makeDetect("ETHUSDT"), COOLDOWN, START_TIME + 1000), DetectEvents::AddResult::ADDED);
+
+    events.expire(COOLDOWN, START_TIME + COOLDOWN);
+    QCOMPARE(events.add(makeDetect("BTCUSDT"), COOLDOWN, START_TIME + COOLDOWN), DetectEvents::AddResult::ADDED);
+}
+
+void DetectEventsTest::noCooldownByDefault()
+{
+    DetectEvents events;
+
+    QCOMPARE(events.add(makeDetect("BTCUSDT"), 0, START_TIME), DetectEvents::AddResult::ADDED);
+    events.delivered(START_TIME);
+
+    QCOMPARE(events.add(makeDetect("BTCUSDT"), 0, START_TIME), DetectEvents::AddResult::ADDED);
+}
+
+void DetectEventsTest::fullList()
+{
+    DetectEvents events;
+
+    for (qsizetype i = 0; i <= DetectEvents::MAX_EVENTS; ++i)
+    {
+        QCOMPARE(events.add(makeDetect(QString("SYMBOL%1").arg(i)), 0, START_TIME), DetectEvents::AddResult::ADDED);
+    }
+
+    QCOMPARE(events.add(makeDetect("BTCUSDT"), 0, START_TIME), DetectEvents::AddResult::FULL);
+    QVERIFY(events.klinesDetectedList().isFull);
+
+    // замена неотданного события возможна и при заполненном списке
+    QCOMPARE(events.add(makeDetect("SYMBOL0"), 0, START_TIME), DetectEvents::AddResult::REPLACED);
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+//Qt
+#include <QObject>
+
+///////////////////////////////////////////////////////////////////////////////
+///     The DetectEventsTest class - тесты замены и подавления повторных событий детектора
+///
+class DetectEventsTest final
+    : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void replacedBeforeDelivery();
+    void suppressedWithinCooldown();
+    void noCooldownByDefault();
+    void fullList();
+
+};
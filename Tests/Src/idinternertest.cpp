@@ -0,0 +1,92 @@
+//STL
+#include <vector>
+
+//Qt
+#include <QTest>
+#include <QThread>
+
+//My
+#include "idinterner.h"
+#include "idinternertest.h"
+
+using namespace TradingCatCommon;
+
+void IDInternerTest::klinesListInterned()
+{
+    const auto stockExchangeIndex = IDInterner::stockExchange(StockExchangeID("INTERNER_LIST"));
+    QCOMPARE(IDInterner::findStockExchange(StockExchangeID("INTERNER_LIST")), stockExchangeIndex);
+
+    KLinesIDList klinesIdList;
+    klinesIdList.emplace("BTCUSDT", KLineType::MIN1);
+    klinesIdList.emplace("ETHUSDT", KLineType::MIN1);
+    klinesIdList.emplace("BTCUSDT", KLineType::MIN5);
+
+    QCOMPARE(IDInterner::findKLine(stockExchangeIndex, KLineID("BTCUSDT", KLineType::MIN1)), IDInterner::NO_INDEX);
+
+    IDInterner::klines(stockExchangeIndex, klinesIdList);
+    QCOMPARE(IDInterner::klinesCount(stockExchangeIndex), qsizetype(3));
+
+    // индексы плотные и не меняются при повторном списке
+    std::vector<bool> isUsed(3, false);
+    for (const auto& klineId: klinesIdList)
+    {
+        const auto index = IDInterner::findKLine(stockExchangeIndex, klineId);
+        QVERIFY(index < 3);
+        QVERIFY(!isUsed[index]);
+        isUsed[index] = true;
+
+        QCOMPARE(IDInterner::klineId(stockExchangeIndex, index), klineId);
+    }
+
+    const auto index = IDInterner::findKLine(stockExchangeIndex, KLineID("ETHUSDT", KLineType::MIN1));
+    IDInterner::klines(stockExchangeIndex, klinesIdList);
+    QCOMPARE(IDInterner::klinesCount(stockExchangeIndex), qsizetype(3));
+    QCOMPARE(IDInterner::kline(stockExchangeIndex, KLineID("ETHUSDT", KLineType::MIN1)), index);
+}
+
+void IDInternerTest::singleKLineInterned()
+{
+    const auto stockExchangeIndex = IDInterner::stockExchange(StockExchangeID("INTERNER_SINGLE"));
+
+    const auto index = IDInterner::kline(stockExchangeIndex, KLineID("BTCUSDT", KLineType::MIN1));
+    QCOMPARE(index, quint32(0));
+    QCOMPARE(IDInterner::kline(stockExchangeIndex, KLineID("BTCUSDT", KLineType::MIN1)), index);
+    QCOMPARE(IDInterner::kline(stockExchangeIndex, KLineID("ETHUSDT", KLineType::MIN1)), quint32(1));
+
+    // индексы свечей назначаются отдельно для каждой биржи
+    const auto otherStockExchangeIndex = IDInterner::stockExchange(StockExchangeID("INTERNER_OTHER"));
+    QVERIFY(otherStockExchangeIndex != stockExchangeIndex);
+    QCOMPARE(IDInterner::findKLine(otherStockExchangeIndex, KLineID("BTCUSDT", KLineType::MIN1)), IDInterner::NO_INDEX);
+    QCOMPARE(IDInterner::findKLine(IDInterner::NO_INDEX, KLineID("BTCUSDT", KLineType::MIN1)), IDInterner::NO_INDEX);
+}
+
+void IDInternerTest::indexVisibleInOtherThread()
+{
+    const auto stockExchangeIndex = IDInterner::stockExchange(StockExchangeID("INTERNER_THREAD"));
+
+    // поток сохраняет копию таблицы до добавления ID
+    quint32 indexBefore = 0;
+    quint32 indexAfter = 0;
+    QThread* thread = QThread::create(
+        [stockExchangeIndex, &indexBefore]()
+        {
+            indexBefore = IDInterner::findKLine(stockExchangeIndex, KLineID("BTCUSDT", KLineType::MIN1));
+        });
+    thread->start();
+    QVERIFY(thread->wait());
+    delete thread;
+
+    const auto index = IDInterner::kline(stockExchangeIndex, KLineID("BTCUSDT", KLineType::MIN1));
+
+    thread = QThread::create(
+        [stockExchangeIndex, &indexAfter]()
+        {
+            indexAfter = IDInterner::findKLine(stockExchangeIndex, KLineID("BTCUSDT", KLineType::MIN1));
+        });
+    thread->start();
+    QVERIFY(thread->wait());
+    delete thread;
+
+    QCOMPARE(indexBefore, IDInterner::NO_INDEX);
+    QCOMPARE(indexAfter, index);
+}
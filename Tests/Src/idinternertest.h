@@ -0,0 +1,19 @@
+#pragma once
+
+//Qt
+#include <QObject>
+
+///////////////////////////////////////////////////////////////////////////////
+///     The IDInternerTest class - тесты назначения индексов ID бирж и свечей
+///
+class IDInternerTest final
+    : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void klinesListInterned();
+    void singleKLineInterned();
+    void indexVisibleInOtherThread();
+
+};
@@ -0,0 +1,129 @@
+//Qt
+#include <QTest>
+
+//My
+#include "jsontokenizer.h"
+#include "jsontokenizertest.h"
+
+using Token = JsonTokenizer::Token;
+
+void JsonTokenizerTest::tokens()
+{
+    JsonTokenizer tokenizer(R"({"a": 1, "b": [true, false, null], "c": "x", "d": {}})");
+
+    QCOMPARE(tokenizer.next(), Token::BEGIN_OBJECT);
+    QCOMPARE(tokenizer.next(), Token::KEY);
+    QCOMPARE(tokenizer.text(), QByteArrayView("a"));
+    QCOMPARE(tokenizer.next(), Token::NUMBER);
+    QCOMPARE(tokenizer.text(), QByteArrayView("1"));
+    QCOMPARE(tokenizer.next(), Token::KEY);
+    QCOMPARE(tokenizer.text(), QByteArrayView("b"));
+    QCOMPARE(tokenizer.next(), Token::BEGIN_ARRAY);
+    QCOMPARE(tokenizer.next(), Token::TRUE_VALUE);
+    QCOMPARE(tokenizer.next(), Token::FALSE_VALUE);
+    QCOMPARE(tokenizer.next(), Token::NULL_VALUE);
+    QCOMPARE(tokenizer.next(), Token::END_ARRAY);
+    QCOMPARE(tokenizer.next(), Token::KEY);
+    QCOMPARE(tokenizer.text(), QByteArrayView("c"));
+    QCOMPARE(tokenizer.next(), Token::STRING);
+    QCOMPARE(tokenizer.text(), QByteArrayView("x"));
+    QVERIFY(!tokenizer.isEscaped());
+    QCOMPARE(tokenizer.next(), Token::KEY);
+    QCOMPARE(tokenizer.text(), QByteArrayView("d"));
+    QCOMPARE(tokenizer.next(), Token::BEGIN_OBJECT);
+    QCOMPARE(tokenizer.next(), Token::END_OBJECT);
+    QCOMPARE(tokenizer.next(), Token::END_OBJECT);
+    QCOMPARE(tokenizer.next(), Token::END);
+}
+
+void JsonTokenizerTest::escapedString()
+{
+    // строка возвращается без декодирования escape-последовательностей
+    JsonTokenizer tokenizer(R"({"s": "a\"b\\", "t": "c"})");
+
+    QCOMPARE(tokenizer.next(), Token::BEGIN_OBJECT);
+    QCOMPARE(tokenizer.next(), Token::KEY);
+    QCOMPARE(tokenizer.next(), Token::STRING);
+    QCOMPARE(tokenizer.text(), QByteArrayView(R"(a\"b\\)"));
+    QVERIFY(tokenizer.isEscaped());
+    QCOMPARE(tokenizer.next(), Token::KEY);
+    QCOMPARE(tokenizer.text(), QByteArrayView("t"));
+    QCOMPARE(tokenizer.next(), Token::STRING);
+    QVERIFY(!tokenizer.isEscaped());
+    QCOMPARE(tokenizer.next(), Token::END_OBJECT);
+    QCOMPARE(tokenizer.next(), Token::END);
+}
+
+void JsonTokenizerTest::skipValue()
+{
+    JsonTokenizer tokenizer(R"({"skip": {"x": [1, {"y": "}"}], "z": null}, "scalar": "v", "n": 2})");
+
+    QCOMPARE(tokenizer.next(), Token::BEGIN_OBJECT);
+    QCOMPARE(tokenizer.next(), Token::KEY);
+    QCOMPARE(tokenizer.text(), QByteArrayView("skip"));
+    QVERIFY(tokenizer.skipValue());
+    QCOMPARE(tokenizer.next(), Token::KEY);
+    QCOMPARE(tokenizer.text(), QByteArrayView("scalar"));
+    QVERIFY(tokenizer.skipValue());
+    QCOMPARE(tokenizer.next(), Token::KEY);
+    QCOMPARE(tokenizer.text(), QByteArrayView("n"));
+    QCOMPARE(tokenizer.next(), Token::NUMBER);
+    QCOMPARE(tokenizer.next(), Token::END_OBJECT);
+    QCOMPARE(tokenizer.next(), Token::END);
+}
+
+void JsonTokenizerTest::numbers()
+{
+    JsonTokenizer tokenizer(R"([-1.5e3, 1700000100000, "0.00012345", "abc"])");
+
+    QCOMPARE(tokenizer.next(), Token::BEGIN_ARRAY);
+
+    double doubleValue = 0.0;
+    qint64 intValue = 0;
+
+    QCOMPARE(tokenizer.next(), Token::NUMBER);
+    QVERIFY(tokenizer.toDouble(doubleValue));
+    QCOMPARE(doubleValue, -1500.0);
+    QVERIFY(!tokenizer.toInt64(intValue));
+
+    QCOMPARE(tokenizer.next(), Token::NUMBER);
+    QVERIFY(tokenizer.toInt64(intValue));
+    QCOMPARE(intValue, Q_INT64_C(1700000100000));
+
+    // цены бирж передаются строками
+    QCOMPARE(tokenizer.next(), Token::STRING);
+    QVERIFY(tokenizer.toDouble(doubleValue));
+    QCOMPARE(doubleValue, 0.00012345);
+
+    QCOMPARE(tokenizer.next(), Token::STRING);
+    QVERIFY(!tokenizer.toDouble(doubleValue));
+
+    QCOMPARE(tokenizer.next(), Token::END_ARRAY);
+    QCOMPARE(tokenizer.next(), Token::END);
+}
+
+void JsonTokenizerTest::incorrectJson_data()
+{
+    QTest::addColumn<QByteArray>("json");
+
+    QTest::newRow("mismatched brackets") << QByteArray(R"({"a": 1])");
+    QTest::newRow("unterminated object") << QByteArray(R"({"a": 1)");
+    QTest::newRow("unterminated string") << QByteArray(R"({"a": "x)");
+    QTest::newRow("incorrect literal") << QByteArray(R"({"a": tru})");
+    QTest::newRow("unexpected symbol") << QByteArray(R"({"a": #})");
+}
+
+void JsonTokenizerTest::incorrectJson()
+{
+    QFETCH(QByteArray, json);
+
+    JsonTokenizer tokenizer(json);
+
+    auto token = tokenizer.next();
+    while (token != Token::END && token != Token::ERROR)
+    {
+        token = tokenizer.next();
+    }
+
+    QCOMPARE(token, Token::ERROR);
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+//Qt
+#include <QObject>
+
+///////////////////////////////////////////////////////////////////////////////
+///     The JsonTokenizerTest class - тесты последовательного чтения JSON
+///
+class JsonTokenizerTest final
+    : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void tokens();
+    void escapedString();
+    void skipValue();
+    void numbers();
+    void incorrectJson_data();
+    void incorrectJson();
+
+};
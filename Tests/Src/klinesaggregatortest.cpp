@@ -0,0 +1,217 @@
+//STL
+#include <algorithm>
+
+//Qt
+#include <QTest>
+#include <QSignalSpy>
+
+//My
+#include "klinesaggregator.h"
+#include "klinesaggregatortest.h"
+
+using namespace TradingCatCommon;
+
+static const qint64 MINUTE = 60 * 1000;
+static const qint64 START_TIME = 1700000100000; // начало 5-минутного интервала в прошлом
+static const QString SYMBOL = "BTCUSDT";
+
+static PKLinesList makeMinute(qint64 openTime, double price, double volume)
+{
+    auto kline = std::make_shared<KLine>();
+    kline->id = KLineID(SYMBOL, KLineType::MIN1);
+    kline->openTime = openTime;
+    kline->closeTime = openTime + MINUTE - 1;
+    kline->open = price;
+    kline->high = price + 1.0;
+    kline->low = price - 1.0;
+    kline->close = price;
+    kline->volume = volume;
+    kline->quoteAssetVolume = volume * price;
+
+    auto result = std::make_shared<KLinesList>();
+    result->push_back(kline);
+
+    return result;
+}
+
+static PKLinesList join(const PKLinesList& first, const PKLinesList& second)
+{
+    auto result = std::make_shared<KLinesList>(*first);
+    result->insert(result->end(), second->begin(), second->end());
+
+    return result;
+}
+
+static PKLinesList lastKLines(const QSignalSpy& spy)
+{
+    return spy.last().at(1).value<PKLinesList>();
+}
+
+static qsizetype countKLines(const PKLinesList& klines, KLineType type)
+{
+    return std::count_if(klines->begin(), klines->end(), [type](const auto& kline) { return kline->id.type == type; });
+}
+
+void KLinesAggregatorTest::historyRequestedOnStart()
+{
+    KLinesAggregator aggregator({KLineType::MIN1, KLineType::MIN5, KLineType::MIN15});
+    QSignalSpy requestSpy(&aggregator, &KLinesAggregator::loadKLinesRequest);
+
+    // один запрос минутных свечей от начала самого длинного интервала
+    const auto openTime15 = KLinesAggregator::intervalOpenTime(START_TIME, KLineType::MIN15);
+    aggregator.addKLines(StockExchangeID("TEST"), makeMinute(START_TIME + 2 * MINUTE, 100.0, 1.0));
+
+    QCOMPARE(requestSpy.count(), 1);
+    QCOMPARE(requestSpy.first().at(0).value<KLineID>(), KLineID(SYMBOL, KLineType::MIN1));
+    QCOMPARE(requestSpy.first().at(1).toLongLong(), openTime15);
+    QCOMPARE(requestSpy.first().at(2).toLongLong(), START_TIME + MINUTE);
+
+    // первая свеча в начале всех интервалов - истории не требуется
+    KLinesAggregator alignedAggregator({KLineType::MIN1, KLineType::MIN5});
+    QSignalSpy alignedRequestSpy(&alignedAggregator, &KLinesAggregator::loadKLinesRequest);
+
+    alignedAggregator.addKLines(StockExchangeID("TEST"), makeMinute(START_TIME, 100.0, 1.0));
+
+    QCOMPARE(alignedRequestSpy.count(), 0);
+}
+
+void KLinesAggregatorTest::completeKLineEmittedOnce()
+{
+    KLinesAggregator aggregator({KLineType::MIN1, KLineType::MIN5});
+    QSignalSpy klinesSpy(&aggregator, &KLinesAggregator::getKLines);
+    QSignalSpy requestSpy(&aggregator, &KLinesAggregator::loadKLinesRequest);
+
+    for (qint64 i = 0; i < 4; ++i)
+    {
+        aggregator.addKLines(StockExchangeID("TEST"), makeMinute(START_TIME + i * MINUTE, 100.0 + i, 1.0));
+
+        QCOMPARE(countKLines(lastKLines(klinesSpy), KLineType::MIN5), 0);
+    }
+
+    aggregator.addKLines(StockExchangeID("TEST"), makeMinute(START_TIME + 4 * MINUTE, 104.0, 1.0));
+
+    const auto klines = lastKLines(klinesSpy);
+    QCOMPARE(klines->size(), std::size_t(2));
+    QCOMPARE(klines->front()->id.type, KLineType::MIN1);
+
+    const auto& kline = klines->back();
+    QCOMPARE(kline->id, KLineID(SYMBOL, KLineType::MIN5));
+    QCOMPARE(kline->openTime, START_TIME);
+    QCOMPARE(kline->closeTime, START_TIME + 5 * MINUTE - 1);
+    QCOMPARE(kline->open, 100.0);
+    QCOMPARE(kline->close, 104.0);
+    QCOMPARE(kline->high, 105.0);
+    QCOMPARE(kline->low, 99.0);
+    QCOMPARE(kline->volume, 5.0);
+
+    // повторная закрытая минутная свеча не порождает свечу повторно
+    aggregator.addKLines(StockExchangeID("TEST"), makeMinute(START_TIME + 4 * MINUTE, 104.0, 1.0));
+    QCOMPARE(countKLines(lastKLines(klinesSpy), KLineType::MIN5), 0);
+
+    // свеча полная - запросов нет
+    QCOMPARE(requestSpy.count(), 0);
+}
+
+void KLinesAggregatorTest::historyCompletesFirstKLine()
+{
+    KLinesAggregator aggregator({KLineType::MIN1, KLineType::MIN5});
+    QSignalSpy klinesSpy(&aggregator, &KLinesAggregator::getKLines);
+    QSignalSpy requestSpy(&aggregator, &KLinesAggregator::loadKLinesRequest);
+
+    aggregator.addKLines(StockExchangeID("TEST"), makeMinute(START_TIME + 2 * MINUTE, 102.0, 1.0));
+    aggregator.addKLines(StockExchangeID("TEST"), makeMinute(START_TIME + 3 * MINUTE, 103.0, 1.0));
+
+    // ответ на запрос истории
+    aggregator.addKLines(StockExchangeID("TEST"), join(makeMinute(START_TIME, 90.0, 1.0), makeMinute(START_TIME + MINUTE, 101.0, 1.0)));
+
+    aggregator.addKLines(StockExchangeID("TEST"), makeMinute(START_TIME + 4 * MINUTE, 104.0, 1.0));
+
+    const auto klines = lastKLines(klinesSpy);
+    QCOMPARE(countKLines(klines, KLineType::MIN5), 1);
+
+    const auto& kline = klines->back();
+    QCOMPARE(kline->openTime, START_TIME);
+    QCOMPARE(kline->open, 90.0);
+    QCOMPARE(kline->close, 104.0);
+    QCOMPARE(kline->high, 105.0);
+    QCOMPARE(kline->low, 89.0);
+    QCOMPARE(kline->volume, 5.0);
+
+    // только запрос истории
+    QCOMPARE(requestSpy.count(), 1);
+}
+
+void KLinesAggregatorTest::partialFirstKLineEmitted()
+{
+    KLinesAggregator aggregator({KLineType::MIN1, KLineType::MIN5});
+    QSignalSpy klinesSpy(&aggregator, &KLinesAggregator::getKLines);
+    QSignalSpy requestSpy(&aggregator, &KLinesAggregator::loadKLinesRequest);
+
+    for (qint64 i = 2; i < 4; ++i)
+    {
+        aggregator.addKLines(StockExchangeID("TEST"), makeMinute(START_TIME + i * MINUTE, 100.0, 1.0));
+
+        QCOMPARE(countKLines(lastKLines(klinesSpy), KLineType::MIN5), 0);
+    }
+
+    // история не получена - свеча строится по имеющимся минутным свечам и запрашивается с биржи
+    aggregator.addKLines(StockExchangeID("TEST"), makeMinute(START_TIME + 4 * MINUTE, 100.0, 1.0));
+
+    const auto klines = lastKLines(klinesSpy);
+    QCOMPARE(countKLines(klines, KLineType::MIN5), 1);
+    QCOMPARE(klines->back()->openTime, START_TIME);
+    QCOMPARE(klines->back()->volume, 3.0);
+
+    QCOMPARE(requestSpy.count(), 2);
+    QCOMPARE(requestSpy.last().at(0).value<KLineID>(), KLineID(SYMBOL, KLineType::MIN5));
+    QCOMPARE(requestSpy.last().at(1).toLongLong(), START_TIME);
+    QCOMPARE(requestSpy.last().at(2).toLongLong(), START_TIME);
+
+    // следующий интервал начат с первой минуты и строится полностью
+    for (qint64 i = 5; i < 10; ++i)
+    {
+        aggregator.addKLines(StockExchangeID("TEST"), makeMinute(START_TIME + i * MINUTE, 100.0, 1.0));
+    }
+
+    QCOMPARE(countKLines(lastKLines(klinesSpy), KLineType::MIN5), 1);
+    QCOMPARE(requestSpy.count(), 2);
+}
+
+void KLinesAggregatorTest::missedMinuteKLineEmitted()
+{
+    KLinesAggregator aggregator({KLineType::MIN1, KLineType::MIN5});
+    QSignalSpy klinesSpy(&aggregator, &KLinesAggregator::getKLines);
+    QSignalSpy requestSpy(&aggregator, &KLinesAggregator::loadKLinesRequest);
+
+    for (const qint64 i: {0, 1, 3})
+    {
+        aggregator.addKLines(StockExchangeID("TEST"), makeMinute(START_TIME + i * MINUTE, 100.0, 1.0));
+    }
+
+    // последняя минутная свеча интервала пропущена - свеча завершается первой минутой следующего интервала
+    aggregator.addKLines(StockExchangeID("TEST"), makeMinute(START_TIME + 5 * MINUTE, 100.0, 1.0));
+
+    const auto klines = lastKLines(klinesSpy);
+    QCOMPARE(countKLines(klines, KLineType::MIN5), 1);
+    QCOMPARE(klines->back()->openTime, START_TIME);
+    QCOMPARE(klines->back()->volume, 3.0);
+
+    QCOMPARE(requestSpy.count(), 1);
+    QCOMPARE(requestSpy.last().at(0).value<KLineID>(), KLineID(SYMBOL, KLineType::MIN5));
+    QCOMPARE(requestSpy.last().at(1).toLongLong(), START_TIME);
+}
+
+void KLinesAggregatorTest::stockExchangeKLinesPassed()
+{
+    KLinesAggregator aggregator({KLineType::MIN1, KLineType::MIN5});
+    QSignalSpy klinesSpy(&aggregator, &KLinesAggregator::getKLines);
+
+    auto klines = makeMinute(START_TIME, 100.0, 1.0);
+    klines->front()->id = KLineID(SYMBOL, KLineType::MIN5);
+    klines->front()->closeTime = START_TIME + 5 * MINUTE - 1;
+
+    aggregator.addKLines(StockExchangeID("TEST"), klines);
+
+    QCOMPARE(klinesSpy.count(), 1);
+    QCOMPARE(lastKLines(klinesSpy), klines);
+}
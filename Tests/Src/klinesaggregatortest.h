@@ -0,0 +1,22 @@
+#pragma once
+
+//Qt
+#include <QObject>
+
+///////////////////////////////////////////////////////////////////////////////
+///     The KLinesAggregatorTest class - тесты построения свечей старших интервалов
+///
+class KLinesAggregatorTest final
+    : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void historyRequestedOnStart();
+    void completeKLineEmittedOnce();
+    void historyCompletesFirstKLine();
+    void partialFirstKLineEmitted();
+    void missedMinuteKLineEmitted();
+    void stockExchangeKLinesPassed();
+
+};
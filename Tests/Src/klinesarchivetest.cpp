@@ -0,0 +1,192 @@
+//STL
+#include <cstring>
+
+//Qt
+#include <QTest>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QDir>
+#include <QDateTime>
+
+//My
+#include "klinesarchive.h"
+#include "klinesarchivetest.h"
+
+using namespace TradingCatCommon;
+
+static const qint64 MINUTE = 60 * 1000;
+static const qint64 START_TIME = 1700000100000; // закрытые свечи в прошлом
+static const qint64 RECORD_SIZE = 64;
+static const QString SYMBOL = "BTCUSDT";
+static const StockExchangeID STOCK_EXCHANGE_ID("TEST");
+
+static PKLinesList makeMinutes(qint64 openTime, qsizetype count)
+{
+    auto result = std::make_shared<KLinesList>();
+    for (qsizetype i = 0; i < count; ++i)
+    {
+        auto kline = std::make_shared<KLine>();
+        kline->id = KLineID(SYMBOL, KLineType::MIN1);
+        kline->openTime = openTime + i * MINUTE;
+        kline->closeTime = kline->openTime + MINUTE - 1;
+        kline->open = 100.0 + i;
+        kline->high = 101.0 + i;
+        kline->low = 99.0 + i;
+        kline->close = 100.5 + i;
+        kline->volume = 10.0 + i;
+        kline->quoteAssetVolume = 1000.0 + i;
+
+        result->push_back(kline);
+    }
+
+    return result;
+}
+
+static StockExchangesIDList stockExchangesIdList()
+{
+    StockExchangesIDList result;
+    result.emplace(STOCK_EXCHANGE_ID);
+
+    return result;
+}
+
+static QString segmentFileName(const QTemporaryDir& dir, quint32 number)
+{
+    return QDir(dir.filePath(STOCK_EXCHANGE_ID.name)).absoluteFilePath(QString("%1_%2.seg").arg(MINUTE).arg(number));
+}
+
+static QByteArray readFile(const QString& fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return {};
+    }
+
+    return file.readAll();
+}
+
+template <typename T>
+static T field(const QByteArray& data, qint64 offset)
+{
+    T result;
+    std::memcpy(&result, data.constData() + offset, sizeof(T));
+
+    return result;
+}
+
+void KLinesArchiveTest::segmentFormat()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    KLinesArchive archive(dir.path(), stockExchangesIdList(), 10);
+    archive.start();
+    archive.addKLines(STOCK_EXCHANGE_ID, makeMinutes(START_TIME, 2));
+    archive.stop();
+
+    const auto symbols = readFile(QDir(dir.filePath(STOCK_EXCHANGE_ID.name)).absoluteFilePath("symbols.idx"));
+    QCOMPARE(symbols, QByteArray("BTCUSDT\n"));
+
+    const auto segment = readFile(segmentFileName(dir, 0));
+    QCOMPARE(segment.size(), qsizetype(2 * RECORD_SIZE));
+
+    // запись: openTime, open, high, low, close, volume, quoteAssetVolume, индекс инструмента, резерв
+    QCOMPARE(field<qint64>(segment, 0), START_TIME);
+    QCOMPARE(field<double>(segment, 8), 100.0);
+    QCOMPARE(field<double>(segment, 16), 101.0);
+    QCOMPARE(field<double>(segment, 24), 99.0);
+    QCOMPARE(field<double>(segment, 32), 100.5);
+    QCOMPARE(field<double>(segment, 40), 10.0);
+    QCOMPARE(field<double>(segment, 48), 1000.0);
+    QCOMPARE(field<quint32>(segment, 56), quint32(0));
+
+    QCOMPARE(field<qint64>(segment, RECORD_SIZE), START_TIME + MINUTE);
+}
+
+void KLinesArchiveTest::openAndOldKLinesSkipped()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    KLinesArchive archive(dir.path(), stockExchangesIdList(), 10);
+    archive.start();
+    archive.addKLines(STOCK_EXCHANGE_ID, makeMinutes(START_TIME, 3));
+
+    // повтор и обновление уже записанных свечей
+    archive.addKLines(STOCK_EXCHANGE_ID, makeMinutes(START_TIME + MINUTE, 2));
+
+    // незакрытая свеча
+    auto openKLine = makeMinutes(START_TIME + 3 * MINUTE, 1);
+    openKLine->front()->closeTime = QDateTime::currentMSecsSinceEpoch() + MINUTE;
+    archive.addKLines(STOCK_EXCHANGE_ID, openKLine);
+
+    archive.stop();
+
+    QCOMPARE(readFile(segmentFileName(dir, 0)).size(), qsizetype(3 * RECORD_SIZE));
+}
+
+void KLinesArchiveTest::segmentRollover()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    // 9 записей по 2 в сегменте: сегменты 0-4, хранятся последние 3
+    KLinesArchive archive(dir.path(), stockExchangesIdList(), 10, 2);
+    archive.start();
+    archive.addKLines(STOCK_EXCHANGE_ID, makeMinutes(START_TIME, 9));
+    archive.stop();
+
+    QVERIFY(!QFile::exists(segmentFileName(dir, 0)));
+    QVERIFY(!QFile::exists(segmentFileName(dir, 1)));
+
+    const auto segment2 = readFile(segmentFileName(dir, 2));
+    QCOMPARE(segment2.size(), qsizetype(2 * RECORD_SIZE));
+    QCOMPARE(field<qint64>(segment2, 0), START_TIME + 4 * MINUTE);
+
+    QCOMPARE(readFile(segmentFileName(dir, 3)).size(), qsizetype(2 * RECORD_SIZE));
+
+    const auto segment4 = readFile(segmentFileName(dir, 4));
+    QCOMPARE(segment4.size(), qsizetype(RECORD_SIZE));
+    QCOMPARE(field<qint64>(segment4, 0), START_TIME + 8 * MINUTE);
+}
+
+void KLinesArchiveTest::lastKLinesLoaded()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    {
+        KLinesArchive archive(dir.path(), stockExchangesIdList(), 10, 2);
+        archive.start();
+        archive.addKLines(STOCK_EXCHANGE_ID, makeMinutes(START_TIME, 9));
+        archive.stop();
+    }
+
+    KLinesArchive archive(dir.path(), stockExchangesIdList(), 3, 2);
+    QSignalSpy klinesIdSpy(&archive, &KLinesArchive::getKLinesID);
+    QSignalSpy klinesSpy(&archive, &KLinesArchive::getKLines);
+
+    archive.start();
+
+    QCOMPARE(klinesIdSpy.count(), 1);
+    const auto klinesIdList = klinesIdSpy.first().at(1).value<PKLinesIDList>();
+    QCOMPARE(klinesIdList->size(), std::size_t(1));
+    QVERIFY(klinesIdList->contains(KLineID(SYMBOL, KLineType::MIN1)));
+
+    QCOMPARE(klinesSpy.count(), 1);
+    const auto klines = klinesSpy.first().at(1).value<PKLinesList>();
+    QCOMPARE(klines->size(), std::size_t(3));
+    QCOMPARE(klines->front()->openTime, START_TIME + 6 * MINUTE);
+    QCOMPARE(klines->front()->closeTime, START_TIME + 7 * MINUTE - 1);
+    QCOMPARE(klines->front()->open, 106.0);
+    QCOMPARE(klines->back()->openTime, START_TIME + 8 * MINUTE);
+    QCOMPARE(klines->back()->quoteAssetVolume, 1008.0);
+
+    // уже записанные свечи после перезапуска не дублируются
+    archive.addKLines(STOCK_EXCHANGE_ID, makeMinutes(START_TIME + 8 * MINUTE, 1));
+    archive.stop();
+
+    QCOMPARE(readFile(segmentFileName(dir, 4)).size(), qsizetype(RECORD_SIZE));
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+//Qt
+#include <QObject>
+
+///////////////////////////////////////////////////////////////////////////////
+///     The KLinesArchiveTest class - тесты формата сегментов и смены сегментов архива свечей
+///
+class KLinesArchiveTest final
+    : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void segmentFormat();
+    void openAndOldKLinesSkipped();
+    void segmentRollover();
+    void lastKLinesLoaded();
+
+};
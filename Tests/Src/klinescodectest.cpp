@@ -0,0 +1,116 @@
+//STL
+#include <vector>
+
+//Qt
+#include <QTest>
+
+//My
+#include "klinescodec.h"
+#include "klinescodectest.h"
+
+static const qint64 MINUTE = 60 * 1000;
+static const qint64 START_TIME = 1700000100000;
+
+static KLinesBlock::KLineView makeKLine(qint64 openTime, double price, double volume)
+{
+    KLinesBlock::KLineView kline;
+    kline.openTime = openTime;
+    kline.closeTime = openTime + MINUTE - 1;
+    kline.open = price;
+    kline.high = price * 1.01;
+    kline.low = price * 0.99;
+    kline.close = price + 0.125;
+    kline.volume = volume;
+    kline.quoteAssetVolume = volume * price;
+
+    return kline;
+}
+
+static std::vector<KLinesBlock::KLineView> decode(const KLinesBlock& block, qint64 from, qint64 to)
+{
+    std::vector<KLinesBlock::KLineView> result;
+    block.forEach(from, to, [&result](const KLinesBlock::KLineView& kline) { result.push_back(kline); });
+
+    return result;
+}
+
+static void compareKLines(const KLinesBlock::KLineView& actual, const KLinesBlock::KLineView& expected)
+{
+    QCOMPARE(actual.openTime, expected.openTime);
+    QCOMPARE(actual.closeTime, expected.closeTime);
+    QCOMPARE(actual.open, expected.open);
+    QCOMPARE(actual.high, expected.high);
+    QCOMPARE(actual.low, expected.low);
+    QCOMPARE(actual.close, expected.close);
+    QCOMPARE(actual.volume, expected.volume);
+    QCOMPARE(actual.quoteAssetVolume, expected.quoteAssetVolume);
+}
+
+void KLinesCodecTest::roundTrip()
+{
+    KLinesBlock block;
+    block.setInterval(MINUTE);
+
+    std::vector<KLinesBlock::KLineView> klines;
+    for (qint64 i = 0; i < 500; ++i)
+    {
+        // цена часто не меняется - проверка 1-битного кодирования
+        klines.push_back(makeKLine(START_TIME + i * MINUTE, 100.0 + (i / 7) * 0.5, 10.0 + i % 3));
+        block.append(klines.back());
+    }
+
+    QCOMPARE(block.count(), 500u);
+    QCOMPARE(block.firstOpenTime(), START_TIME);
+    QCOMPARE(block.lastOpenTime(), START_TIME + 499 * MINUTE);
+
+    const auto decoded = decode(block, START_TIME, START_TIME + 499 * MINUTE);
+    QCOMPARE(decoded.size(), klines.size());
+    for (std::size_t i = 0; i < klines.size(); ++i)
+    {
+        compareKLines(decoded[i], klines[i]);
+    }
+
+    block.shrink();
+    QVERIFY(block.memoryUsage() < static_cast<qsizetype>(klines.size() * sizeof(KLinesBlock::KLineView)));
+}
+
+void KLinesCodecTest::roundTripWithGaps()
+{
+    KLinesBlock block;
+    block.setInterval(MINUTE);
+
+    std::vector<KLinesBlock::KLineView> klines;
+    qint64 openTime = START_TIME;
+    for (qint64 i = 0; i < 100; ++i)
+    {
+        klines.push_back(makeKLine(openTime, 0.00001234 * (i + 1), 1e9 / (i + 1)));
+        block.append(klines.back());
+
+        openTime += (i % 10 == 0) ? 17 * MINUTE : MINUTE;
+    }
+
+    const auto decoded = decode(block, START_TIME, openTime);
+    QCOMPARE(decoded.size(), klines.size());
+    for (std::size_t i = 0; i < klines.size(); ++i)
+    {
+        compareKLines(decoded[i], klines[i]);
+    }
+}
+
+void KLinesCodecTest::rangeFilter()
+{
+    KLinesBlock block;
+    block.setInterval(MINUTE);
+
+    for (qint64 i = 0; i < 60; ++i)
+    {
+        block.append(makeKLine(START_TIME + i * MINUTE, 100.0, 1.0));
+    }
+
+    const auto decoded = decode(block, START_TIME + 10 * MINUTE, START_TIME + 19 * MINUTE);
+    QCOMPARE(decoded.size(), std::size_t(10));
+    QCOMPARE(decoded.front().openTime, START_TIME + 10 * MINUTE);
+    QCOMPARE(decoded.back().openTime, START_TIME + 19 * MINUTE);
+
+    QVERIFY(decode(block, START_TIME + 60 * MINUTE, START_TIME + 120 * MINUTE).empty());
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+//Qt
+#include <QObject>
+
+///////////////////////////////////////////////////////////////////////////////
+///     The KLinesCodecTest class - тесты сжатия блоков свечей KLinesBlock
+///
+class KLinesCodecTest final
+    : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void roundTrip();
+    void roundTripWithGaps();
+    void rangeFilter();
+
+};
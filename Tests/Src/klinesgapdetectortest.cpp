@@ -0,0 +1,118 @@
+//STL
+#include <initializer_list>
+
+//Qt
+#include <QTest>
+#include <QSignalSpy>
+
+//My
+#include "klinesgapdetector.h"
+#include "klinesgapdetectortest.h"
+
+using namespace TradingCatCommon;
+
+static const qint64 MINUTE = 60 * 1000;
+static const qint64 START_TIME = 1700000040000; // начало минуты в прошлом
+static const StockExchangeID STOCK_EXCHANGE_ID("GAP_DETECTOR");
+static const KLineID KLINE_ID("BTCUSDT", KLineType::MIN1);
+
+static PKLinesList makeKLines(std::initializer_list<qint64> openTimes)
+{
+    auto result = std::make_shared<KLinesList>();
+    for (const auto openTime: openTimes)
+    {
+        auto kline = std::make_shared<KLine>();
+        kline->id = KLINE_ID;
+        kline->openTime = openTime;
+        kline->closeTime = openTime + MINUTE - 1;
+
+        result->push_back(kline);
+    }
+
+    return result;
+}
+
+void KLinesGapDetectorTest::gapDetected()
+{
+    KLinesGapDetector detector;
+    QSignalSpy gapSpy(&detector, &KLinesGapDetector::gapDetected);
+
+    // первая свеча только задает ожидаемое время
+    detector.addKLines(STOCK_EXCHANGE_ID, makeKLines({START_TIME}));
+    detector.addKLines(STOCK_EXCHANGE_ID, makeKLines({START_TIME + MINUTE}));
+    QCOMPARE(gapSpy.count(), 0);
+
+    // пропущены 2-я и 3-я минуты
+    detector.addKLines(STOCK_EXCHANGE_ID, makeKLines({START_TIME + 4 * MINUTE}));
+    QCOMPARE(gapSpy.count(), 1);
+    QCOMPARE(gapSpy.last().at(0).value<StockExchangeID>(), STOCK_EXCHANGE_ID);
+    QCOMPARE(gapSpy.last().at(1).value<KLineID>(), KLINE_ID);
+    QCOMPARE(gapSpy.last().at(2).toLongLong(), START_TIME + 2 * MINUTE);
+    QCOMPARE(gapSpy.last().at(3).toLongLong(), START_TIME + 3 * MINUTE);
+
+    const auto metrics = detector.metrics();
+    QCOMPARE(metrics.gaps, quint64(1));
+    QCOMPARE(metrics.missedKLines, quint64(2));
+}
+
+void KLinesGapDetectorTest::updatesAndOlderKLinesIgnored()
+{
+    KLinesGapDetector detector;
+    QSignalSpy gapSpy(&detector, &KLinesGapDetector::gapDetected);
+
+    detector.addKLines(STOCK_EXCHANGE_ID, makeKLines({START_TIME, START_TIME + MINUTE}));
+
+    // повтор последней свечи и дозагруженная старая свеча пропуском не считаются
+    detector.addKLines(STOCK_EXCHANGE_ID, makeKLines({START_TIME + MINUTE, START_TIME - 10 * MINUTE}));
+    detector.addKLines(STOCK_EXCHANGE_ID, makeKLines({START_TIME + 2 * MINUTE}));
+
+    QCOMPARE(gapSpy.count(), 0);
+    QCOMPARE(detector.metrics().gaps, quint64(0));
+}
+
+void KLinesGapDetectorTest::longGapLimited()
+{
+    KLinesGapDetector detector;
+    QSignalSpy gapSpy(&detector, &KLinesGapDetector::gapDetected);
+
+    detector.addKLines(STOCK_EXCHANGE_ID, makeKLines({START_TIME}));
+    detector.addKLines(STOCK_EXCHANGE_ID, makeKLines({START_TIME + 5001 * MINUTE}));
+
+    // дозагружаются только последние 1000 пропущенных свечей, в метриках учитываются все
+    QCOMPARE(gapSpy.count(), 1);
+    QCOMPARE(gapSpy.last().at(2).toLongLong(), START_TIME + 4001 * MINUTE);
+    QCOMPARE(gapSpy.last().at(3).toLongLong(), START_TIME + 5000 * MINUTE);
+    QCOMPARE(detector.metrics().missedKLines, quint64(5000));
+}
+
+void KLinesGapDetectorTest::archiveSeedsExpectedOpenTime()
+{
+    KLinesGapDetector detector;
+    QSignalSpy gapSpy(&detector, &KLinesGapDetector::gapDetected);
+
+    // пропуски внутри архива не ищутся
+    detector.addArchiveKLines(STOCK_EXCHANGE_ID, makeKLines({START_TIME, START_TIME + 3 * MINUTE}));
+    QCOMPARE(gapSpy.count(), 0);
+
+    // простой между архивом и первой свечой биржи дозагружается
+    detector.addKLines(STOCK_EXCHANGE_ID, makeKLines({START_TIME + 6 * MINUTE}));
+    QCOMPARE(gapSpy.count(), 1);
+    QCOMPARE(gapSpy.last().at(2).toLongLong(), START_TIME + 4 * MINUTE);
+    QCOMPARE(gapSpy.last().at(3).toLongLong(), START_TIME + 5 * MINUTE);
+}
+
+void KLinesGapDetectorTest::resetForgetsExpectedOpenTime()
+{
+    KLinesGapDetector detector;
+    QSignalSpy gapSpy(&detector, &KLinesGapDetector::gapDetected);
+
+    detector.addKLines(STOCK_EXCHANGE_ID, makeKLines({START_TIME}));
+    detector.reset();
+
+    // после перезапуска коннектора первая свеча снова только задает ожидаемое время
+    detector.addKLines(STOCK_EXCHANGE_ID, makeKLines({START_TIME + 10 * MINUTE}));
+    QCOMPARE(gapSpy.count(), 0);
+
+    detector.addKLines(STOCK_EXCHANGE_ID, makeKLines({START_TIME + 12 * MINUTE}));
+    QCOMPARE(gapSpy.count(), 1);
+}
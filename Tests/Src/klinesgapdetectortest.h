@@ -0,0 +1,21 @@
+#pragma once
+
+//Qt
+#include <QObject>
+
+///////////////////////////////////////////////////////////////////////////////
+///     The KLinesGapDetectorTest class - тесты поиска пропущенных свечей
+///
+class KLinesGapDetectorTest final
+    : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void gapDetected();
+    void updatesAndOlderKLinesIgnored();
+    void longGapLimited();
+    void archiveSeedsExpectedOpenTime();
+    void resetForgetsExpectedOpenTime();
+
+};
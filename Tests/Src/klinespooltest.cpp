@@ -0,0 +1,63 @@
+//STL
+#include <vector>
+
+//Qt
+#include <QTest>
+#include <QThread>
+
+//My
+#include "klinespool.h"
+#include "klinespooltest.h"
+
+using namespace TradingCatCommon;
+
+static const std::size_t MAX_LIVE_KLINES = 2 * 64 * 1024; // больше емкости пула потока
+
+void KLinesPoolTest::nodeReusedInSameThread()
+{
+    KLine source;
+    source.openTime = 60000;
+    source.close = 1.5;
+
+    auto kline = KLinesPool::make(source);
+    QCOMPARE(kline->openTime, qint64(60000));
+    QCOMPARE(kline->close, 1.5);
+
+    const auto address = kline.get();
+    const auto reused = KLinesPool::statistic().reused;
+    kline.reset();
+
+    kline = KLinesPool::make();
+    QCOMPARE(kline.get(), address);
+    QVERIFY(KLinesPool::statistic().reused > reused);
+}
+
+void KLinesPoolTest::nodeReturnedFromOtherThread()
+{
+    auto kline = KLinesPool::make();
+    const auto address = kline.get();
+    const auto returned = KLinesPool::statistic().returned;
+
+    // свеча освобождается в другом потоке - узел уходит в пул текущего потока
+    QThread* thread = QThread::create(
+        [kline = std::move(kline)]() mutable
+        {
+            kline.reset();
+        });
+    thread->start();
+    QVERIFY(thread->wait());
+    delete thread;
+
+    QCOMPARE(KLinesPool::statistic().returned, returned + 1);
+
+    // когда свободные узлы потока заканчиваются, возвращенный узел выдается повторно
+    std::vector<PKLine> klines;
+    bool isReturnedReused = false;
+    while (!isReturnedReused && klines.size() < MAX_LIVE_KLINES)
+    {
+        klines.push_back(KLinesPool::make());
+        isReturnedReused = klines.back().get() == address;
+    }
+
+    QVERIFY(isReturnedReused);
+}
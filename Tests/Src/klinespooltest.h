@@ -0,0 +1,18 @@
+#pragma once
+
+//Qt
+#include <QObject>
+
+///////////////////////////////////////////////////////////////////////////////
+///     The KLinesPoolTest class - тесты повторного использования узлов пула свечей
+///
+class KLinesPoolTest final
+    : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void nodeReusedInSameThread();
+    void nodeReturnedFromOtherThread();
+
+};
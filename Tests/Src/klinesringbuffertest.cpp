@@ -0,0 +1,138 @@
+//Qt
+#include <QTest>
+
+//My
+#include "klinesringbuffer.h"
+#include "klinesringbuffertest.h"
+
+using namespace TradingCatCommon;
+
+static const qint64 MINUTE = 60 * 1000;
+static const qint64 START_TIME = 1700000100000;
+
+static KLine makeKLine(qint64 index, double price = 100.0)
+{
+    KLine kline;
+    kline.id = KLineID("BTCUSDT", KLineType::MIN1);
+    kline.openTime = START_TIME + index * MINUTE;
+    kline.closeTime = kline.openTime + MINUTE - 1;
+    kline.open = price;
+    kline.high = price;
+    kline.low = price;
+    kline.close = price;
+    kline.volume = 1.0;
+    kline.quoteAssetVolume = price;
+
+    return kline;
+}
+
+static std::vector<qint64> openTimes(const KLinesRingBuffer& buffer)
+{
+    std::vector<qint64> result;
+    for (qsizetype index = 0; index < buffer.size(); ++index)
+    {
+        result.push_back((buffer.at(index).openTime - START_TIME) / MINUTE);
+    }
+
+    return result;
+}
+
+void KLinesRingBufferTest::appendAndUpdate()
+{
+    KLinesRingBuffer buffer(10, MINUTE);
+
+    QVERIFY(buffer.empty());
+    QVERIFY(buffer.push(makeKLine(0)));
+    QVERIFY(buffer.push(makeKLine(1)));
+
+    // обновление незакрытой свечи
+    QVERIFY(buffer.push(makeKLine(1, 105.0)));
+
+    QCOMPARE(buffer.size(), 2);
+    QCOMPARE(buffer.back().close, 105.0);
+    QCOMPARE(buffer.back().closeTime, START_TIME + 2 * MINUTE - 1);
+}
+
+void KLinesRingBufferTest::overwriteOldest()
+{
+    KLinesRingBuffer buffer(3, MINUTE);
+
+    for (qint64 index = 0; index < 5; ++index)
+    {
+        QVERIFY(buffer.push(makeKLine(index)));
+    }
+
+    QCOMPARE(buffer.size(), 3);
+    QCOMPARE(openTimes(buffer), (std::vector<qint64>{2, 3, 4}));
+
+    // свеча старше самой старой игнорируется
+    QVERIFY(!buffer.push(makeKLine(1)));
+    QCOMPARE(openTimes(buffer), (std::vector<qint64>{2, 3, 4}));
+}
+
+void KLinesRingBufferTest::insertMissed()
+{
+    KLinesRingBuffer buffer(10, MINUTE);
+
+    for (const qint64 index: {0, 1, 4, 5})
+    {
+        QVERIFY(buffer.push(makeKLine(index)));
+    }
+
+    QVERIFY(buffer.push(makeKLine(3)));
+    QVERIFY(buffer.push(makeKLine(2)));
+
+    QCOMPARE(openTimes(buffer), (std::vector<qint64>{0, 1, 2, 3, 4, 5}));
+
+    std::vector<qint64> range;
+    buffer.forEach(START_TIME + 2 * MINUTE, START_TIME + 4 * MINUTE,
+        [&range](const KLinesRingBuffer::KLineView& kline)
+        {
+            range.push_back((kline.openTime - START_TIME) / MINUTE);
+        });
+    QCOMPARE(range, (std::vector<qint64>{2, 3, 4}));
+}
+
+void KLinesRingBufferTest::isEvicting()
+{
+    KLinesRingBuffer buffer(3, MINUTE);
+
+    for (const qint64 index: {0, 2})
+    {
+        QVERIFY(!buffer.isEvicting(START_TIME + index * MINUTE));
+        buffer.push(makeKLine(index));
+    }
+    QVERIFY(!buffer.isEvicting(START_TIME + 3 * MINUTE));
+    buffer.push(makeKLine(3));
+
+    // буфер заполнен: новая свеча и дозагруженная свеча вытесняют самую старую, обновление - нет
+    QVERIFY(buffer.isEvicting(START_TIME + 4 * MINUTE));
+    QVERIFY(buffer.isEvicting(START_TIME + 1 * MINUTE));
+    QVERIFY(!buffer.isEvicting(START_TIME + 3 * MINUTE));
+    QVERIFY(!buffer.isEvicting(START_TIME - MINUTE));
+
+    // дозагруженная свеча в заполненном буфере вытесняет самую старую
+    QVERIFY(buffer.push(makeKLine(1)));
+    QCOMPARE(openTimes(buffer), (std::vector<qint64>{1, 2, 3}));
+}
+
+void KLinesRingBufferTest::setCapacity()
+{
+    KLinesRingBuffer buffer(5, MINUTE);
+
+    for (qint64 index = 0; index < 7; ++index)
+    {
+        buffer.push(makeKLine(index));
+    }
+
+    buffer.setCapacity(2);
+    QCOMPARE(buffer.capacity(), 2);
+    QCOMPARE(openTimes(buffer), (std::vector<qint64>{5, 6}));
+
+    // емкость не увеличивается
+    buffer.setCapacity(5);
+    QCOMPARE(buffer.capacity(), 2);
+
+    buffer.push(makeKLine(7));
+    QCOMPARE(openTimes(buffer), (std::vector<qint64>{6, 7}));
+}
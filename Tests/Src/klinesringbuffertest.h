@@ -0,0 +1,21 @@
+#pragma once
+
+//Qt
+#include <QObject>
+
+///////////////////////////////////////////////////////////////////////////////
+///     The KLinesRingBufferTest class - тесты кольцевого буфера свечей
+///
+class KLinesRingBufferTest final
+    : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void appendAndUpdate();
+    void overwriteOldest();
+    void insertMissed();
+    void isEvicting();
+    void setCapacity();
+
+};
@@ -0,0 +1,217 @@
+//Qt
+#include <QTest>
+#include <QSignalSpy>
+#include <QWebSocketServer>
+#include <QWebSocket>
+#include <QHostAddress>
+#include <QDateTime>
+
+//My
+#include "klinesstream.h"
+#include "klinesstreamtest.h"
+
+using namespace TradingCatCommon;
+
+static const qint64 MINUTE = 60 * 1000;
+static const qint64 START_TIME = 1700000100000; // закрытая минутная свеча в прошлом
+static const QString SYMBOL = "BTCUSDT";
+static const StockExchangeID STOCK_EXCHANGE_ID("TEST");
+static const int WAIT_TIMEOUT = 5000;
+
+static QString klineMessage(qint64 openTime, bool isClosed)
+{
+    return QString(R"({"stream":"btcusdt@kline_1m","data":{"e":"kline","E":%1,"s":"BTCUSDT","k":{"t":%2,"T":%3,"s":"BTCUSDT","i":"1m",)"
+                   R"("o":"100.5","c":"101.5","h":"102.5","l":"99.5","v":"10","q":"1010","x":%4}}})")
+        .arg(openTime + MINUTE)
+        .arg(openTime)
+        .arg(openTime + MINUTE - 1)
+        .arg(isClosed ? "true" : "false");
+}
+
+static PKLinesList makeKLines(qint64 openTime, qint64 closeTime)
+{
+    auto kline = std::make_shared<KLine>();
+    kline->id = KLineID(SYMBOL, KLineType::MIN1);
+    kline->openTime = openTime;
+    kline->closeTime = closeTime;
+    kline->open = 100.5;
+    kline->high = 102.5;
+    kline->low = 99.5;
+    kline->close = 101.5;
+    kline->volume = 10.0;
+    kline->quoteAssetVolume = 1010.0;
+
+    auto result = std::make_shared<KLinesList>();
+    result->push_back(kline);
+
+    return result;
+}
+
+static PKLinesIDList makeKLinesID(const QStringList& symbols = {SYMBOL})
+{
+    auto result = std::make_shared<KLinesIDList>();
+    for (const auto& symbol: symbols)
+    {
+        result->emplace(symbol, KLineType::MIN1);
+    }
+
+    return result;
+}
+
+void KLinesStreamTest::streamName()
+{
+    QCOMPARE(KLinesStream::streamName(KLineID(SYMBOL, KLineType::MIN1)), QString("btcusdt@kline_1m"));
+    QCOMPARE(KLinesStream::streamName(KLineID(SYMBOL, KLineType::MIN5)), QString("btcusdt@kline_5m"));
+    QCOMPARE(KLinesStream::streamName(KLineID(SYMBOL, static_cast<KLineType>(15 * MINUTE))), QString("btcusdt@kline_15m"));
+    QCOMPARE(KLinesStream::streamName(KLineID(SYMBOL, static_cast<KLineType>(60 * MINUTE))), QString("btcusdt@kline_1h"));
+    QCOMPARE(KLinesStream::streamName(KLineID(SYMBOL, static_cast<KLineType>(24 * 60 * MINUTE))), QString("btcusdt@kline_1d"));
+    QCOMPARE(KLinesStream::streamName(KLineID(SYMBOL, KLineType::WEEK1)), QString("btcusdt@kline_1w"));
+
+    // у Binance нет потока 10m - свеча обновляется только REST-опросом
+    QVERIFY(KLinesStream::streamName(KLineID(SYMBOL, static_cast<KLineType>(10 * MINUTE))).isEmpty());
+}
+
+void KLinesStreamTest::subscribeAndReceiveClosedKLine()
+{
+    QWebSocketServer server("test", QWebSocketServer::NonSecureMode);
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    StreamProxyPool streamProxyPool{Common::ProxyList{}};
+    KLinesStream stream(STOCK_EXCHANGE_ID, server.serverUrl(), streamProxyPool);
+    QSignalSpy klinesSpy(&stream, &KLinesStream::getKLines);
+
+    stream.addKLinesID(STOCK_EXCHANGE_ID, makeKLinesID());
+    stream.start();
+
+    QTRY_VERIFY_WITH_TIMEOUT(server.hasPendingConnections(), WAIT_TIMEOUT);
+    std::unique_ptr<QWebSocket> client(server.nextPendingConnection());
+    QSignalSpy messageSpy(client.get(), &QWebSocket::textMessageReceived);
+
+    QTRY_COMPARE_WITH_TIMEOUT(messageSpy.count(), 1, WAIT_TIMEOUT);
+    const auto request = messageSpy.first().at(0).toString();
+    QVERIFY(request.contains("\"method\":\"SUBSCRIBE\""));
+    QVERIFY(request.contains("btcusdt@kline_1m"));
+
+    // незакрытая свеча потоком не передается
+    client->sendTextMessage(klineMessage(START_TIME, false));
+    client->sendTextMessage(klineMessage(START_TIME, true));
+
+    QTRY_COMPARE_WITH_TIMEOUT(klinesSpy.count(), 1, WAIT_TIMEOUT);
+    const auto klines = klinesSpy.first().at(1).value<PKLinesList>();
+    QCOMPARE(klines->size(), std::size_t(1));
+
+    const auto& kline = *klines->front();
+    QCOMPARE(kline.id, KLineID(SYMBOL, KLineType::MIN1));
+    QCOMPARE(kline.openTime, START_TIME);
+    QCOMPARE(kline.closeTime, START_TIME + MINUTE - 1);
+    QCOMPARE(kline.open, 100.5);
+    QCOMPARE(kline.close, 101.5);
+    QCOMPARE(kline.quoteAssetVolume, 1010.0);
+
+    // повтор закрытой свечи отбрасывается
+    client->sendTextMessage(klineMessage(START_TIME, true));
+    client->sendTextMessage(klineMessage(START_TIME + MINUTE, true));
+
+    QTRY_COMPARE_WITH_TIMEOUT(klinesSpy.count(), 2, WAIT_TIMEOUT);
+    const auto nextKLines = klinesSpy.last().at(1).value<PKLinesList>();
+    QCOMPARE(nextKLines->size(), std::size_t(1));
+    QCOMPARE(nextKLines->front()->openTime, START_TIME + MINUTE);
+
+    // свеча REST-опроса, уже полученная потоком, дальше не передается
+    stream.addKLines(STOCK_EXCHANGE_ID, makeKLines(START_TIME, START_TIME + MINUTE - 1));
+    QCOMPARE(klinesSpy.count(), 2);
+
+    // бинарные сообщения разбираются так же, как текстовые
+    client->sendBinaryMessage(klineMessage(START_TIME + 2 * MINUTE, true).toUtf8());
+
+    QTRY_COMPARE_WITH_TIMEOUT(klinesSpy.count(), 3, WAIT_TIMEOUT);
+    QCOMPARE(klinesSpy.last().at(1).value<PKLinesList>()->front()->openTime, START_TIME + 2 * MINUTE);
+
+    stream.stop();
+}
+
+void KLinesStreamTest::restKLinesDeduplicated()
+{
+    StreamProxyPool streamProxyPool{Common::ProxyList{}};
+    KLinesStream stream(STOCK_EXCHANGE_ID, QUrl("ws://localhost:1"), streamProxyPool);
+    QSignalSpy klinesSpy(&stream, &KLinesStream::getKLines);
+
+    // закрытая свеча передается один раз
+    stream.addKLines(STOCK_EXCHANGE_ID, makeKLines(START_TIME, START_TIME + MINUTE - 1));
+    stream.addKLines(STOCK_EXCHANGE_ID, makeKLines(START_TIME, START_TIME + MINUTE - 1));
+    QCOMPARE(klinesSpy.count(), 1);
+
+    // незакрытая свеча передается при каждом опросе
+    const auto openTime = QDateTime::currentMSecsSinceEpoch() / MINUTE * MINUTE;
+    stream.addKLines(STOCK_EXCHANGE_ID, makeKLines(openTime, openTime + MINUTE - 1));
+    stream.addKLines(STOCK_EXCHANGE_ID, makeKLines(openTime, openTime + MINUTE - 1));
+    QCOMPARE(klinesSpy.count(), 3);
+
+    // более старая закрытая свеча (дозагрузка пропуска) не считается повтором
+    stream.addKLines(STOCK_EXCHANGE_ID, makeKLines(START_TIME - MINUTE, START_TIME - 1));
+    QCOMPARE(klinesSpy.count(), 4);
+}
+
+void KLinesStreamTest::removedKLinesUnsubscribed()
+{
+    QWebSocketServer server("test", QWebSocketServer::NonSecureMode);
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    StreamProxyPool streamProxyPool{Common::ProxyList{}};
+    KLinesStream stream(STOCK_EXCHANGE_ID, server.serverUrl(), streamProxyPool);
+
+    stream.addKLinesID(STOCK_EXCHANGE_ID, makeKLinesID({SYMBOL, "ETHUSDT"}));
+    stream.start();
+
+    QTRY_VERIFY_WITH_TIMEOUT(server.hasPendingConnections(), WAIT_TIMEOUT);
+    std::unique_ptr<QWebSocket> client(server.nextPendingConnection());
+    QSignalSpy messageSpy(client.get(), &QWebSocket::textMessageReceived);
+
+    QTRY_COMPARE_WITH_TIMEOUT(messageSpy.count(), 1, WAIT_TIMEOUT);
+    QVERIFY(messageSpy.first().at(0).toString().contains("ethusdt@kline_1m"));
+
+    // свечи нет в новом списке биржи - подписка снимается
+    stream.addKLinesID(STOCK_EXCHANGE_ID, makeKLinesID());
+
+    QTRY_COMPARE_WITH_TIMEOUT(messageSpy.count(), 2, WAIT_TIMEOUT);
+    const auto request = messageSpy.last().at(0).toString();
+    QVERIFY(request.contains("\"method\":\"UNSUBSCRIBE\""));
+    QVERIFY(request.contains("ethusdt@kline_1m"));
+    QVERIFY(!request.contains("btcusdt@kline_1m"));
+
+    stream.stop();
+}
+
+void KLinesStreamTest::unsubscribedWithoutDemand()
+{
+    QWebSocketServer server("test", QWebSocketServer::NonSecureMode);
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    StreamProxyPool streamProxyPool{Common::ProxyList{}};
+    KLinesStream stream(STOCK_EXCHANGE_ID, server.serverUrl(), streamProxyPool);
+
+    stream.addKLinesID(STOCK_EXCHANGE_ID, makeKLinesID());
+    stream.start();
+
+    QTRY_VERIFY_WITH_TIMEOUT(server.hasPendingConnections(), WAIT_TIMEOUT);
+    std::unique_ptr<QWebSocket> client(server.nextPendingConnection());
+    QSignalSpy messageSpy(client.get(), &QWebSocket::textMessageReceived);
+
+    QTRY_COMPARE_WITH_TIMEOUT(messageSpy.count(), 1, WAIT_TIMEOUT);
+
+    // сессий с фильтрами нет - все подписки снимаются
+    stream.setDemanded(false);
+
+    QTRY_COMPARE_WITH_TIMEOUT(messageSpy.count(), 2, WAIT_TIMEOUT);
+    QVERIFY(messageSpy.last().at(0).toString().contains("\"method\":\"UNSUBSCRIBE\""));
+    QVERIFY(messageSpy.last().at(0).toString().contains("btcusdt@kline_1m"));
+
+    // спрос появился - подписка восстанавливается
+    stream.setDemanded(true);
+
+    QTRY_COMPARE_WITH_TIMEOUT(messageSpy.count(), 3, WAIT_TIMEOUT);
+    QVERIFY(messageSpy.last().at(0).toString().contains("\"method\":\"SUBSCRIBE\""));
+    QVERIFY(messageSpy.last().at(0).toString().contains("btcusdt@kline_1m"));
+
+    stream.stop();
+}
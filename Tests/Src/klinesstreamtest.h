@@ -0,0 +1,21 @@
+#pragma once
+
+//Qt
+#include <QObject>
+
+///////////////////////////////////////////////////////////////////////////////
+///     The KLinesStreamTest class - тесты WebSocket-потока свечей на локальном сервере
+///
+class KLinesStreamTest final
+    : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void streamName();
+    void subscribeAndReceiveClosedKLine();
+    void restKLinesDeduplicated();
+    void removedKLinesUnsubscribed();
+    void unsubscribedWithoutDemand();
+
+};
@@ -0,0 +1,103 @@
+//Qt
+#include <QTest>
+#include <QDateTime>
+
+//My
+#include "latencytracer.h"
+#include "latencytracertest.h"
+
+using namespace TradingCatCommon;
+
+static const qint64 MINUTE = 60 * 1000;
+static const qint64 START_TIME = 1700000100000; // закрытые свечи в прошлом
+static const QString SYMBOL = "BTCUSDT";
+static const StockExchangeID STOCK_EXCHANGE_ID("TEST");
+
+static PKLine makeKLine(qint64 openTime)
+{
+    auto kline = std::make_shared<KLine>();
+    kline->id = KLineID(SYMBOL, KLineType::MIN1);
+    kline->openTime = openTime;
+    kline->closeTime = openTime + MINUTE - 1;
+    kline->open = 100.0;
+    kline->high = 101.0;
+    kline->low = 99.0;
+    kline->close = 100.0;
+    kline->volume = 1.0;
+    kline->quoteAssetVolume = 100.0;
+
+    return kline;
+}
+
+static quint64 receiveCount(const LatencyTracer& tracer)
+{
+    const auto statistic = tracer.statistic();
+
+    return statistic.empty() ? 0 : statistic.front().hops[static_cast<qsizetype>(LatencyTracer::Hop::RECEIVE)].count;
+}
+
+void LatencyTracerTest::histogramPercentile()
+{
+    LatencyTracer::Histogram histogram;
+    QCOMPARE(histogram.percentile(0.5), qint64(0));
+    QCOMPARE(histogram.average(), qint64(0));
+
+    histogram.add(50);
+    histogram.add(200);
+    histogram.add(200);
+    histogram.add(4000);
+
+    QCOMPARE(histogram.count, quint64(4));
+    QCOMPARE(histogram.counts[0], quint64(1));
+    QCOMPARE(histogram.counts[1], quint64(2));
+    QCOMPARE(histogram.counts[5], quint64(1));
+    QCOMPARE(histogram.max, qint64(4000));
+    QCOMPARE(histogram.average(), qint64(1112));
+
+    // оценка по верхней границе интервала, но не больше максимума
+    QCOMPARE(histogram.percentile(0.25), qint64(100));
+    QCOMPARE(histogram.percentile(0.5), qint64(250));
+    QCOMPARE(histogram.percentile(1.0), qint64(4000));
+}
+
+void LatencyTracerTest::histogramOverflow()
+{
+    LatencyTracer::Histogram histogram;
+    histogram.add(10);
+    histogram.add(400000);
+
+    QCOMPARE(histogram.counts[LatencyTracer::BUCKETS_COUNT - 1], quint64(1));
+    QCOMPARE(histogram.percentile(0.5), qint64(100));
+    QCOMPARE(histogram.percentile(0.99), qint64(400000));
+}
+
+void LatencyTracerTest::firstObservationOnly()
+{
+    LatencyTracer tracer;
+
+    // история при запуске и незакрытая свеча не учитываются
+    KLinesList history;
+    for (qint64 i = 0; i < 3; ++i)
+    {
+        history.push_back(makeKLine(START_TIME + i * MINUTE));
+    }
+    history.push_back(makeKLine(QDateTime::currentMSecsSinceEpoch()));
+    tracer.addKLines(LatencyTracer::Hop::RECEIVE, STOCK_EXCHANGE_ID, history);
+    QCOMPARE(receiveCount(tracer), quint64(0));
+
+    tracer.addKLines(LatencyTracer::Hop::RECEIVE, STOCK_EXCHANGE_ID, {makeKLine(START_TIME + 3 * MINUTE)});
+    QCOMPARE(receiveCount(tracer), quint64(1));
+
+    // повторный опрос той же свечи и дозагрузка пропуска
+    tracer.addKLines(LatencyTracer::Hop::RECEIVE, STOCK_EXCHANGE_ID, {makeKLine(START_TIME + 3 * MINUTE)});
+    tracer.addKLines(LatencyTracer::Hop::RECEIVE, STOCK_EXCHANGE_ID, {makeKLine(START_TIME + MINUTE)});
+    QCOMPARE(receiveCount(tracer), quint64(1));
+
+    tracer.addKLines(LatencyTracer::Hop::RECEIVE, STOCK_EXCHANGE_ID, {makeKLine(START_TIME + 4 * MINUTE), makeKLine(START_TIME + 5 * MINUTE)});
+    QCOMPARE(receiveCount(tracer), quint64(3));
+
+    // на другом этапе свечи учитываются отдельно
+    const auto statistic = tracer.statistic();
+    QCOMPARE(statistic.size(), std::size_t(1));
+    QCOMPARE(statistic.front().hops[static_cast<qsizetype>(LatencyTracer::Hop::DETECTOR)].count, quint64(0));
+}
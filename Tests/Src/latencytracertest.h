@@ -0,0 +1,19 @@
+#pragma once
+
+//Qt
+#include <QObject>
+
+///////////////////////////////////////////////////////////////////////////////
+///     The LatencyTracerTest class - тесты гистограмм задержки и учета свечей по этапам
+///
+class LatencyTracerTest final
+    : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void histogramPercentile();
+    void histogramOverflow();
+    void firstObservationOnly();
+
+};
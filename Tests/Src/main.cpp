@@ -0,0 +1,80 @@
+//Qt
+#include <QCoreApplication>
+#include <QTest>
+
+//My
+#include "backfillpacertest.h"
+#include "demandtrackertest.h"
+#include "detecteventstest.h"
+#include "idinternertest.h"
+#include "jsontokenizertest.h"
+#include "klinesaggregatortest.h"
+#include "klinesarchivetest.h"
+#include "klinescodectest.h"
+#include "klinesgapdetectortest.h"
+#include "klinespooltest.h"
+#include "klinesringbuffertest.h"
+#include "klinesstreamtest.h"
+#include "latencytracertest.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    int result = 0;
+
+    {
+        BackfillPacerTest test;
+        result |= QTest::qExec(&test, argc, argv);
+    }
+    {
+        DemandTrackerTest test;
+        result |= QTest::qExec(&test, argc, argv);
+    }
+    {
+        DetectEventsTest test;
+        result |= QTest::qExec(&test, argc, argv);
+    }
+    {
+        IDInternerTest test;
+        result |= QTest::qExec(&test, argc, argv);
+    }
+    {
+        JsonTokenizerTest test;
+        result |= QTest::qExec(&test, argc, argv);
+    }
+    {
+        KLinesAggregatorTest test;
+        result |= QTest::qExec(&test, argc, argv);
+    }
+    {
+        KLinesArchiveTest test;
+        result |= QTest::qExec(&test, argc, argv);
+    }
+    {
+        KLinesCodecTest test;
+        result |= QTest::qExec(&test, argc, argv);
+    }
+    {
+        KLinesGapDetectorTest test;
+        result |= QTest::qExec(&test, argc, argv);
+    }
+    {
+        KLinesPoolTest test;
+        result |= QTest::qExec(&test, argc, argv);
+    }
+    {
+        KLinesRingBufferTest test;
+        result |= QTest::qExec(&test, argc, argv);
+    }
+    {
+        KLinesStreamTest test;
+        result |= QTest::qExec(&test, argc, argv);
+    }
+    {
+        LatencyTracerTest test;
+        result |= QTest::qExec(&test, argc, argv);
+    }
+
+    return result;
+}
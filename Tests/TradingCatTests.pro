@@ -0,0 +1,76 @@
+QT = core network websockets testlib
+
+TARGET = TradingCatTests
+TEMPLATE = app
+
+CONFIG += c++20 cmdline testcase
+CONFIG += static
+
+VERSION = 0.1
+
+INCLUDEPATH += $$PWD/../Src
+
+HEADERS += \
+    $$PWD/../Src/backfillpacer.h \
+    $$PWD/../Src/demandtracker.h \
+    $$PWD/../Src/detectevents.h \
+    $$PWD/../Src/idinterner.h \
+    $$PWD/../Src/jsontokenizer.h \
+    $$PWD/../Src/klinesaggregator.h \
+    $$PWD/../Src/klinesarchive.h \
+    $$PWD/../Src/klinescodec.h \
+    $$PWD/../Src/klinesgapdetector.h \
+    $$PWD/../Src/klinespool.h \
+    $$PWD/../Src/klinesringbuffer.h \
+    $$PWD/../Src/klinesstore.h \
+    $$PWD/../Src/klinesstream.h \
+    $$PWD/../Src/latencytracer.h \
+    $$PWD/../Src/streamproxypool.h \
+    $$PWD/Src/backfillpacertest.h \
+    $$PWD/Src/demandtrackertest.h \
+    $$PWD/Src/detecteventstest.h \
+    $$PWD/Src/idinternertest.h \
+    $$PWD/Src/jsontokenizertest.h \
+    $$PWD/Src/klinesaggregatortest.h \
+    $$PWD/Src/klinesarchivetest.h \
+    $$PWD/Src/klinescodectest.h \
+    $$PWD/Src/klinesgapdetectortest.h \
+    $$PWD/Src/klinespooltest.h \
+    $$PWD/Src/klinesringbuffertest.h \
+    $$PWD/Src/klinesstreamtest.h \
+    $$PWD/Src/latencytracertest.h
+
+SOURCES += \
+    $$PWD/../Src/backfillpacer.cpp \
+    $$PWD/../Src/demandtracker.cpp \
+    $$PWD/../Src/detectevents.cpp \
+    $$PWD/../Src/idinterner.cpp \
+    $$PWD/../Src/jsontokenizer.cpp \
+    $$PWD/../Src/klinesaggregator.cpp \
+    $$PWD/../Src/klinesarchive.cpp \
+    $$PWD/../Src/klinescodec.cpp \
+    $$PWD/../Src/klinesgapdetector.cpp \
+    $$PWD/../Src/klinespool.cpp \
+    $$PWD/../Src/klinesringbuffer.cpp \
+    $$PWD/../Src/klinesstore.cpp \
+    $$PWD/../Src/klinesstream.cpp \
+    $$PWD/../Src/latencytracer.cpp \
+    $$PWD/../Src/streamproxypool.cpp \
+    $$PWD/Src/backfillpacertest.cpp \
+    $$PWD/Src/demandtrackertest.cpp \
+    $$PWD/Src/detecteventstest.cpp \
+    $$PWD/Src/idinternertest.cpp \
+    $$PWD/Src/jsontokenizertest.cpp \
+    $$PWD/Src/klinesaggregatortest.cpp \
+    $$PWD/Src/klinesarchivetest.cpp \
+    $$PWD/Src/klinescodectest.cpp \
+    $$PWD/Src/klinesgapdetectortest.cpp \
+    $$PWD/Src/klinespooltest.cpp \
+    $$PWD/Src/klinesringbuffertest.cpp \
+    $$PWD/Src/klinesstreamtest.cpp \
+    $$PWD/Src/latencytracertest.cpp \
+    $$PWD/Src/main.cpp
+
+#inlude addition library
+include($$PWD/../../../Common/Common/Common.pri)
+include($$PWD/../../TradingCatCommon/TradingCatCommon.pri)
@@ -1,6 +1,6 @@
 # for use valgrid: export LIBGL_ALWAYS_SOFTWARE=1
 # for use perf: sudo sysctl -w kernel.perf_event_paranoid=1
-QT = core network sql httpserver
+QT = core network sql httpserver websockets
 
 TARGET = TradingCat
 TEMPLATE = app
@@ -12,16 +12,58 @@ VERSION = 0.2
 
 HEADERS += \
     $$PWD/Src/appserver.h \
+    $$PWD/Src/backfillpacer.h \
     $$PWD/Src/config.h \
     $$PWD/Src/core.h \
+    $$PWD/Src/demandtracker.h \
+    $$PWD/Src/detectevents.h \
+    $$PWD/Src/idinterner.h \
+    $$PWD/Src/jsontokenizer.h \
+    $$PWD/Src/klinesaggregator.h \
+    $$PWD/Src/klinesarchive.h \
+    $$PWD/Src/klinescodec.h \
+    $$PWD/Src/klinesgapdetector.h \
+    $$PWD/Src/klinespool.h \
+    $$PWD/Src/klinesqueue.h \
+    $$PWD/Src/klinesrecorder.h \
+    $$PWD/Src/klinesreplay.h \
+    $$PWD/Src/klinesringbuffer.h \
+    $$PWD/Src/klinesstore.h \
+    $$PWD/Src/klinesstream.h \
+    $$PWD/Src/latencytracer.h \
+    $$PWD/Src/serverprotocol.h \
+    $$PWD/Src/stockexchangemonitor.h \
+    $$PWD/Src/streamproxypool.h \
+    $$PWD/Src/tradingdatasnapshot.h \
     $$PWD/Src/userscore.h \
     $$PWD/Src/usersdata.h
 
 SOURCES += \
     $$PWD/Src/appserver.cpp \
+    $$PWD/Src/backfillpacer.cpp \
     $$PWD/Src/config.cpp \
     $$PWD/Src/core.cpp \
+    $$PWD/Src/demandtracker.cpp \
+    $$PWD/Src/detectevents.cpp \
+    $$PWD/Src/idinterner.cpp \
+    $$PWD/Src/jsontokenizer.cpp \
+    $$PWD/Src/klinesaggregator.cpp \
+    $$PWD/Src/klinesarchive.cpp \
+    $$PWD/Src/klinescodec.cpp \
+    $$PWD/Src/klinesgapdetector.cpp \
+    $$PWD/Src/klinespool.cpp \
+    $$PWD/Src/klinesqueue.cpp \
+    $$PWD/Src/klinesrecorder.cpp \
+    $$PWD/Src/klinesreplay.cpp \
+    $$PWD/Src/klinesringbuffer.cpp \
+    $$PWD/Src/klinesstore.cpp \
+    $$PWD/Src/klinesstream.cpp \
+    $$PWD/Src/latencytracer.cpp \
     $$PWD/Src/main.cpp \
+    $$PWD/Src/serverprotocol.cpp \
+    $$PWD/Src/stockexchangemonitor.cpp \
+    $$PWD/Src/streamproxypool.cpp \
+    $$PWD/Src/tradingdatasnapshot.cpp \
     $$PWD/Src/userscore.cpp \
     $$PWD/Src/usersdata.cpp
 